@@ -0,0 +1,42 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Server/LoadTest.h"
+#include "Server/Sockets.h"
+
+// chess_loadtest [host] [port] [clients] [seconds] [options]
+//   ws           talk websocket
+//   engine N     every client plays the engine at N nodes
+//   think MS     wait MS before answering a move
+int main(int argc, char **argv) {
+	LoadTestOptions options;
+	std::vector<std::string> positional;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "ws")
+			options.webSocket = true;
+		else if (arg == "engine" && i + 1 < argc)
+			options.engineNodes = std::stoull(argv[++i]);
+		else if (arg == "think" && i + 1 < argc)
+			options.thinkMs = std::stoi(argv[++i]);
+		else
+			positional.push_back(arg);
+	}
+	if (positional.size() > 4) {
+		std::cout << "unknown argument " << positional[4] << std::endl;
+		return 1;
+	}
+	if (positional.size() > 0)
+		options.host = positional[0];
+	if (positional.size() > 1)
+		options.port = (uint16_t) std::stoi(positional[1]);
+	if (positional.size() > 2)
+		options.clients = std::stoi(positional[2]);
+	if (positional.size() > 3)
+		options.seconds = std::stoi(positional[3]);
+
+	Sockets::RaiseOpenFileLimit();
+	LoadTest test(options);
+	return test.Run() ? 0 : 1;
+}
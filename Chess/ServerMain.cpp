@@ -0,0 +1,36 @@
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "Server/GameServer.h"
+#include "Server/Sockets.h"
+
+namespace
+{
+	GameServer *s_Server = nullptr;
+
+	void OnSignal(int) {
+		if (s_Server)
+			s_Server->Stop();
+	}
+} // namespace
+
+// chess_server [port] [engine threads]
+int main(int argc, char **argv) {
+	int port = argc > 1 ? std::stoi(argv[1]) : GameServer::DefaultPort;
+	int threads = argc > 2 ? std::stoi(argv[2])
+	                       : (int) std::thread::hardware_concurrency() - 1;
+
+	Sockets::RaiseOpenFileLimit();
+	GameServer server(threads);
+	if (!server.Listen((uint16_t) port))
+		return 1;
+
+	s_Server = &server;
+	std::signal(SIGINT, OnSignal);
+	std::signal(SIGTERM, OnSignal);
+	std::cout << "listening on port " << port << std::endl;
+	server.Run();
+	s_Server = nullptr;
+}
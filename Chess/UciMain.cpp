@@ -0,0 +1,8 @@
+#include <iostream>
+
+#include "Uci/Uci.h"
+
+int main() {
+	Uci uci;
+	uci.Loop(std::cin);
+}
@@ -1,12 +1,34 @@
 #include "Application.h"
 #include "Engine/Events/WindowEvents.h"
 
+#include <algorithm>
 #include <fstream>
+#include <thread>
 
 Application *Application::m_App = nullptr;
 
 #define CALCULATE_PERFT
 
+// draws on the thread handling events and the board, as it used to, to
+// compare frame times against the render thread
+// #define RENDER_ON_MAIN_THREAD
+
+namespace
+{
+	constexpr int64_t AnalysisTimeMs = 30000;
+
+	// longest the logic thread waits for an event before it polls the
+	// analysis service again
+	constexpr double EventWaitSeconds = 0.005;
+
+	// longest the main thread waits for input, closing the window wakes it
+	// up early
+	constexpr double InputWaitSeconds = 0.1;
+
+	constexpr const char *BoardVertShader = "Assets/Shaders/Board.vert";
+	constexpr const char *BoardFragShader = "Assets/Shaders/Board.frag";
+} // namespace
+
 Application::Application(
 	unsigned int width, unsigned int height, const char *title
 )
@@ -26,12 +48,24 @@ Application::Application(
 	if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress))
 		std::cout << "Failed to initialize GLAD\n";
 
-	m_ChessBoard = std::make_unique<Board>(
-		"Assets/Shaders/Board.vert", "Assets/Shaders/Board.frag"
+	m_ChessBoard = std::make_unique<Board>();
+
+	m_RenderThread = std::make_unique<Engine::RenderThread>(
+		m_MainWindow->GetWindow(),
+		[this] {
+			m_BoardRenderer = std::make_unique<BoardRenderer>(
+				BoardVertShader, BoardFragShader
+			);
+		},
+		[this] { DrawFrame(); }, [this] { m_BoardRenderer.reset(); }
 	);
 
 	AddLayer(m_ChessBoard->GetBoardLayer());
 
+	// one core is left to the render thread
+	int threads = (int) std::max(std::thread::hardware_concurrency(), 2u) - 1;
+	m_Analysis = std::make_unique<AnalysisService>(threads);
+
 	std::string starting =
 		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
 	std::string castling_test = "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1";
@@ -40,7 +74,10 @@ Application::Application(
 	std::string debug_test =
 		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - ";
 
-	m_ChessBoard->ReadFen(debug_test);
+	const char *fenError = nullptr;
+	if (!m_ChessBoard->ReadFen(debug_test, &fenError))
+		std::cout << "Invalid FEN (" << fenError << "): " << debug_test
+				  << std::endl;
 
 #ifdef CALCULATE_PERFT
 	m_ChessBoard->CalculateAllLegalMoves();
@@ -49,33 +86,55 @@ Application::Application(
 	m_ChessBoard->MakeMove({{7, 2}, {6, 1}});
 	m_ChessBoard->CalculateAllLegalMoves();
 
-	using namespace std::chrono;
-	auto start = steady_clock::now();
-
-	auto moves = m_ChessBoard->Perft(
-		3, true, std::bind(&Engine::Window::Update, m_MainWindow.get())
-	);
-	m_ChessBoard->CalculateAllLegalMoves();
-
-	std::cout
-		<< "\nNodes searched: " << moves << " in "
-		<< duration_cast<milliseconds>(steady_clock::now() - start).count()
-		<< " ms" << std::endl;
+	// the results are printed by the render loop as they come in
+	m_Analysis->StartPerft(m_ChessBoard->GetBoardState(), 3, true);
 #endif
 }
 
 Application::~Application() { glfwTerminate(); }
 
 void Application::Run() {
-	m_LastFrame = std::chrono::steady_clock::now();
+	PublishView();
+
+#ifdef RENDER_ON_MAIN_THREAD
+	m_BoardRenderer =
+		std::make_unique<BoardRenderer>(BoardVertShader, BoardFragShader);
+#else
+	// the context goes to the render thread
+	glfwMakeContextCurrent(nullptr);
+	m_RenderThread->Start();
+#endif
+
+	// what input does to the board runs on the logic thread, this one only
+	// polls for input (and draws, when rendering on the main thread)
+	m_LogicThread = std::thread(&Application::RunLogic, this);
 
 	while (!m_MainWindow->GetShouldCloseWindow()) {
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+#ifdef RENDER_ON_MAIN_THREAD
+		m_RenderThread->RenderFrame();
+		m_MainWindow->PollEvents();
+#else
+		m_MainWindow->WaitEvents(InputWaitSeconds);
+#endif
+	}
 
-		m_ChessBoard->RenderBoard();
+	m_LogicThread.join();
 
-		m_MainWindow->Update();
+#ifdef RENDER_ON_MAIN_THREAD
+	m_BoardRenderer.reset();
+#else
+	m_RenderThread->Stop();
+#endif
+}
 
+void Application::RunLogic() {
+	m_LastFrame = std::chrono::steady_clock::now();
+
+	while (!m_MainWindow->GetShouldCloseWindow()) {
+		m_MainWindow->WaitForQueuedEvents(EventWaitSeconds);
+		m_MainWindow->DispatchEvents();
+		PollAnalysis();
+		PublishView();
 
 		m_DeltaTime =
 			(float) std::chrono::duration_cast<std::chrono::microseconds>(
@@ -96,12 +155,68 @@ void Application::OnEvent(Engine::Event &e) {
 		)) ||
 	    dispatcher.Dispatch<Engine::WindowResizedEvent>(BIND_EVENT_FUNC(
 			Engine::Window::OnEvent_WindowResize, m_MainWindow.get()
-		)))
+		)) ||
+	    dispatcher.Dispatch<Engine::KeyPressedEvent>(
+			BIND_EVENT_FUNC(Application::OnKeyPressed, this)
+		))
 		return;
 
 	m_LayerStack.OnEvent(e);
 }
 
+bool Application::OnKeyPressed(Engine::KeyPressedEvent &e) {
+	if (e.GetKey() != GLFW_KEY_SPACE)
+		return false;
+
+	if (m_Analysis->IsBusy()) {
+		m_Analysis->Cancel();
+		std::cout << "analysis stopped" << std::endl;
+		return true;
+	}
+
+	SearchLimits limits;
+	limits.moveTimeMs = AnalysisTimeMs;
+	m_Analysis->StartSearch(m_ChessBoard->GetBoardState(), limits);
+	return true;
+}
+
+void Application::PollAnalysis() {
+	AnalysisService::Result result;
+	while (m_Analysis->Poll(result)) {
+		switch (result.type) {
+		case AnalysisService::Result::Info:
+			std::cout << "info " << result.info.ToString() << std::endl;
+			break;
+		case AnalysisService::Result::BestMove:
+			std::cout << "bestmove "
+					  << (result.move.IsNull() ? "(none)"
+			                                   : result.move.ToString())
+					  << std::endl;
+			break;
+		case AnalysisService::Result::PerftDivide:
+			std::cout << result.move.ToString() << ": " << result.nodes
+					  << std::endl;
+			break;
+		case AnalysisService::Result::PerftDone:
+			std::cout << "\nNodes searched: " << result.nodes << " in "
+					  << result.timeMs << " ms" << std::endl;
+			break;
+		}
+	}
+}
+
+void Application::PublishView() {
+	m_Views.GetBack() = m_ChessBoard->GetView();
+	m_Views.Publish();
+}
+
+void Application::DrawFrame() {
+	m_Views.Acquire();
+
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	m_BoardRenderer->Draw(m_Views.GetFront());
+}
+
 void Application::AddLayer(Engine::Layer *layer) {
 	if (m_App)
 		m_App->m_LayerStack.Push(layer);
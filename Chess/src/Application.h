@@ -2,11 +2,16 @@
 
 #include <chrono>
 #include <memory>
+#include <thread>
 
 #include "Board/Board.h"
+#include "Board/BoardRenderer.h"
 #include "Engine/Events/Events.h"
 #include "Engine/Layer.h"
+#include "Engine/RenderThread.h"
+#include "Engine/SnapshotBuffer.h"
 #include "Engine/Window.h"
+#include "Search/AnalysisService.h"
 
 
 class Application
@@ -20,10 +25,27 @@ public:
 
 	void OnEvent(Engine::Event &e);
 
+	// space starts analysing the position on screen, or stops it
+	bool OnKeyPressed(Engine::KeyPressedEvent &e);
+
 	static void AddLayer(Engine::Layer *layer);
 
 	static Engine::LayerStack *GetLayerStack();
 
+private:
+	// logic thread: handles the input the main thread queues and keeps the
+	// board's view published, until the window closes
+	void RunLogic();
+
+	// prints whatever the analysis service finished since the last frame
+	void PollAnalysis();
+
+	// hands the board as it is now to the renderer
+	void PublishView();
+
+	// render thread: draws the newest view published
+	void DrawFrame();
+
 private:
 	static Application *m_App;
 
@@ -33,6 +55,18 @@ private:
 
 	std::unique_ptr<Board> m_ChessBoard;
 
+	// the board as the logic thread last left it, drawn by the renderer
+	Engine::SnapshotBuffer<BoardView> m_Views;
+	// only touched by the render thread
+	std::unique_ptr<BoardRenderer> m_BoardRenderer;
+	std::unique_ptr<Engine::RenderThread> m_RenderThread;
+
+	// the board, the layers and the analysis service belong to it
+	std::thread m_LogicThread;
+
+	// searches and perfts, off the render thread
+	std::unique_ptr<AnalysisService> m_Analysis;
+
 	std::chrono::time_point<std::chrono::steady_clock> m_LastFrame;
 	float m_DeltaTime;
 };
\ No newline at end of file
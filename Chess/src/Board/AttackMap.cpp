@@ -0,0 +1,54 @@
+#include "AttackMap.h"
+
+using namespace BitBoards;
+
+BitBoard AttackMap::SideAttacks(
+	const BitBoard (&pieces)[6], Color color, BitBoard occupancy
+) {
+	BitBoard pawns = pieces[PawnPiece];
+	BitBoard pawnAttacks = color == White ? Shift<NorthEast>(pawns) |
+	                                            Shift<NorthWest>(pawns)
+	                                      : Shift<SouthEast>(pawns) |
+	                                            Shift<SouthWest>(pawns);
+
+	BitBoard knights = pieces[KnightPiece];
+	BitBoard knightAttacks =
+		Shift<North>(Shift<NorthEast>(knights) | Shift<NorthWest>(knights)) |
+		Shift<South>(Shift<SouthEast>(knights) | Shift<SouthWest>(knights)) |
+		Shift<East>(Shift<NorthEast>(knights) | Shift<SouthEast>(knights)) |
+		Shift<West>(Shift<NorthWest>(knights) | Shift<SouthWest>(knights));
+
+	BitBoard king = pieces[KingPiece];
+	BitBoard kingAttacks = Shift<East>(king) | Shift<West>(king);
+	BitBoard kingRow = king | kingAttacks;
+	kingAttacks |= Shift<North>(kingRow) | Shift<South>(kingRow);
+
+	return pawnAttacks | knightAttacks | kingAttacks |
+	       SlidingAttacks(
+			   pieces[RookPiece] | pieces[QueenPiece],
+			   pieces[BishopPiece] | pieces[QueenPiece], occupancy
+		   );
+}
+
+BitBoard AttackMap::SlidingAttacks(
+	BitBoard rooks, BitBoard bishops, BitBoard occupancy
+) {
+	static const bool avx2 = CpuSupportsAvx2();
+	if (avx2)
+		return SlidingAttacksAvx2(rooks, bishops, occupancy);
+	return SlidingAttacksScalar(rooks, bishops, occupancy);
+}
+
+BitBoard AttackMap::SlidingAttacksScalar(
+	BitBoard rooks, BitBoard bishops, BitBoard occupancy
+) {
+	BitBoard empty = ~occupancy;
+	return BitBoards::SlidingAttacks<North>(rooks, empty) |
+	       BitBoards::SlidingAttacks<South>(rooks, empty) |
+	       BitBoards::SlidingAttacks<East>(rooks, empty) |
+	       BitBoards::SlidingAttacks<West>(rooks, empty) |
+	       BitBoards::SlidingAttacks<NorthEast>(bishops, empty) |
+	       BitBoards::SlidingAttacks<NorthWest>(bishops, empty) |
+	       BitBoards::SlidingAttacks<SouthEast>(bishops, empty) |
+	       BitBoards::SlidingAttacks<SouthWest>(bishops, empty);
+}
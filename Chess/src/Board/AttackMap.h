@@ -0,0 +1,32 @@
+#pragma once
+
+#include "BitBoard.h"
+#include "Position.h"
+
+// Whole-side attack maps computed set-wise: each kind of piece is handled
+// for all pieces of that kind at once, sliders with one Kogge-Stone fill per
+// direction instead of one ray walk per piece.
+class AttackMap
+{
+public:
+	// every square attacked by pieces (indexed by PieceType) of the given
+	// color, sliders stopping at the first square in occupancy
+	static BitBoard SideAttacks(
+		const BitBoard (&pieces)[6], Color color, BitBoard occupancy
+	);
+
+	// squares attacked by the rook-like and bishop-like sliders. Uses the
+	// AVX2 path (all 8 directions in lanes) when the cpu supports it.
+	static BitBoard SlidingAttacks(
+		BitBoard rooks, BitBoard bishops, BitBoard occupancy
+	);
+
+	static BitBoard SlidingAttacksScalar(
+		BitBoard rooks, BitBoard bishops, BitBoard occupancy
+	);
+
+	// lives in AttackMapAvx2.cpp, only call when CpuSupportsAvx2()
+	static BitBoard SlidingAttacksAvx2(
+		BitBoard rooks, BitBoard bishops, BitBoard occupancy
+	);
+};
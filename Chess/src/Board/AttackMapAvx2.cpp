@@ -0,0 +1,76 @@
+// This file is compiled with AVX2 enabled (see CMakeLists.txt), it is only
+// ever called after BitBoards::CpuSupportsAvx2() said so.
+
+#include "AttackMap.h"
+
+#include <immintrin.h>
+
+// The eight directions are split over two registers: the four that shift
+// towards h8 (N, E, NE, NW) and the four that shift towards a1 (S, W, SW,
+// SE). AVX2's per lane variable shifts then run one Kogge-Stone fill for
+// all four directions of a register at once.
+BitBoard AttackMap::SlidingAttacksAvx2(
+	BitBoard rooks, BitBoard bishops, BitBoard occupancy
+) {
+	using namespace BitBoards;
+
+	const __m256i shift1 = _mm256_setr_epi64x(8, 1, 9, 7);
+	const __m256i shift2 = _mm256_slli_epi64(shift1, 1);
+	const __m256i shift4 = _mm256_slli_epi64(shift1, 2);
+
+	const __m256i gen = _mm256_setr_epi64x(
+		(long long) rooks, (long long) rooks, (long long) bishops,
+		(long long) bishops
+	);
+	const __m256i empty = _mm256_set1_epi64x((long long) ~occupancy);
+
+	// squares that don't wrap around the board edge after one step
+	const __m256i upMask = _mm256_setr_epi64x(
+		(long long) All, (long long) ~FileA, (long long) ~FileA,
+		(long long) ~FileH
+	);
+	const __m256i downMask = _mm256_setr_epi64x(
+		(long long) All, (long long) ~FileH, (long long) ~FileH,
+		(long long) ~FileA
+	);
+
+	// towards h8
+	__m256i up = gen;
+	__m256i pro = _mm256_and_si256(empty, upMask);
+	up = _mm256_or_si256(
+		up, _mm256_and_si256(pro, _mm256_sllv_epi64(up, shift1))
+	);
+	pro = _mm256_and_si256(pro, _mm256_sllv_epi64(pro, shift1));
+	up = _mm256_or_si256(
+		up, _mm256_and_si256(pro, _mm256_sllv_epi64(up, shift2))
+	);
+	pro = _mm256_and_si256(pro, _mm256_sllv_epi64(pro, shift2));
+	up = _mm256_or_si256(
+		up, _mm256_and_si256(pro, _mm256_sllv_epi64(up, shift4))
+	);
+	up = _mm256_and_si256(_mm256_sllv_epi64(up, shift1), upMask);
+
+	// towards a1
+	__m256i down = gen;
+	pro = _mm256_and_si256(empty, downMask);
+	down = _mm256_or_si256(
+		down, _mm256_and_si256(pro, _mm256_srlv_epi64(down, shift1))
+	);
+	pro = _mm256_and_si256(pro, _mm256_srlv_epi64(pro, shift1));
+	down = _mm256_or_si256(
+		down, _mm256_and_si256(pro, _mm256_srlv_epi64(down, shift2))
+	);
+	pro = _mm256_and_si256(pro, _mm256_srlv_epi64(pro, shift2));
+	down = _mm256_or_si256(
+		down, _mm256_and_si256(pro, _mm256_srlv_epi64(down, shift4))
+	);
+	down = _mm256_and_si256(_mm256_srlv_epi64(down, shift1), downMask);
+
+	// fold the eight directions into one bitboard
+	__m256i all = _mm256_or_si256(up, down);
+	__m128i half = _mm_or_si128(
+		_mm256_castsi256_si128(all), _mm256_extracti128_si256(all, 1)
+	);
+	half = _mm_or_si128(half, _mm_unpackhi_epi64(half, half));
+	return (BitBoard) _mm_cvtsi128_si64(half);
+}
@@ -0,0 +1,216 @@
+#include "BatchMoveGen.h"
+#include "BatchMoveGenKernel.h"
+
+using namespace BitBoards;
+
+//////////////////////////////// BoardStateBatch ///////////////////////////////
+
+void BoardStateBatch::Clear() {
+	for (auto &color : p_Pieces)
+		for (auto &pieces : color) pieces.clear();
+	p_WhiteToMove.clear();
+	p_CastlingRights.clear();
+	p_EnPassantSquare.clear();
+}
+
+void BoardStateBatch::Reserve(size_t size) {
+	for (auto &color : p_Pieces)
+		for (auto &pieces : color) pieces.reserve(size);
+	p_WhiteToMove.reserve(size);
+	p_CastlingRights.reserve(size);
+	p_EnPassantSquare.reserve(size);
+}
+
+void BoardStateBatch::Push(const BoardState &state) {
+	for (int color = Black; color <= White; color++)
+		for (int type = PawnPiece; type <= KingPiece; type++)
+			p_Pieces[color][type].push_back(
+				state.GetPieces((Color) color, (PieceType) type)
+			);
+
+	p_WhiteToMove.push_back(state.GetTurn() == White ? All : Empty);
+	p_CastlingRights.push_back(state.GetCastlingRights());
+	p_EnPassantSquare.push_back(state.GetEnPassantSquare());
+}
+
+///////////////////////////////// BatchMoveGen /////////////////////////////////
+
+void BatchMoveGen::Generate(
+	const BoardStateBatch &batch, BatchMoveGenResults &results,
+	bool allowAvx2 /*=true*/
+) {
+	int size = (int) batch.Size();
+	results.p_Attacked.resize(size);
+	results.p_Checkers.resize(size);
+	results.p_LegalMoveCount.resize(size);
+	if (!size)
+		return;
+
+	const BitBoard *white[6], *black[6];
+	for (int type = PawnPiece; type <= KingPiece; type++) {
+		white[type] = batch.p_Pieces[White][type].data();
+		black[type] = batch.p_Pieces[Black][type].data();
+	}
+
+	// whole groups of four go down the AVX2 path, whatever is left over is
+	// run through the scalar instantiation of the same kernel
+	int vectorized = 0;
+	if (allowAvx2 && IsAvx2Available()) {
+		vectorized = size - size % 4;
+		BatchKernel::RunAvx2(
+			white, black, batch.p_WhiteToMove.data(), vectorized,
+			results.p_Attacked.data(), results.p_Checkers.data(),
+			results.p_LegalMoveCount.data()
+		);
+	}
+
+	for (int type = PawnPiece; type <= KingPiece; type++) {
+		white[type] += vectorized;
+		black[type] += vectorized;
+	}
+	BatchKernel::Run<BatchKernel::ScalarLanes>(
+		white, black, batch.p_WhiteToMove.data() + vectorized,
+		size - vectorized, results.p_Attacked.data() + vectorized,
+		results.p_Checkers.data() + vectorized,
+		results.p_LegalMoveCount.data() + vectorized
+	);
+
+	for (int i = 0; i < size; i++)
+		results.p_LegalMoveCount[i] += CountSpecialMoves(
+			batch, i, results.p_Attacked[i], results.p_Checkers[i]
+		);
+}
+
+// en passant and castling are rare and depend on per position squares, so
+// they are counted here for one position at a time
+unsigned int BatchMoveGen::CountSpecialMoves(
+	const BoardStateBatch &batch, size_t index, BitBoard attacked,
+	BitBoard checkers
+) {
+	Color us = batch.p_WhiteToMove[index] ? White : Black;
+	Color them = (Color) !us;
+
+	BitBoard pieces[2][6];
+	BitBoard occupancy[2] = {0, 0};
+	for (int color = Black; color <= White; color++) {
+		for (int type = PawnPiece; type <= KingPiece; type++) {
+			pieces[color][type] = batch.p_Pieces[color][type][index];
+			occupancy[color] |= pieces[color][type];
+		}
+	}
+	BitBoard allPieces = occupancy[Black] | occupancy[White];
+
+	unsigned int moves = 0;
+
+	int epSquare = batch.p_EnPassantSquare[index];
+	if (epSquare >= 0) {
+		int captured = epSquare + (us ? South : North);
+		int kingSq = LowestSquare(pieces[us][KingPiece]);
+		BitBoard rooks = pieces[them][RookPiece] | pieces[them][QueenPiece];
+		BitBoard bishops = pieces[them][BishopPiece] | pieces[them][QueenPiece];
+		BitBoard capturers = PawnAttacks[them][epSquare] & pieces[us][PawnPiece];
+
+		while (capturers) {
+			int from = PopLowest(capturers);
+			BitBoard after =
+				(allPieces ^ SquareBB(from) ^ SquareBB(captured)) |
+				SquareBB(epSquare);
+
+			BitBoard attackers =
+				(PawnAttacks[us][kingSq] & pieces[them][PawnPiece] &
+			     ~SquareBB(captured)) |
+				(KnightAttacks[kingSq] & pieces[them][KnightPiece]) |
+				(RookAttacks(kingSq, after) & rooks) |
+				(BishopAttacks(kingSq, after) & bishops);
+			if (!attackers)
+				moves++;
+		}
+	}
+
+	int rights = batch.p_CastlingRights[index];
+	if (checkers || !rights)
+		return moves;
+
+	int kingSq = us ? 4 : 60;
+	int kingSide = us ? BoardState::WhiteKingSide : BoardState::BlackKingSide;
+	int queenSide =
+		us ? BoardState::WhiteQueenSide : BoardState::BlackQueenSide;
+
+	BitBoard kingSidePath = SquareBB(kingSq + 1) | SquareBB(kingSq + 2);
+	BitBoard queenSidePath = SquareBB(kingSq - 1) | SquareBB(kingSq - 2);
+
+	if ((rights & kingSide) && !(allPieces & kingSidePath) &&
+	    !(attacked & kingSidePath))
+		moves++;
+	if ((rights & queenSide) &&
+	    !(allPieces & (queenSidePath | SquareBB(kingSq - 3))) &&
+	    !(attacked & queenSidePath))
+		moves++;
+
+	return moves;
+}
+
+namespace
+{
+	struct PerftCollector {
+		BoardStateBatch batch;
+		BatchMoveGenResults results;
+		std::vector<size_t> owners;
+		std::vector<uint64_t> &nodes;
+		bool allowAvx2;
+
+		static constexpr size_t BatchSize = 4096;
+
+		void Flush() {
+			BatchMoveGen::Generate(batch, results, allowAvx2);
+			for (size_t i = 0; i < owners.size(); i++)
+				nodes[owners[i]] += results.p_LegalMoveCount[i];
+			batch.Clear();
+			owners.clear();
+		}
+
+		void Collect(BoardState &state, int depth, size_t owner) {
+			if (depth == 0) {
+				batch.Push(state);
+				owners.push_back(owner);
+				if (owners.size() == BatchSize)
+					Flush();
+				return;
+			}
+
+			MoveList moves;
+			state.GenerateLegalMoves(moves);
+			for (BoardMove move : moves) {
+				state.MakeMove(move);
+				Collect(state, depth - 1, owner);
+				state.UndoMove(move);
+			}
+		}
+	};
+} // namespace
+
+std::vector<uint64_t> BatchMoveGen::Perft(
+	const std::vector<BoardState> &positions, int depth,
+	bool allowAvx2 /*=true*/
+) {
+	std::vector<uint64_t> nodes(positions.size(), depth == 0 ? 1 : 0);
+	if (depth == 0)
+		return nodes;
+
+	PerftCollector collector {{}, {}, {}, nodes, allowAvx2};
+	collector.batch.Reserve(PerftCollector::BatchSize);
+	collector.owners.reserve(PerftCollector::BatchSize);
+
+	for (size_t i = 0; i < positions.size(); i++) {
+		BoardState state = positions[i];
+		collector.Collect(state, depth - 1, i);
+	}
+	collector.Flush();
+
+	return nodes;
+}
+
+bool BatchMoveGen::IsAvx2Available() {
+	static const bool available = CpuSupportsAvx2();
+	return available;
+}
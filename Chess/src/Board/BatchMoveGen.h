@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "BoardState.h"
+
+// Many unrelated positions laid out structure-of-arrays: element i of every
+// array belongs to position i, so one SIMD register can hold the same
+// bitboard of several positions.
+class BoardStateBatch
+{
+public:
+	void Clear();
+
+	void Reserve(size_t size);
+
+	void Push(const BoardState &state);
+
+	inline size_t Size() const { return p_WhiteToMove.size(); }
+
+public:
+	std::vector<BitBoard> p_Pieces[2][6];
+
+	// all bits set when white is to move, none when black is
+	std::vector<BitBoard> p_WhiteToMove;
+
+	std::vector<uint8_t> p_CastlingRights;
+	std::vector<int8_t> p_EnPassantSquare;
+};
+
+struct BatchMoveGenResults {
+	// squares attacked by the side not to move, sliders looking through the
+	// king of the side to move (so also every square that king can't go to)
+	std::vector<BitBoard> p_Attacked;
+
+	std::vector<BitBoard> p_Checkers;
+
+	std::vector<uint64_t> p_LegalMoveCount;
+};
+
+// Legal move counting for bulk workloads. Runs four positions per AVX2
+// register when the cpu supports it, and the same kernel one position at a
+// time otherwise, so both paths give identical results (which also match
+// BoardState::CountLegalMoves()).
+class BatchMoveGen
+{
+public:
+	static void Generate(
+		const BoardStateBatch &batch, BatchMoveGenResults &results,
+		bool allowAvx2 = true
+	);
+
+	// perft of every position, the positions one ply above the leaves are
+	// collected into batches and bulk counted with Generate()
+	static std::vector<uint64_t> Perft(
+		const std::vector<BoardState> &positions, int depth,
+		bool allowAvx2 = true
+	);
+
+	static bool IsAvx2Available();
+
+private:
+	static unsigned int CountSpecialMoves(
+		const BoardStateBatch &batch, size_t index, BitBoard attacked,
+		BitBoard checkers
+	);
+};
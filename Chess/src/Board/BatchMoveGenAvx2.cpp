@@ -0,0 +1,92 @@
+// This file is compiled with AVX2 enabled (see CMakeLists.txt), it is only
+// ever called after BitBoards::CpuSupportsAvx2() said so.
+
+#include "BatchMoveGenKernel.h"
+
+#include <immintrin.h>
+
+namespace BatchKernel
+{
+	namespace
+	{
+		// four positions per register, one 64 bit lane each
+		struct Avx2Lanes {
+			static constexpr int Width = 4;
+
+			__m256i v;
+
+			static Avx2Lanes Broadcast(BitBoard b) {
+				return {_mm256_set1_epi64x((long long) b)};
+			}
+
+			static Avx2Lanes Load(const BitBoard *p) {
+				return {_mm256_loadu_si256((const __m256i *) p)};
+			}
+
+			void Store(BitBoard *p) const {
+				_mm256_storeu_si256((__m256i *) p, v);
+			}
+		};
+
+		Avx2Lanes operator&(Avx2Lanes a, Avx2Lanes b) {
+			return {_mm256_and_si256(a.v, b.v)};
+		}
+
+		Avx2Lanes operator|(Avx2Lanes a, Avx2Lanes b) {
+			return {_mm256_or_si256(a.v, b.v)};
+		}
+
+		Avx2Lanes operator~(Avx2Lanes a) {
+			return {_mm256_xor_si256(a.v, _mm256_set1_epi64x(-1))};
+		}
+
+		Avx2Lanes operator+(Avx2Lanes a, Avx2Lanes b) {
+			return {_mm256_add_epi64(a.v, b.v)};
+		}
+
+		Avx2Lanes operator-(Avx2Lanes a, Avx2Lanes b) {
+			return {_mm256_sub_epi64(a.v, b.v)};
+		}
+
+		Avx2Lanes ShiftLeft(Avx2Lanes a, int n) {
+			return {_mm256_slli_epi64(a.v, n)};
+		}
+
+		Avx2Lanes ShiftRight(Avx2Lanes a, int n) {
+			return {_mm256_srli_epi64(a.v, n)};
+		}
+
+		Avx2Lanes NonZero(Avx2Lanes a) {
+			return ~Avx2Lanes {
+				_mm256_cmpeq_epi64(a.v, _mm256_setzero_si256())};
+		}
+
+		// nibble lookup popcount, the byte counts of each lane are summed by
+		// the sad against zero
+		Avx2Lanes CountBits(Avx2Lanes a) {
+			const __m256i lookup = _mm256_setr_epi8(
+				0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, //
+				0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+			);
+			const __m256i lowMask = _mm256_set1_epi8(0x0f);
+
+			__m256i low = _mm256_and_si256(a.v, lowMask);
+			__m256i high = _mm256_and_si256(_mm256_srli_epi16(a.v, 4), lowMask);
+			__m256i counts = _mm256_add_epi8(
+				_mm256_shuffle_epi8(lookup, low),
+				_mm256_shuffle_epi8(lookup, high)
+			);
+			return {_mm256_sad_epu8(counts, _mm256_setzero_si256())};
+		}
+	} // namespace
+
+	void RunAvx2(
+		const BitBoard *const (&white)[6], const BitBoard *const (&black)[6],
+		const BitBoard *whiteToMove, int count, BitBoard *attacked,
+		BitBoard *checkers, BitBoard *moveCounts
+	) {
+		Run<Avx2Lanes>(
+			white, black, whiteToMove, count, attacked, checkers, moveCounts
+		);
+	}
+} // namespace BatchKernel
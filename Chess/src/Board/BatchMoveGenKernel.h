@@ -0,0 +1,405 @@
+#pragma once
+
+#include "BitBoard.h"
+
+// Set-wise move generation shared by the scalar and AVX2 batch paths.
+//
+// Everything here is written against a "lanes" type that holds the same
+// bitboard of Width positions side by side (one position for ScalarLanes,
+// four for the AVX2 lanes). Both paths instantiate the exact same code, which
+// is what keeps their results identical.
+//
+// Apart from ScalarLanes, which only the scalar path uses, nothing but
+// constexpr values and templates may be used in here: the AVX2 translation
+// unit is compiled with AVX2 enabled, and any ordinary inline function it
+// emitted could be picked by the linker for the whole program.
+
+namespace BatchKernel
+{
+	struct ScalarLanes {
+		static constexpr int Width = 1;
+
+		BitBoard v;
+
+		static ScalarLanes Broadcast(BitBoard b) { return {b}; }
+
+		static ScalarLanes Load(const BitBoard *p) { return {*p}; }
+
+		void Store(BitBoard *p) const { *p = v; }
+	};
+
+	inline ScalarLanes operator&(ScalarLanes a, ScalarLanes b) {
+		return {a.v & b.v};
+	}
+
+	inline ScalarLanes operator|(ScalarLanes a, ScalarLanes b) {
+		return {a.v | b.v};
+	}
+
+	inline ScalarLanes operator~(ScalarLanes a) { return {~a.v}; }
+
+	inline ScalarLanes operator+(ScalarLanes a, ScalarLanes b) {
+		return {a.v + b.v};
+	}
+
+	inline ScalarLanes operator-(ScalarLanes a, ScalarLanes b) {
+		return {a.v - b.v};
+	}
+
+	inline ScalarLanes ShiftLeft(ScalarLanes a, int n) { return {a.v << n}; }
+
+	inline ScalarLanes ShiftRight(ScalarLanes a, int n) { return {a.v >> n}; }
+
+	// all bits set in the lanes that are not zero
+	inline ScalarLanes NonZero(ScalarLanes a) { return {a.v ? ~0ULL : 0}; }
+
+	// per lane population count
+	inline ScalarLanes CountBits(ScalarLanes a) {
+		return {(BitBoard) std::popcount(a.v)};
+	}
+
+	///////////////////////////// Lane Helpers /////////////////////////////////
+
+	template<typename L>
+	inline L Select(L mask, L a, L b) {
+		return (mask & a) | (~mask & b);
+	}
+
+	template<int shift, typename L>
+	inline L RawShift(L b) {
+		if constexpr (shift > 0)
+			return ShiftLeft(b, shift);
+		else
+			return ShiftRight(b, -shift);
+	}
+
+	// squares that must be cleared after shifting by `shift` so that nothing
+	// wraps from one edge of the board to the other
+	template<int shift>
+	constexpr BitBoard WrapMask() {
+		using namespace BitBoards;
+		int file = ((shift % 8) + 8) % 8; // file change of the step
+		if (file == 1 || file == 2)
+			return file == 1 ? ~FileA : ~(FileA | FileB);
+		if (file == 7 || file == 6)
+			return file == 7 ? ~FileH : ~(FileG | FileH);
+		return All;
+	}
+
+	template<int shift, typename L>
+	inline L Step(L b) {
+		constexpr BitBoard mask = WrapMask<shift>();
+		if constexpr (mask == BitBoards::All)
+			return RawShift<shift>(b);
+		else
+			return RawShift<shift>(b) & L::Broadcast(mask);
+	}
+
+	template<int dir>
+	constexpr bool IsOrthogonal() {
+		return dir == North || dir == South || dir == East || dir == West;
+	}
+
+	// Kogge-Stone occluded fill: every square reachable from gen in dir
+	// without leaving the empty set (gen included)
+	template<int dir, typename L>
+	inline L OccludedFill(L gen, L empty) {
+		L pro = empty & L::Broadcast(WrapMask<dir>());
+		gen = gen | (pro & RawShift<dir>(gen));
+		pro = pro & RawShift<dir>(pro);
+		gen = gen | (pro & RawShift<2 * dir>(gen));
+		pro = pro & RawShift<2 * dir>(pro);
+		gen = gen | (pro & RawShift<4 * dir>(gen));
+		return gen;
+	}
+
+	// squares attacked in dir, first blocker included
+	template<int dir, typename L>
+	inline L SlidingAttacks(L sliders, L empty) {
+		return Step<dir>(OccludedFill<dir>(sliders, empty));
+	}
+
+	template<typename L>
+	inline L KnightAttacks(L knights) {
+		return Step<17>(knights) | Step<15>(knights) | Step<10>(knights) |
+		       Step<6>(knights) | Step<-6>(knights) | Step<-10>(knights) |
+		       Step<-15>(knights) | Step<-17>(knights);
+	}
+
+	template<typename L>
+	inline L KingAttacks(L kings) {
+		return Step<North>(kings) | Step<South>(kings) | Step<East>(kings) |
+		       Step<West>(kings) | Step<NorthEast>(kings) |
+		       Step<NorthWest>(kings) | Step<SouthEast>(kings) |
+		       Step<SouthWest>(kings);
+	}
+
+	// number of pawn moves landing on targets, promotions count four times
+	template<typename L>
+	inline L CountPawnTargets(L targets, L lastRank) {
+		return CountBits(targets & ~lastRank) +
+		       ShiftLeft(CountBits(targets & lastRank), 2);
+	}
+
+	/////////////////////////////// Kernel /////////////////////////////////////
+
+	// Calculates, for Width positions at a time, the squares the side not to
+	// move attacks (sliders see through the king of the side to move), the
+	// pieces giving check and the number of legal moves, not counting en
+	// passant captures and castling.
+	template<typename L>
+	class LaneGroup
+	{
+	public:
+		LaneGroup(const L (&white)[6], const L (&black)[6], L whiteToMove)
+			: m_WhiteToMove(whiteToMove) {
+			for (int type = PawnPiece; type <= KingPiece; type++) {
+				m_Us[type] = Select(whiteToMove, white[type], black[type]);
+				m_Them[type] = Select(whiteToMove, black[type], white[type]);
+			}
+
+			m_UsOcc = m_Us[0] | m_Us[1] | m_Us[2] | m_Us[3] | m_Us[4] | m_Us[5];
+			m_ThemOcc = m_Them[0] | m_Them[1] | m_Them[2] | m_Them[3] |
+			            m_Them[4] | m_Them[5];
+			m_Empty = ~(m_UsOcc | m_ThemOcc);
+			m_King = m_Us[KingPiece];
+
+			m_UsRooks = m_Us[RookPiece] | m_Us[QueenPiece];
+			m_UsBishops = m_Us[BishopPiece] | m_Us[QueenPiece];
+			m_ThemRooks = m_Them[RookPiece] | m_Them[QueenPiece];
+			m_ThemBishops = m_Them[BishopPiece] | m_Them[QueenPiece];
+		}
+
+		void Run(L &attacked, L &checkers, L &moveCount) {
+			CalculateAttacked();
+			CalculateChecksAndPins();
+
+			L doubleCheck = NonZero(m_Checkers & (m_Checkers - L::Broadcast(1)));
+			L checkMask = Select(
+				NonZero(m_Checkers), m_Checkers | m_CheckRays,
+				L::Broadcast(BitBoards::All)
+			);
+			L targets = ~m_UsOcc & checkMask;
+
+			L pieceMoves = CountPieceMoves(targets) + CountPawnMoves(checkMask);
+			L kingMoves =
+				CountBits(KingAttacks(m_King) & ~m_UsOcc & ~m_Attacked);
+
+			attacked = m_Attacked;
+			checkers = m_Checkers;
+			moveCount = kingMoves + (pieceMoves & ~doubleCheck);
+		}
+
+	private:
+		void CalculateAttacked() {
+			L emptyNoKing = m_Empty | m_King;
+			L pawns = m_Them[PawnPiece];
+
+			m_Attacked =
+				Select(
+					m_WhiteToMove,
+					Step<SouthEast>(pawns) | Step<SouthWest>(pawns),
+					Step<NorthEast>(pawns) | Step<NorthWest>(pawns)
+				) |
+				KnightAttacks(m_Them[KnightPiece]) |
+				KingAttacks(m_Them[KingPiece]) |
+				SlidingAttacks<North>(m_ThemRooks, emptyNoKing) |
+				SlidingAttacks<South>(m_ThemRooks, emptyNoKing) |
+				SlidingAttacks<East>(m_ThemRooks, emptyNoKing) |
+				SlidingAttacks<West>(m_ThemRooks, emptyNoKing) |
+				SlidingAttacks<NorthEast>(m_ThemBishops, emptyNoKing) |
+				SlidingAttacks<NorthWest>(m_ThemBishops, emptyNoKing) |
+				SlidingAttacks<SouthEast>(m_ThemBishops, emptyNoKing) |
+				SlidingAttacks<SouthWest>(m_ThemBishops, emptyNoKing);
+		}
+
+		void CalculateChecksAndPins() {
+			// a pawn checks the king from the squares the king would
+			// capture on if it were a pawn
+			L pawnChecks = Select(
+				m_WhiteToMove,
+				Step<NorthEast>(m_King) | Step<NorthWest>(m_King),
+				Step<SouthEast>(m_King) | Step<SouthWest>(m_King)
+			);
+
+			m_Checkers = (pawnChecks & m_Them[PawnPiece]) |
+			             (KnightAttacks(m_King) & m_Them[KnightPiece]);
+			m_CheckRays = L::Broadcast(0);
+			m_PinnedAll = L::Broadcast(0);
+
+			KingRay<North, 0>();
+			KingRay<South, 1>();
+			KingRay<East, 2>();
+			KingRay<West, 3>();
+			KingRay<NorthEast, 4>();
+			KingRay<NorthWest, 5>();
+			KingRay<SouthEast, 6>();
+			KingRay<SouthWest, 7>();
+		}
+
+		// looks from the king along dir for a checking slider, or for a
+		// single piece of ours standing between the king and such a slider
+		template<int dir, int index>
+		void KingRay() {
+			L sliders = IsOrthogonal<dir>() ? m_ThemRooks : m_ThemBishops;
+
+			L ray = SlidingAttacks<dir>(m_King, m_Empty);
+			L blocker = ray & ~m_Empty;
+			L checker = blocker & sliders;
+			m_Checkers = m_Checkers | checker;
+			m_CheckRays = m_CheckRays | (ray & m_Empty & NonZero(checker));
+
+			L own = blocker & m_UsOcc;
+			L xray = SlidingAttacks<dir>(m_King, m_Empty | own);
+			L pinner = xray & ~m_Empty & ~own & sliders;
+
+			m_Pinned[index] = own & NonZero(pinner);
+			m_PinRays[index] = xray & NonZero(m_Pinned[index]);
+			m_PinnedAll = m_PinnedAll | m_Pinned[index];
+		}
+
+		// a pinned slider may still move along the line it is pinned on
+		template<int dir, int index>
+		L CountPinnedSliderMoves(L targets) {
+			L sliders = IsOrthogonal<dir>() ? m_UsRooks : m_UsBishops;
+			return CountBits(
+				m_PinRays[index] & targets & NonZero(m_Pinned[index] & sliders)
+			);
+		}
+
+		L CountPieceMoves(L targets) {
+			L free = ~m_PinnedAll;
+			L knights = m_Us[KnightPiece] & free;
+			L rooks = m_UsRooks & free;
+			L bishops = m_UsBishops & free;
+
+			// every knight step and every slider direction is a one to one
+			// mapping of pieces to squares, so counting the bits of each
+			// counts moves rather than destination squares
+			return CountBits(Step<17>(knights) & targets) +
+			       CountBits(Step<15>(knights) & targets) +
+			       CountBits(Step<10>(knights) & targets) +
+			       CountBits(Step<6>(knights) & targets) +
+			       CountBits(Step<-6>(knights) & targets) +
+			       CountBits(Step<-10>(knights) & targets) +
+			       CountBits(Step<-15>(knights) & targets) +
+			       CountBits(Step<-17>(knights) & targets) +
+			       CountBits(SlidingAttacks<North>(rooks, m_Empty) & targets) +
+			       CountBits(SlidingAttacks<South>(rooks, m_Empty) & targets) +
+			       CountBits(SlidingAttacks<East>(rooks, m_Empty) & targets) +
+			       CountBits(SlidingAttacks<West>(rooks, m_Empty) & targets) +
+			       CountBits(
+					   SlidingAttacks<NorthEast>(bishops, m_Empty) & targets
+				   ) +
+			       CountBits(
+					   SlidingAttacks<NorthWest>(bishops, m_Empty) & targets
+				   ) +
+			       CountBits(
+					   SlidingAttacks<SouthEast>(bishops, m_Empty) & targets
+				   ) +
+			       CountBits(
+					   SlidingAttacks<SouthWest>(bishops, m_Empty) & targets
+				   ) +
+			       CountPinnedSliderMoves<North, 0>(targets) +
+			       CountPinnedSliderMoves<South, 1>(targets) +
+			       CountPinnedSliderMoves<East, 2>(targets) +
+			       CountPinnedSliderMoves<West, 3>(targets) +
+			       CountPinnedSliderMoves<NorthEast, 4>(targets) +
+			       CountPinnedSliderMoves<NorthWest, 5>(targets) +
+			       CountPinnedSliderMoves<SouthEast, 6>(targets) +
+			       CountPinnedSliderMoves<SouthWest, 7>(targets);
+		}
+
+		L CountPawnMoves(L checkMask) {
+			using namespace BitBoards;
+			L pawns = m_Us[PawnPiece];
+			L free = ~m_PinnedAll;
+
+			// pawns pinned along a file can still push, pawns pinned along
+			// a diagonal can still capture along that diagonal
+			L pushers = pawns & (free | m_Pinned[0] | m_Pinned[1]);
+			L capturersNE = pawns & (free | m_Pinned[4] | m_Pinned[7]);
+			L capturersNW = pawns & (free | m_Pinned[5] | m_Pinned[6]);
+			L captureTargets = m_ThemOcc & checkMask;
+
+			L whiteSingle = Step<North>(pushers) & m_Empty;
+			L whiteDouble =
+				Step<North>(whiteSingle & L::Broadcast(Rank3)) & m_Empty;
+			L whiteLast = L::Broadcast(Rank8);
+			L white =
+				CountPawnTargets(whiteSingle & checkMask, whiteLast) +
+				CountBits(whiteDouble & checkMask) +
+				CountPawnTargets(
+					Step<NorthEast>(capturersNE) & captureTargets, whiteLast
+				) +
+				CountPawnTargets(
+					Step<NorthWest>(capturersNW) & captureTargets, whiteLast
+				);
+
+			L blackSingle = Step<South>(pushers) & m_Empty;
+			L blackDouble =
+				Step<South>(blackSingle & L::Broadcast(Rank6)) & m_Empty;
+			L blackLast = L::Broadcast(Rank1);
+			L black =
+				CountPawnTargets(blackSingle & checkMask, blackLast) +
+				CountBits(blackDouble & checkMask) +
+				CountPawnTargets(
+					Step<SouthWest>(capturersNE) & captureTargets, blackLast
+				) +
+				CountPawnTargets(
+					Step<SouthEast>(capturersNW) & captureTargets, blackLast
+				);
+
+			return Select(m_WhiteToMove, white, black);
+		}
+
+	private:
+		L m_WhiteToMove;
+		L m_Us[6], m_Them[6];
+		L m_UsOcc, m_ThemOcc, m_Empty, m_King;
+		L m_UsRooks, m_UsBishops, m_ThemRooks, m_ThemBishops;
+
+		L m_Attacked;
+		L m_Checkers, m_CheckRays;
+
+		// indexed in BitBoards::Directions order
+		L m_Pinned[8], m_PinRays[8];
+		L m_PinnedAll;
+	};
+
+	// runs the kernel over count positions (a multiple of L::Width), reading
+	// and writing structure-of-arrays buffers
+	template<typename L>
+	void Run(
+		const BitBoard *const (&white)[6], const BitBoard *const (&black)[6],
+		const BitBoard *whiteToMove, int count, BitBoard *attacked,
+		BitBoard *checkers, BitBoard *moveCounts
+	) {
+		for (int i = 0; i < count; i += L::Width) {
+			L whitePieces[6], blackPieces[6];
+			for (int type = PawnPiece; type <= KingPiece; type++) {
+				whitePieces[type] = L::Load(white[type] + i);
+				blackPieces[type] = L::Load(black[type] + i);
+			}
+
+			LaneGroup<L> group(
+				whitePieces, blackPieces, L::Load(whiteToMove + i)
+			);
+
+			L groupAttacked, groupCheckers, groupMoves;
+			group.Run(groupAttacked, groupCheckers, groupMoves);
+
+			groupAttacked.Store(attacked + i);
+			groupCheckers.Store(checkers + i);
+			groupMoves.Store(moveCounts + i);
+		}
+	}
+
+	// Run<> over four positions per AVX2 register, lives in
+	// BatchMoveGenAvx2.cpp
+	void RunAvx2(
+		const BitBoard *const (&white)[6], const BitBoard *const (&black)[6],
+		const BitBoard *whiteToMove, int count, BitBoard *attacked,
+		BitBoard *checkers, BitBoard *moveCounts
+	);
+} // namespace BatchKernel
@@ -0,0 +1,151 @@
+#include "BitBoard.h"
+
+#if defined(_MSC_VER)
+#	include <intrin.h>
+#endif
+
+namespace BitBoards
+{
+	namespace
+	{
+		// step from sq by (df, dr), returns -1 when it falls off the board
+		constexpr int Step(int sq, int df, int dr) {
+			int file = sq % 8 + df, rank = sq / 8 + dr;
+			if (file < 0 || file > 7 || rank < 0 || rank > 7)
+				return -1;
+			return rank * 8 + file;
+		}
+
+		constexpr int DirFile[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+		constexpr int DirRank[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+
+		constexpr BitBoard LeaperAttacks(int sq, const int (*offsets)[2]) {
+			BitBoard attacks = 0;
+			for (int i = 0; i < 8; i++) {
+				int to = Step(sq, offsets[i][0], offsets[i][1]);
+				if (to >= 0)
+					attacks |= SquareBB(to);
+			}
+			return attacks;
+		}
+
+		constexpr auto GenPawnAttacks() {
+			std::array<std::array<BitBoard, 64>, 2> table {};
+			for (int sq = 0; sq < 64; sq++) {
+				// index 0 is black (moving down the board), 1 is white
+				for (int color = 0; color < 2; color++) {
+					int dr = color ? 1 : -1;
+					for (int df : {-1, 1}) {
+						int to = Step(sq, df, dr);
+						if (to >= 0)
+							table[color][sq] |= SquareBB(to);
+					}
+				}
+			}
+			return table;
+		}
+
+		constexpr auto GenKnightAttacks() {
+			constexpr int offsets[8][2] = {{1, 2},  {2, 1},   {2, -1}, {1, -2},
+			                               {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+			std::array<BitBoard, 64> table {};
+			for (int sq = 0; sq < 64; sq++)
+				table[sq] = LeaperAttacks(sq, offsets);
+			return table;
+		}
+
+		constexpr auto GenKingAttacks() {
+			constexpr int offsets[8][2] = {{0, 1},  {1, 1},   {1, 0},  {1, -1},
+			                               {0, -1}, {-1, -1}, {-1, 0}, {-1, 1}};
+			std::array<BitBoard, 64> table {};
+			for (int sq = 0; sq < 64; sq++)
+				table[sq] = LeaperAttacks(sq, offsets);
+			return table;
+		}
+
+		constexpr auto GenRays() {
+			std::array<std::array<BitBoard, 64>, 8> table {};
+			for (int dir = 0; dir < 8; dir++)
+				for (int sq = 0; sq < 64; sq++)
+					for (int to = Step(sq, DirFile[dir], DirRank[dir]); to >= 0;
+					     to = Step(to, DirFile[dir], DirRank[dir]))
+						table[dir][sq] |= SquareBB(to);
+			return table;
+		}
+
+		constexpr auto GenBetween() {
+			std::array<std::array<BitBoard, 64>, 64> table {};
+			for (int from = 0; from < 64; from++) {
+				for (int dir = 0; dir < 8; dir++) {
+					BitBoard between = 0;
+					for (int to = Step(from, DirFile[dir], DirRank[dir]);
+					     to >= 0; to = Step(to, DirFile[dir], DirRank[dir])) {
+						table[from][to] = between;
+						between |= SquareBB(to);
+					}
+				}
+			}
+			return table;
+		}
+
+		constexpr auto GenLine() {
+			std::array<std::array<BitBoard, 64>, 64> table {};
+			for (int from = 0; from < 64; from++) {
+				for (int dir = 0; dir < 8; dir++) {
+					BitBoard line = SquareBB(from);
+					for (int to = Step(from, DirFile[dir], DirRank[dir]);
+					     to >= 0; to = Step(to, DirFile[dir], DirRank[dir]))
+						line |= SquareBB(to);
+					for (int to = Step(from, -DirFile[dir], -DirRank[dir]);
+					     to >= 0; to = Step(to, -DirFile[dir], -DirRank[dir]))
+						line |= SquareBB(to);
+
+					for (int to = Step(from, DirFile[dir], DirRank[dir]);
+					     to >= 0; to = Step(to, DirFile[dir], DirRank[dir]))
+						table[from][to] = line;
+				}
+			}
+			return table;
+		}
+	} // namespace
+
+	// constinit so that the tables never depend on static initialization order
+	constinit const std::array<std::array<BitBoard, 64>, 2> PawnAttacks =
+		GenPawnAttacks();
+	constinit const std::array<BitBoard, 64> KnightAttacks = GenKnightAttacks();
+	constinit const std::array<BitBoard, 64> KingAttacks = GenKingAttacks();
+	constinit const std::array<std::array<BitBoard, 64>, 8> Rays = GenRays();
+	constinit const std::array<std::array<BitBoard, 64>, 64> Between =
+		GenBetween();
+	constinit const std::array<std::array<BitBoard, 64>, 64> Line = GenLine();
+
+	bool CpuSupportsAvx2() {
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuidex(info, 7, 0);
+		bool avx2 = info[1] & (1 << 5);
+		__cpuid(info, 1);
+		bool osxsave = info[2] & (1 << 27);
+		return avx2 && osxsave && (_xgetbv(0) & 6) == 6;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+		return __builtin_cpu_supports("avx2");
+#else
+		return false;
+#endif
+	}
+
+	bool CpuSupportsSse41() {
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		return info[2] & (1 << 19);
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+		return __builtin_cpu_supports("sse4.1");
+#else
+		return false;
+#endif
+	}
+} // namespace BitBoards
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+// a set of squares, one bit per square, indexed the same way as
+// Position::ToIndex() (a1 = 0, h1 = 7, h8 = 63)
+typedef uint64_t BitBoard;
+
+enum PieceType {
+	PawnPiece = 0,
+	KnightPiece = 1,
+	BishopPiece = 2,
+	RookPiece = 3,
+	QueenPiece = 4,
+	KingPiece = 5,
+	NoPiece = 6
+};
+
+// index into BitBoards::Rays; the value is the square offset of one step
+enum Direction {
+	North = 8,
+	South = -8,
+	East = 1,
+	West = -1,
+	NorthEast = 9,
+	NorthWest = 7,
+	SouthEast = -7,
+	SouthWest = -9
+};
+
+namespace BitBoards
+{
+	constexpr BitBoard Empty = 0;
+	constexpr BitBoard All = ~0ULL;
+
+	constexpr BitBoard FileA = 0x0101010101010101ULL;
+	constexpr BitBoard FileB = FileA << 1;
+	constexpr BitBoard FileG = FileA << 6;
+	constexpr BitBoard FileH = FileA << 7;
+
+	constexpr BitBoard Rank1 = 0xFFULL;
+	constexpr BitBoard Rank2 = Rank1 << 8;
+	constexpr BitBoard Rank3 = Rank1 << 16;
+	constexpr BitBoard Rank6 = Rank1 << 40;
+	constexpr BitBoard Rank7 = Rank1 << 48;
+	constexpr BitBoard Rank8 = Rank1 << 56;
+
+	constexpr BitBoard SquareBB(int sq) { return 1ULL << sq; }
+
+	constexpr bool Contains(BitBoard b, int sq) { return (b >> sq) & 1; }
+
+	constexpr int PopCount(BitBoard b) { return std::popcount(b); }
+
+	constexpr int LowestSquare(BitBoard b) { return std::countr_zero(b); }
+
+	constexpr int HighestSquare(BitBoard b) { return 63 - std::countl_zero(b); }
+
+	// removes the lowest square from the set and returns it
+	constexpr int PopLowest(BitBoard &b) {
+		int sq = std::countr_zero(b);
+		b &= b - 1;
+		return sq;
+	}
+
+	// moves every square one step in dir, dropping squares that would wrap
+	// around the edge of the board
+	template<int dir>
+	constexpr BitBoard Shift(BitBoard b) {
+		if constexpr (dir == North)
+			return b << 8;
+		else if constexpr (dir == South)
+			return b >> 8;
+		else if constexpr (dir == East)
+			return (b << 1) & ~FileA;
+		else if constexpr (dir == West)
+			return (b >> 1) & ~FileH;
+		else if constexpr (dir == NorthEast)
+			return (b << 9) & ~FileA;
+		else if constexpr (dir == NorthWest)
+			return (b << 7) & ~FileH;
+		else if constexpr (dir == SouthEast)
+			return (b >> 7) & ~FileA;
+		else
+			return (b >> 9) & ~FileH;
+	}
+
+	// Kogge-Stone occluded fill: every square reachable from gen in dir
+	// without leaving the empty set (gen included), for all of gen at once
+	template<int dir>
+	constexpr BitBoard OccludedFill(BitBoard gen, BitBoard empty) {
+		constexpr int step = dir > 0 ? dir : -dir;
+		constexpr auto shift = [](BitBoard b, int n) {
+			return dir > 0 ? b << n : b >> n;
+		};
+
+		// only squares a step in dir can land on may propagate the fill, the
+		// mask needs applying once since a cut off square stops everything
+		// behind it as well
+		BitBoard pro = Shift<dir>(All) & empty;
+		gen |= pro & shift(gen, step);
+		pro &= shift(pro, step);
+		gen |= pro & shift(gen, 2 * step);
+		pro &= shift(pro, 2 * step);
+		gen |= pro & shift(gen, 4 * step);
+		return gen;
+	}
+
+	// squares attacked in dir by every slider in the set, first blocker
+	// included
+	template<int dir>
+	constexpr BitBoard SlidingAttacks(BitBoard sliders, BitBoard empty) {
+		return Shift<dir>(OccludedFill<dir>(sliders, empty));
+	}
+
+	// directions in the order used by Rays: the four orthogonal ones first
+	constexpr int Directions[8] = {North,     South,     East,      West,
+	                               NorthEast, NorthWest, SouthEast, SouthWest};
+
+	extern const std::array<std::array<BitBoard, 64>, 2> PawnAttacks;
+	extern const std::array<BitBoard, 64> KnightAttacks;
+	extern const std::array<BitBoard, 64> KingAttacks;
+
+	// every square reachable from a square in a direction on an empty board
+	extern const std::array<std::array<BitBoard, 64>, 8> Rays;
+
+	// squares strictly between two squares on a line, empty otherwise
+	extern const std::array<std::array<BitBoard, 64>, 64> Between;
+
+	// the full edge-to-edge line through two squares, empty otherwise
+	extern const std::array<std::array<BitBoard, 64>, 64> Line;
+
+	inline BitBoard RayAttacks(int sq, BitBoard occupancy, int rayIndex) {
+		BitBoard attacks = Rays[rayIndex][sq];
+		BitBoard blockers = attacks & occupancy;
+		if (blockers) {
+			// N, E, NE and NW grow towards bit 63
+			bool positive = Directions[rayIndex] > 0;
+			int blocker =
+				positive ? LowestSquare(blockers) : HighestSquare(blockers);
+			attacks ^= Rays[rayIndex][blocker];
+		}
+		return attacks;
+	}
+
+	inline BitBoard RookAttacks(int sq, BitBoard occupancy) {
+		return RayAttacks(sq, occupancy, 0) | RayAttacks(sq, occupancy, 1) |
+		       RayAttacks(sq, occupancy, 2) | RayAttacks(sq, occupancy, 3);
+	}
+
+	inline BitBoard BishopAttacks(int sq, BitBoard occupancy) {
+		return RayAttacks(sq, occupancy, 4) | RayAttacks(sq, occupancy, 5) |
+		       RayAttacks(sq, occupancy, 6) | RayAttacks(sq, occupancy, 7);
+	}
+
+	inline BitBoard QueenAttacks(int sq, BitBoard occupancy) {
+		return RookAttacks(sq, occupancy) | BishopAttacks(sq, occupancy);
+	}
+
+	// squares attacked by a knight, bishop, rook, queen or king on sq
+	inline BitBoard PieceAttacks(PieceType type, int sq, BitBoard occupancy) {
+		switch (type) {
+		case KnightPiece: return KnightAttacks[sq];
+		case BishopPiece: return BishopAttacks(sq, occupancy);
+		case RookPiece: return RookAttacks(sq, occupancy);
+		case QueenPiece: return QueenAttacks(sq, occupancy);
+		default: return KingAttacks[sq];
+		}
+	}
+
+	// true when the cpu running us can execute the AVX2 code paths
+	bool CpuSupportsAvx2();
+
+	// same for the SSE4.1 code paths
+	bool CpuSupportsSse41();
+} // namespace BitBoards
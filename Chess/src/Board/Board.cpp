@@ -11,7 +11,20 @@
 #include <string>
 #include <thread>
 
-Board::Board(const char *vertShaderPath, const char *fragShaderPath)
+namespace
+{
+	PieceType GetPieceType(const Piece &piece) {
+		std::string name = piece.GetPieceName();
+		return name == "pawn"     ? PawnPiece
+		       : name == "knight" ? KnightPiece
+		       : name == "bishop" ? BishopPiece
+		       : name == "rook"   ? RookPiece
+		       : name == "queen"  ? QueenPiece
+		                          : KingPiece;
+	}
+} // namespace
+
+Board::Board()
 	: m_Layer(this), m_Turn(White), m_ActivatedSquare({-1, -1}),
 	  m_SquareSize(2.f / 8.f) {
 	m_EnPassantPieceInst = std::make_unique<EnPassantPiece>(this);
@@ -20,254 +33,156 @@ Board::Board(const char *vertShaderPath, const char *fragShaderPath)
 			->GetPosition();
 
 	for (int i = 0; i < 64; i++) {
-		Square &square = m_Board[i];
-
-		square.pos = {i % 8, i / 8};
-		float pos[3] = {
-			(-1 + m_SquareSize / 2) + ((float) square.pos.file * m_SquareSize),
-			(-1 + m_SquareSize / 2) + ((float) square.pos.rank * m_SquareSize),
-			0};
-
-		square.background = Engine::Renderer::GenQuad(
-			pos, m_SquareSize, vertShaderPath, fragShaderPath
-		);
+		m_Board[i].pos = {i % 8, i / 8};
+		m_Board[i].piece = nullptr;
+	}
+}
 
-		square.background.shader.SetUniform(
-			square.background.shader.GetUniformLocation("isWhite"),
-			!((square.pos.file + square.pos.rank) % 2)
-		);
+bool Board::ReadFen(std::string_view fen, const char **error) {
+	BoardState state;
+	if (!state.ReadFen(fen, error))
+		return false;
 
-		square.piece = nullptr;
+	// hand every piece back to the pool, including the captured ones
+	ResetEnPassantPiece();
+	GetEnPassantPiece()->ClearMoveCache();
+	for (auto &square : m_Board)
+		if (square.piece)
+			ReleasePiece(std::move(square.piece));
+	for (auto *caches : {m_CapturedPiecesCache, m_PromotedPawnsCache}) {
+		for (int color = 0; color < 2; color++) {
+			for (; !caches[color].empty(); caches[color].pop())
+				ReleasePiece(std::move(caches[color].top().second));
+		}
 	}
 
-	float pos[3] = {0, 0, 0};
-	float tint_color[4] = {0, 0, 0, .333};
-	m_ShadowObj = Engine::Renderer::GenQuad(
-		pos, m_SquareSize * 8, vertShaderPath, fragShaderPath
-	);
-
-	m_ShadowObj.shader.SetUniformVec(
-		m_ShadowObj.shader.GetUniformLocation("tint"), 4, tint_color
-	);
-	m_ShadowObj.shader.SetUniform(
-		m_ShadowObj.shader.GetUniformLocation("tint_mix"), 1.f
-	);
-}
+	m_MovesPlayed.clear();
+	m_ActivatedSquare = {-1, -1};
+	p_PinnedPiecePos[Black] = p_PinnedPiecePos[White] = {};
 
-void Board::ReadFen(std::string fen) {
-	enum Phase {
-		GenPieces = 0,
-		ActiveColor = 1,
-		CheckCastling = 2,
-		CheckEnPassant = 3,
-		HalfMove = 4,
-		FullMove = 5
-	};
+	for (int sq = 0; sq < 64; sq++) {
+		PieceType type = state.GetPieceType(sq);
+		if (type == NoPiece)
+			continue;
 
-	Phase phase = Phase::GenPieces;
+		Color color = state.GetPieceColor(sq);
+		Position pos = {sq % 8, sq / 8};
+		bool isVirgin = type != PawnPiece || pos.rank == (color ? 1 : 6);
+		SetPiece(pos, AcquirePiece(pos, color, type, isVirgin));
 
-	Position currentPos = {0, 7};
+		if (type == KingPiece)
+			p_KingPos[color] = pos;
+	}
 
-	King *king;
-	bool k, q;
+	m_Turn = state.GetTurn();
 
-	for (int i = 0; i < fen.length(); i++) {
-		if (fen[i] == ' ') {
-			phase = (Phase) (phase + 1);
-			currentPos = {-1, -1};
-			continue;
-		}
+	int rights = state.GetCastlingRights();
+	static_cast<King *>(GetPiece(p_KingPos[White]))
+		->SetCastling(
+			rights & BoardState::WhiteKingSide,
+			rights & BoardState::WhiteQueenSide
+		);
+	static_cast<King *>(GetPiece(p_KingPos[Black]))
+		->SetCastling(
+			rights & BoardState::BlackKingSide,
+			rights & BoardState::BlackQueenSide
+		);
 
-		switch (phase) {
-		case GenPieces: GeneratePieces(fen, i, currentPos); break;
-		case ActiveColor: m_Turn = (Color) (fen[i] == 'w'); break;
-		case CheckCastling:
-			if (fen[i] == '-')
-				break;
-			{
-				king = dynamic_cast<King *>(
-					GetPiece(p_KingPos[std::isupper(fen[i])])
-				);
-				k = (fen[i] == (std::isupper(fen[i]) ? 'K' : 'k'));
-				q = (fen[i + 1] == (std::isupper(fen[i + 1]) ? 'Q' : 'q'));
-				king->SetCastling(k, q);
-				i++;
-				break;
-			}
-		case CheckEnPassant:
-			if (fen[i] == '-')
-				break;
-			{
-				currentPos.file = (fen[i] - 'a');
-				i++;
-				currentPos.rank = (fen[i] - '1');
-				Position pawnPos = currentPos + Position({0, 1});
-				if (!GetPiece(pawnPos))
-					pawnPos = currentPos + Position({0, -1});
-				StartEnPassanting(
-					dynamic_cast<Pawn *>(GetPiece(pawnPos)), currentPos, 0
-				);
-				break;
-			}
-		case HalfMove:
-		case FullMove: break;
-		}
+	if (state.GetEnPassantSquare() >= 0) {
+		int sq = state.GetEnPassantSquare();
+		Position pos = {sq % 8, sq / 8};
+		Position pawnPos = pos + Position({0, m_Turn == White ? -1 : 1});
+		StartEnPassanting(static_cast<Pawn *>(GetPiece(pawnPos)), pos, 0);
 	}
 
+	m_StartingPly = (state.GetFullMoveNumber() - 1) * 2 + (m_Turn == Black);
+	m_HalfMoveClocks.assign(1, state.GetHalfMoveClock());
+
 	// Calculate moves after the board is set up.
 	CalculateAllLegalMoves();
+	StartSpeculating();
+	return true;
 }
 
-void Board::GeneratePieces(std::string fen, int i, Position &currentPos) {
-	if (fen[i] == '/')
-		currentPos = {0, currentPos.rank - 1};
-	else if (std::isdigit(fen[i])) {
-		currentPos.file += fen[i] - '0';
-	} else {
-		auto color = static_cast<Color>(std::isupper(fen[i]));
-		switch (std::tolower(fen[i])) {
-		case 'k':
-			SetPiece(
-				currentPos,
-				std::make_unique<King>(color, currentPos, m_SquareSize, this)
-			);
-			p_KingPos[color] = currentPos; // set king pos
-			break;
-		case 'q':
-			SetPiece(
-				currentPos,
-				std::make_unique<Queen>(color, currentPos, m_SquareSize, this)
-			);
-			break;
-		case 'r':
-			SetPiece(
-				currentPos,
-				std::make_unique<Rook>(color, currentPos, m_SquareSize, this)
-			);
-			break;
-		case 'b':
-			SetPiece(
-				currentPos,
-				std::make_unique<Bishop>(color, currentPos, m_SquareSize, this)
-			);
-			break;
-		case 'n':
-			SetPiece(
-				currentPos,
-				std::make_unique<Knight>(color, currentPos, m_SquareSize, this)
-			);
-			break;
-		case 'p':
-			SetPiece(
-				currentPos,
-				std::make_unique<Pawn>(
-					color, currentPos, m_SquareSize, this,
-					(color ? currentPos.rank == 1 : currentPos.rank == 6)
-				)
-			);
-			break;
-		}
-		currentPos.file++;
-	}
-}
-
-#define SHOW_CONTROLLED_SQUARES
+std::string Board::ToFen() const { return GetBoardState().ToFen(); }
 
-void Board::RenderBoard() {
-	// Instantiate a legal move which is then rendered
-	// multiple times in different locations
-	LegalMoveSprite legalMoveSpriteInst(
-		m_SquareSize, m_SquareSize * 0.75f, {0, 0}, false
-	);
-	LegalMoveSprite captureSpriteInst(m_SquareSize, m_SquareSize, {0, 0}, true);
+std::unique_ptr<Piece>
+Board::AcquirePiece(Position pos, Color color, PieceType type, bool isVirgin) {
+	auto &pool = m_PiecePool[color][type];
+	if (!pool.empty()) {
+		std::unique_ptr<Piece> piece = std::move(pool.back());
+		pool.pop_back();
+		piece->Reset(pos, isVirgin);
+		return piece;
+	}
 
-	for (auto &square : m_Board) {
-#ifdef SHOW_CONTROLLED_SQUARES
-		bool controlledByWhite = m_ControlledSquares[White].find(square.pos) !=
-		                         m_ControlledSquares[White].end();
-		bool controlledByBlack = m_ControlledSquares[Black].find(square.pos) !=
-		                         m_ControlledSquares[Black].end();
-		if (controlledByWhite) {
-			float tint[4] = {0.75f, 0.5f, 0.5f, 1};
-			square.background.shader.SetUniformVec(
-				square.background.shader.GetUniformLocation("tint"), 4, tint
-			);
-			square.background.shader.SetUniform(
-				square.background.shader.GetUniformLocation("tint_mix"), .66f
-			);
-		} else if (controlledByBlack) {
-			float tint[4] = {0.5f, 0.75f, 0.5f, 1};
-			square.background.shader.SetUniformVec(
-				square.background.shader.GetUniformLocation("tint"), 4, tint
-			);
-			square.background.shader.SetUniform(
-				square.background.shader.GetUniformLocation("tint_mix"), .66f
-			);
-		}
-		if (controlledByWhite && controlledByBlack) {
-			float tint[4] = {0.8f, 0.75f, 0.35f, 1};
-			square.background.shader.SetUniformVec(
-				square.background.shader.GetUniformLocation("tint"), 4, tint
-			);
-			square.background.shader.SetUniform(
-				square.background.shader.GetUniformLocation("tint_mix"), .66f
-			);
-		}
-#endif
-		// FlipBoard(square);
+	switch (type) {
+	case KingPiece:
+		return std::make_unique<King>(color, pos, m_SquareSize, this);
+	case QueenPiece:
+		return std::make_unique<Queen>(color, pos, m_SquareSize, this);
+	case RookPiece:
+		return std::make_unique<Rook>(color, pos, m_SquareSize, this);
+	case BishopPiece:
+		return std::make_unique<Bishop>(color, pos, m_SquareSize, this);
+	case KnightPiece:
+		return std::make_unique<Knight>(color, pos, m_SquareSize, this);
+	default:
+		return std::make_unique<Pawn>(
+			color, pos, m_SquareSize, this, isVirgin
+		);
+	}
+}
 
-		// Render background
-		Engine::Renderer::SubmitObject(square.background);
+void Board::ReleasePiece(std::unique_ptr<Piece> piece) {
+	PieceType type = GetPieceType(*piece);
+	m_PiecePool[piece->GetColor()][type].push_back(std::move(piece));
+}
 
-		if (square.piece)
-			square.piece->Render();
+BoardView Board::GetView() const {
+	BoardView view;
+	for (const auto &square : m_Board) {
+		if (!IsSquareOccupied(square.pos))
+			continue;
+		view.pieces[square.pos.ToIndex()] = (int8_t) (
+			square.piece->GetColor() * 6 + GetPieceType(*square.piece)
+		);
 	}
 
-	// If a piece is activated display its legal moves
-	if (m_ActivatedSquare.IsValid()) {
+	if (m_ActivatedSquare.IsValid() && GetPiece(m_ActivatedSquare)) {
+		view.picked = (int8_t) m_ActivatedSquare.ToIndex();
 		for (Position legalMove :
 		     GetPiece(m_ActivatedSquare)->GetLegalMoves()) {
-			if (IsSquareOccupied(legalMove)) {
-				captureSpriteInst.SetPosition(legalMove);
-				captureSpriteInst.Render();
-			} else {
-				legalMoveSpriteInst.SetPosition(legalMove);
-				legalMoveSpriteInst.Render();
-			}
+			BitBoard &targets = IsSquareOccupied(legalMove)
+			                        ? view.captureTargets
+			                        : view.moveTargets;
+			targets |= BitBoards::SquareBB(legalMove.ToIndex());
+		}
+		if (!m_MouseReleased) {
+			view.dragOffset[0] = m_DragOffset[0];
+			view.dragOffset[1] = m_DragOffset[1];
 		}
-
-		// the piece might be covered up by the background squares
-		// so render it on top
-		GetPiece(m_ActivatedSquare)->Render();
 	}
 
+	view.controlled[Black] = m_ControlledSquares[Black];
+	view.controlled[White] = m_ControlledSquares[White];
+
 	if (p_PromotionBoard) {
-		Engine::Renderer::SubmitObject(m_ShadowObj);
-		p_PromotionBoard->RenderBoard();
+		view.promoting = true;
+		view.promotionFile = (int8_t) p_PromotionBoard->GetOrigin().file;
+		view.promotionColor = p_PromotionBoard->GetColor();
 	}
-}
-
-void Board::FlipBoard(Square &square) {
-	float pos[3] = {
-		((float) square.pos.file * ((float) m_Turn * 2 - 1) -
-	     7 * ((float) m_Turn - 1)),
-		((float) square.pos.rank * ((float) m_Turn * 2 - 1) -
-	     7 * ((float) m_Turn - 1)),
-		0};
-	pos[0] = (-1 + m_SquareSize / 2) + (pos[0] * m_SquareSize);
-	pos[1] = (-1 + m_SquareSize / 2) + (pos[1] * m_SquareSize);
-	Engine::Renderer::MoveQuad(square.background, pos, m_SquareSize);
-
-	if (square.piece)
-		Engine::Renderer::MoveQuad(
-			square.piece->GetRendererObject(), pos, m_SquareSize
-		);
+	return view;
 }
 
 unsigned int Board::CalculateAllLegalMoves(std::set<Move> *legalMoves) {
 	// need to calculate both colors bc of revealed checks and such
-	m_ControlledSquares[Black].clear();
-	m_ControlledSquares[White].clear();
+	BoardState state = GetBoardState();
+	for (Color color : {Black, White}) {
+		BitBoard occupancy = state.GetOccupancy() &
+		                     ~state.GetPieces((Color) !color, KingPiece);
+		m_ControlledSquares[color] = state.GetAttacks(color, occupancy);
+	}
 
 	for (auto pos : p_PinnedPiecePos)
 		if (GetPiece(pos))
@@ -282,13 +197,6 @@ unsigned int Board::CalculateAllLegalMoves(std::set<Move> *legalMoves) {
 		if (!square.piece || dynamic_cast<EnPassantPiece *>(square.piece.get()))
 			continue;
 		square.piece->CalculateLegalMoves();
-		if (!square.piece)
-			continue;
-
-		m_ControlledSquares[square.piece->GetColor()].insert(
-			square.piece->GetControlledSquares().begin(),
-			square.piece->GetControlledSquares().end()
-		);
 	}
 
 	GetEnPassantPiece()->CalculateLegalMoves();
@@ -399,6 +307,8 @@ bool Board::MakeMove(Move move) {
 	if (!piece->Move(move.to)) // en passanting also happens in here
 		return false;
 
+	bool resetsClock = piece->GetPieceName() == "pawn";
+
 	// Capture Piece if piece exists on ending square
 	if (IsPieceCapturable(move.to, m_Turn)) {
 		if (auto ep = dynamic_cast<EnPassantPiece *>(GetPiece(move.to))) {
@@ -410,10 +320,12 @@ bool Board::MakeMove(Move move) {
 					GetNumMovesPlayed(), std::move(pawn)
 				);
 			}
-		} else
+		} else {
+			resetsClock = true;
 			m_CapturedPiecesCache[m_Turn].emplace(
 				GetNumMovesPlayed(), GetFullPiecePtr(move.to)
 			);
+		}
 	}
 
 	if (piece->GetPieceName() == "king")
@@ -426,7 +338,9 @@ bool Board::MakeMove(Move move) {
 		// TODO: do what needs to be done if pawn promotion move
 	}
 
+	m_PositionId++;
 	m_MovesPlayed.push_back(move);
+	m_HalfMoveClocks.push_back(resetsClock ? 0 : m_HalfMoveClocks.back() + 1);
 	m_Turn = (Color) !m_Turn;
 
 	return true;
@@ -434,7 +348,9 @@ bool Board::MakeMove(Move move) {
 
 void Board::UndoMove(Move move) {
 	m_Turn = (Color) !m_Turn;
+	m_PositionId++;
 	m_MovesPlayed.pop_back();
+	m_HalfMoveClocks.pop_back();
 
 	if (move.isPawnPromotionMove()) {
 		// TODO: do what needs to be undone if pawn promotion move
@@ -461,12 +377,91 @@ void Board::UndoMove(Move move) {
 	GetEnPassantPiece()->UndoMove({});
 }
 
+bool Board::PlayUserMove(Move move) {
+	SpeculativeMoves::Reply reply;
+	bool speculated = m_SpeculatedPositionId == m_PositionId;
+	bool cached = speculated && m_Speculation.Take(move.from, move.to, reply);
+
+	if (!MakeMove(move))
+		return false;
+
+	if (cached)
+		ApplySpeculativeReply(reply);
+	else
+		CalculateAllLegalMoves();
+
+	// the replies to each promotion piece are among the results for the
+	// position before the move, they stay until the piece is picked
+	if (p_PromotionBoard) {
+		m_SpeculatedPositionId = speculated ? m_PositionId : -1;
+		return true;
+	}
+
+	StartSpeculating();
+	return true;
+}
+
+void Board::FinishPromotion(int promotion) {
+	const Move &move = m_MovesPlayed.back();
+	SpeculativeMoves::Reply reply;
+	bool cached = m_SpeculatedPositionId == m_PositionId &&
+	              m_Speculation.Take(move.from, move.to, reply, promotion);
+
+	// the promoted piece changed the position without a move
+	m_PositionId++;
+
+	if (cached)
+		ApplySpeculativeReply(reply);
+	else
+		CalculateAllLegalMoves();
+
+	StartSpeculating();
+}
+
+void Board::StartSpeculating() {
+	// wait for the promotion piece to be picked, the pawn is still on the
+	// last rank until then
+	if (p_PromotionBoard) {
+		m_Speculation.Cancel();
+		return;
+	}
+
+	m_SpeculatedPositionId = m_PositionId;
+	m_Speculation.Start(GetBoardState());
+}
+
+void Board::ApplySpeculativeReply(const SpeculativeMoves::Reply &reply) {
+	m_ControlledSquares[Black] = reply.controlledSquares[Black];
+	m_ControlledSquares[White] = reply.controlledSquares[White];
+
+	// pins only matter while the pieces calculate their moves, the next
+	// full calculation finds them again
+	for (auto &pos : p_PinnedPiecePos) {
+		if (GetPiece(pos))
+			GetPiece(pos)->UnPin();
+		pos = {};
+	}
+
+	for (auto &square : m_Board)
+		if (square.piece)
+			square.piece->ClearLegalMoves();
+
+	for (BoardMove move : reply.legalMoves) {
+		// the board only needs the square once, the piece is picked later
+		if (move.IsPromotion() && move.GetPromotionType() != QueenPiece)
+			continue;
+		GetPiece(move.GetFromPosition())->AddLegalMove(move.GetToPosition());
+	}
+
+	// still has to take back an en passant offer that went unused
+	GetEnPassantPiece()->CalculateLegalMoves();
+}
+
 uint64_t Board::Perft(
 	int depth, bool printMoves, const std::function<void()> &windowUpdate
 ) {
 #ifdef DEBUG
 #	define RENDER_PERFT(x)                                                    \
-		RenderBoard();                                                         \
 		windowUpdate();                                                        \
 		std::this_thread::sleep_for(std::chrono::milliseconds(x))
 #else
@@ -506,16 +501,75 @@ uint64_t Board::Perft(
 
 void Board::GameOver() {}
 
+BoardState Board::GetBoardState() const {
+	BoardState state;
+
+	for (const auto &square : m_Board) {
+		if (!IsSquareOccupied(square.pos))
+			continue;
+
+		state.SetPiece(
+			square.pos.ToIndex(), square.piece->GetColor(),
+			GetPieceType(*square.piece)
+		);
+	}
+
+	state.SetTurn(m_Turn);
+
+	// castling needs both the king and the rook to be untouched
+	int rights = 0;
+	for (Color color : {White, Black}) {
+		auto king = dynamic_cast<King *>(GetPiece(p_KingPos[color]));
+		if (!king || !king->GetIsVirgin())
+			continue;
+
+		int backRank = color == White ? 0 : 7;
+		Piece *kingRook = GetPiece({7, backRank});
+		Piece *queenRook = GetPiece({0, backRank});
+		if (king->GetCanCastle(true) && kingRook &&
+		    kingRook->GetPieceName() == "rook" && kingRook->GetIsVirgin())
+			rights |= color == White ? BoardState::WhiteKingSide
+			                         : BoardState::BlackKingSide;
+		if (king->GetCanCastle(false) && queenRook &&
+		    queenRook->GetPieceName() == "rook" && queenRook->GetIsVirgin())
+			rights |= color == White ? BoardState::WhiteQueenSide
+			                         : BoardState::BlackQueenSide;
+	}
+	state.SetCastlingRights(rights);
+
+	if (m_EnPassantPositionPtr->IsValid())
+		state.SetEnPassantSquare(m_EnPassantPositionPtr->ToIndex());
+
+	int ply = m_StartingPly + (int) m_MovesPlayed.size();
+	state.SetMoveCounters(m_HalfMoveClocks.back(), ply / 2 + 1);
+
+	return state;
+}
+
+int Board::See(Move move) const {
+	BoardState state = GetBoardState();
+	MoveList moves;
+	state.GenerateLegalMoves(moves);
+
+	// promotions without a piece picked yet count as queening
+	int promotion =
+		move.indexOfPiecePromotedTo == -1 ? 1 : move.indexOfPiecePromotedTo;
+	for (BoardMove boardMove : moves) {
+		if (boardMove.GetFromPosition() == move.from &&
+		    boardMove.GetToPosition() == move.to &&
+		    (!boardMove.IsPromotion() ||
+		     boardMove.GetPromotionIndex() == promotion))
+			return state.See(boardMove);
+	}
+	return 0;
+}
+
 void Board::ApplyOffset(float mouseX, float mouseY) {
-	const Engine::RendererObject &pieceOBJ =
-		GetPiece(m_ActivatedSquare)->GetRendererObject();
-	float calculatedOffset[2] = {
-		mouseX - pieceOBJ.position[0], mouseY - pieceOBJ.position[1]};
-
-	// set the render offset so the piece follows the mouse
-	pieceOBJ.shader.SetUniformVec(
-		pieceOBJ.shader.GetUniformLocation("renderOffset"), 2, calculatedOffset
-	);
+	// the piece follows the mouse
+	m_DragOffset[0] = mouseX - ((-1 + m_SquareSize / 2) +
+	                            (float) m_ActivatedSquare.file * m_SquareSize);
+	m_DragOffset[1] = mouseY - ((-1 + m_SquareSize / 2) +
+	                            (float) m_ActivatedSquare.rank * m_SquareSize);
 }
 
 bool Board::HandleMouseDown(Engine::MouseButtonPressedEvent &e) {
@@ -531,8 +585,7 @@ bool Board::HandleMouseDown(Engine::MouseButtonPressedEvent &e) {
 	// if a piece is already activated, move move.to the new square (if
 	// possible)
 	if (m_ActivatedSquare != invalid &&
-	    MakeMove({m_ActivatedSquare, squarePos})) {
-		CalculateAllLegalMoves();
+	    PlayUserMove({m_ActivatedSquare, squarePos})) {
 		m_ActivatedSquare = invalid;
 	} else { // if a piece is not already selected, then select the piece
 		     // under the mouse
@@ -561,23 +614,12 @@ bool Board::HandleMouseReleased(Engine::MouseButtonReleasedEvent &e) {
 		static_cast<int>((1 + mouseX) / m_SquareSize),
 		static_cast<int>((1 + mouseY) / m_SquareSize)};
 
-	if (squarePos == m_ActivatedSquare) {
-		float offset[2] = {0, 0};
-
-		// reset piece position, so that it is on the new square
-		GetPiece(m_ActivatedSquare)
-			->GetRendererObject()
-			.shader.SetUniformVec(
-				GetPiece(m_ActivatedSquare)
-					->GetRendererObject()
-					.shader.GetUniformLocation("renderOffset"),
-				2, offset
-			);
+	// put the piece back on its square
+	m_DragOffset[0] = m_DragOffset[1] = 0;
+	if (squarePos == m_ActivatedSquare)
 		return false;
-	}
 
-	if (MakeMove({m_ActivatedSquare, squarePos}))
-		CalculateAllLegalMoves();
+	PlayUserMove({m_ActivatedSquare, squarePos});
 
 	m_ActivatedSquare = invalid;
 	return true;
@@ -603,6 +645,7 @@ bool Board::HandleKeyPressed(Engine::KeyPressedEvent &e) {
 
 	UndoMove(m_MovesPlayed.back());
 	CalculateAllLegalMoves();
+	StartSpeculating();
 	m_ActivatedSquare = {};
 
 	return true;
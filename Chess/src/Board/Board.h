@@ -3,19 +3,22 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "Engine/Events/KeyboardEvents.h"
 #include "Engine/Events/MouseEvents.h"
 #include "Engine/Layer.h"
-#include "Engine/Renderer.h"
 #include "Pieces/Piece.h"
 
+#include "BoardState.h"
+#include "BoardView.h"
+#include "SpeculativeMoves.h"
+
 #include "PromotionBoard.h"
 
 struct Square {
 	Position pos;
-	Engine::RendererObject background;
 	std::unique_ptr<Piece> piece;
 };
 
@@ -79,16 +82,18 @@ class Board
 	friend class PromotionBoard;
 
 public: // construction
-	Board(const char *vertShaderPath, const char *fragShaderPath);
+	Board();
 
-	void ReadFen(std::string fen);
+	// resets the board in place to the position, reusing the pieces that
+	// are already loaded. Returns false (leaving the board untouched) if the
+	// fen is invalid, with error (if given) set to the reason.
+	bool ReadFen(std::string_view fen, const char **error = nullptr);
 
-	void GeneratePieces(std::string fen, int i, Position &currentPos);
+	std::string ToFen() const;
 
 public: // rendering
-	void RenderBoard();
-
-	void FlipBoard(Square &square);
+	// what the board looks like right now, for the render thread
+	BoardView GetView() const;
 
 public: // calculating legal moves
 	unsigned int CalculateAllLegalMoves(std::set<Move> *legalMoves = nullptr);
@@ -119,6 +124,22 @@ public: // moving pieces
 		int depth, bool printMoves, const std::function<void()> &windowUpdate
 	);
 
+	// MakeMove for moves coming from the user: also recalculates the legal
+	// moves, straight from the speculative worker's results when it got to
+	// the move already, and starts speculating on the new position
+	bool PlayUserMove(Move move);
+
+	// once the promotion board closed with the pawn of the last move
+	// replaced (promotion as in Move::indexOfPiecePromotedTo), what
+	// PlayUserMove does after an ordinary move
+	void FinishPromotion(int promotion);
+
+	// hands the position on screen to the speculative worker
+	void StartSpeculating();
+
+private:
+	void ApplySpeculativeReply(const SpeculativeMoves::Reply &reply);
+
 public: // handling events
 	void ApplyOffset(float x, float y);
 
@@ -142,10 +163,8 @@ public: // utility functions
 	}
 
 	inline bool IsInEnemyTerritory(Position pos, Color color) const {
-		return (
-			m_ControlledSquares[!color].find(pos) !=
-			m_ControlledSquares[!color].end()
-		);
+		return pos.IsValid() &&
+		       BitBoards::Contains(m_ControlledSquares[!color], pos.ToIndex());
 	}
 
 	inline Piece *GetPiece(Position pos) const {
@@ -165,32 +184,63 @@ public: // utility functions
 		m_Board[pos.ToIndex()].piece.reset();
 	}
 
+	// a piece of the given kind at pos, taken from the pool when possible
+	std::unique_ptr<Piece>
+	AcquirePiece(Position pos, Color color, PieceType type, bool isVirgin);
+
+	// hands a piece no longer on the board back to the pool
+	void ReleasePiece(std::unique_ptr<Piece> piece);
+
 	inline Color GetTurn() { return m_Turn; }
 
 	inline int GetNumMovesPlayed() { return m_MovesPlayed.size(); }
 
 	inline BoardLayer *GetBoardLayer() { return &m_Layer; }
 
+	// snapshot of the position for the renderer free move generators
+	BoardState GetBoardState() const;
+
+	// material the move wins once every exchange on its square is played
+	// out, see BoardState::See. 0 for moves that aren't legal.
+	int See(Move move) const;
+
 private:
 	BoardLayer m_Layer;
 
-	Engine::RendererObject m_ShadowObj;
-
 	float m_SquareSize;
 	Square m_Board[64];
 	Position m_ActivatedSquare;
 	Color m_Turn;
 	bool m_MouseReleased = true;
+	// of the picked up piece from the center of its square
+	float m_DragOffset[2] = {0, 0};
 	std::unique_ptr<Piece> m_EnPassantPieceInst;
 	Position *m_EnPassantPositionPtr;
 
 	std::vector<Move> m_MovesPlayed;
-	std::set<Position> m_ControlledSquares[2] {};
+	// squares attacked by each color, sliders looking through the other
+	// color's king so that it can't step back along the ray
+	BitBoard m_ControlledSquares[2] {};
 
 	std::stack<std::pair<int, std::unique_ptr<Piece>>> m_CapturedPiecesCache[2];
 
 	std::stack<std::pair<int, std::unique_ptr<Piece>>> m_PromotedPawnsCache[2];
 
+	// pieces left over from earlier positions, by color and PieceType, so
+	// that loading a position doesn't compile any new shaders
+	std::vector<std::unique_ptr<Piece>> m_PiecePool[2][6];
+
+	// ply the loaded fen started at, for the full move number
+	int m_StartingPly = 0;
+	// half move clock after every move played, for the fifty move rule
+	std::vector<int> m_HalfMoveClocks {0};
+
+	// changes on every MakeMove/UndoMove, so that speculative results are
+	// only used for the position they were computed from
+	uint64_t m_PositionId = 0;
+	uint64_t m_SpeculatedPositionId = -1;
+	SpeculativeMoves m_Speculation;
+
 public:
 	std::unique_ptr<PromotionBoard> p_PromotionBoard = nullptr;
 
@@ -0,0 +1,169 @@
+#include "BoardRenderer.h"
+
+#include <string>
+
+#include "Pieces/SpecialPieces.h"
+
+namespace
+{
+	constexpr const char *PieceNames[6] = {"pawn", "knight", "bishop",
+	                                       "rook", "queen",  "king"};
+
+	// the promotion board's squares from the edge of the board: the pawn
+	// (to cancel) and the pieces it can become
+	constexpr PieceType PromotionPieces[5] = {
+		PawnPiece, QueenPiece, RookPiece, BishopPiece, KnightPiece
+	};
+} // namespace
+
+BoardRenderer::BoardRenderer(
+	const char *vertShaderPath, const char *fragShaderPath
+)
+	: m_SquareSize(2.f / 8.f) {
+	for (int sq = 0; sq < 64; sq++) {
+		float pos[3] = {0, 0, 0};
+		GetCenter(sq, pos);
+
+		m_Squares[sq] = Engine::Renderer::GenQuad(
+			pos, m_SquareSize, vertShaderPath, fragShaderPath
+		);
+	}
+
+	// the pieces sit at the center of the view and are moved from there
+	float center[3] = {0, 0, 0};
+	for (int piece = 0; piece < 12; piece++) {
+		std::string texturePath = "Assets/Textures/Pieces/";
+		texturePath += piece / 6 == White ? "W_" : "B_";
+		texturePath += PieceNames[piece % 6];
+		texturePath += ".png";
+
+		m_Pieces[piece] = Engine::Renderer::GenQuad(
+			center, m_SquareSize, "Assets/Shaders/Piece.vert",
+			"Assets/Shaders/Piece.frag"
+		);
+		m_Pieces[piece].shader.AttachTexture(
+			Engine::Texture(texturePath.c_str())
+		);
+	}
+
+	m_ShadowObj = Engine::Renderer::GenQuad(
+		center, m_SquareSize * 8, vertShaderPath, fragShaderPath
+	);
+
+	m_LegalMoveSprite = std::make_unique<LegalMoveSprite>(
+		m_SquareSize, m_SquareSize * 0.75f, Position {0, 0}, false
+	);
+	m_CaptureSprite = std::make_unique<LegalMoveSprite>(
+		m_SquareSize, m_SquareSize, Position {0, 0}, true
+	);
+}
+
+BoardRenderer::~BoardRenderer() {
+	for (Engine::RendererObject &square : m_Squares)
+		Engine::Renderer::DeleteQuad(square);
+	for (Engine::RendererObject &piece : m_Pieces)
+		Engine::Renderer::DeleteQuad(piece);
+	Engine::Renderer::DeleteQuad(m_ShadowObj);
+}
+
+#define SHOW_CONTROLLED_SQUARES
+
+// The squares and the shadow share one program, and the pieces and the legal
+// move sprites another, so every uniform an object needs is set right before
+// it is drawn.
+void BoardRenderer::Draw(const BoardView &view) {
+	const float noOffset[2] = {0, 0};
+
+	for (int sq = 0; sq < 64; sq++) {
+		const float *tint = nullptr;
+#ifdef SHOW_CONTROLLED_SQUARES
+		static constexpr float Both[4] = {0.8f, 0.75f, 0.35f, 1};
+		static constexpr float ByWhite[4] = {0.75f, 0.5f, 0.5f, 1};
+		static constexpr float ByBlack[4] = {0.5f, 0.75f, 0.5f, 1};
+		bool controlledByWhite =
+			BitBoards::Contains(view.controlled[White], sq);
+		bool controlledByBlack =
+			BitBoards::Contains(view.controlled[Black], sq);
+		if (controlledByWhite && controlledByBlack)
+			tint = Both;
+		else if (controlledByWhite)
+			tint = ByWhite;
+		else if (controlledByBlack)
+			tint = ByBlack;
+#endif
+		DrawSquare(sq, !((sq % 8 + sq / 8) % 2), tint);
+
+		// the picked up piece goes on top of everything, later
+		if (view.pieces[sq] != BoardView::Empty && sq != view.picked)
+			DrawPiece(view.pieces[sq], sq, noOffset);
+	}
+
+	// the legal moves of the picked up piece
+	for (int sq = 0; sq < 64; sq++) {
+		const LegalMoveSprite *sprite = nullptr;
+		if (BitBoards::Contains(view.captureTargets, sq))
+			sprite = m_CaptureSprite.get();
+		else if (BitBoards::Contains(view.moveTargets, sq))
+			sprite = m_LegalMoveSprite.get();
+		if (!sprite)
+			continue;
+		sprite->SetPosition({sq % 8, sq / 8});
+		sprite->Render();
+	}
+
+	if (view.picked >= 0 && view.pieces[view.picked] != BoardView::Empty)
+		DrawPiece(view.pieces[view.picked], view.picked, view.dragOffset);
+
+	if (view.promoting) {
+		const Engine::Shader &shader = m_ShadowObj.shader;
+		float tint[4] = {0, 0, 0, .333};
+		shader.SetUniformVec(shader.GetUniformLocation("tint"), 4, tint);
+		shader.SetUniform(shader.GetUniformLocation("tint_mix"), 1.f);
+		Engine::Renderer::SubmitObject(m_ShadowObj);
+		DrawPromotionBoard(view);
+	}
+}
+
+void BoardRenderer::DrawSquare(int square, bool isWhite, const float *tint) {
+	const Engine::Shader &shader = m_Squares[square].shader;
+	shader.SetUniform(shader.GetUniformLocation("isWhite"), isWhite);
+	if (tint)
+		shader.SetUniformVec(shader.GetUniformLocation("tint"), 4, tint);
+	shader.SetUniform(shader.GetUniformLocation("tint_mix"), tint ? .66f : 0.f);
+	Engine::Renderer::SubmitObject(m_Squares[square]);
+}
+
+void BoardRenderer::DrawPiece(int piece, int square, const float offset[2]) {
+	float position[2];
+	GetCenter(square, position);
+	position[0] += offset[0];
+	position[1] += offset[1];
+
+	const Engine::Shader &shader = m_Pieces[piece].shader;
+	const float noTint[4] = {1, 1, 1, 1};
+	shader.SetUniformVec(shader.GetUniformLocation("tint"), 4, noTint);
+	shader.SetUniformVec(
+		shader.GetUniformLocation("renderOffset"), 2, position
+	);
+	Engine::Renderer::SubmitObject(m_Pieces[piece]);
+}
+
+void BoardRenderer::DrawPromotionBoard(const BoardView &view) {
+	const float noOffset[2] = {0, 0};
+
+	for (int i = 0; i < 5; i++) {
+		int rank = view.promotionColor == White ? 7 - i : i;
+		int sq = rank * 8 + view.promotionFile;
+
+		// the promotion board is colored the other way round
+		DrawSquare(sq, (view.promotionFile + rank) % 2, nullptr);
+		DrawPiece(
+			view.promotionColor * 6 + PromotionPieces[i], sq, noOffset
+		);
+	}
+}
+
+void BoardRenderer::GetCenter(int square, float center[2]) const {
+	center[0] = (-1 + m_SquareSize / 2) + ((float) (square % 8) * m_SquareSize);
+	center[1] = (-1 + m_SquareSize / 2) + ((float) (square / 8) * m_SquareSize);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+
+#include "BoardView.h"
+#include "Engine/Renderer.h"
+
+class LegalMoveSprite;
+
+// Draws BoardViews. It owns every GL object the board is drawn with, so it
+// is made, used and destroyed on the thread that holds the GL context.
+class BoardRenderer
+{
+public:
+	BoardRenderer(const char *vertShaderPath, const char *fragShaderPath);
+
+	~BoardRenderer();
+
+	void Draw(const BoardView &view);
+
+private:
+	// tint is the color to mix in, nullptr for none
+	void DrawSquare(int square, bool isWhite, const float *tint);
+
+	// piece is a BoardView piece code, offset is added to the square center
+	void DrawPiece(int piece, int square, const float offset[2]);
+
+	void DrawPromotionBoard(const BoardView &view);
+
+	// the center of the square in view coordinates
+	void GetCenter(int square, float center[2]) const;
+
+private:
+	float m_SquareSize;
+
+	Engine::RendererObject m_Squares[64];
+	// one quad per color and piece type, moved onto every square it is
+	// drawn on with its render offset
+	Engine::RendererObject m_Pieces[12];
+	// darkens the board under the promotion board
+	Engine::RendererObject m_ShadowObj;
+
+	std::unique_ptr<LegalMoveSprite> m_LegalMoveSprite;
+	std::unique_ptr<LegalMoveSprite> m_CaptureSprite;
+};
@@ -0,0 +1,1001 @@
+#include "BoardState.h"
+#include "AttackMap.h"
+
+#include <algorithm>
+#include <iostream>
+
+using namespace BitBoards;
+
+namespace
+{
+	// castling rights that survive a move touching the square
+	constexpr auto GenCastlingMasks() {
+		std::array<uint8_t, 64> masks {};
+		for (auto &mask : masks) mask = 15;
+		masks[0] &= ~BoardState::WhiteQueenSide;
+		masks[7] &= ~BoardState::WhiteKingSide;
+		masks[4] &= ~(BoardState::WhiteKingSide | BoardState::WhiteQueenSide);
+		masks[56] &= ~BoardState::BlackQueenSide;
+		masks[63] &= ~BoardState::BlackKingSide;
+		masks[60] &= ~(BoardState::BlackKingSide | BoardState::BlackQueenSide);
+		return masks;
+	}
+
+	constexpr std::array<uint8_t, 64> CastlingMasks = GenCastlingMasks();
+
+	struct ZobristKeys {
+		uint64_t pieces[2][6][64];
+		uint64_t castling[16];
+		uint64_t enPassantFile[8];
+		// xored in when black is to move
+		uint64_t blackToMove;
+	};
+
+	constexpr ZobristKeys GenZobristKeys() {
+		// splitmix64, any fixed sequence of well mixed numbers will do
+		uint64_t seed = 0x9E3779B97F4A7C15ULL;
+		auto next = [&seed]() {
+			uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			return z ^ (z >> 31);
+		};
+
+		ZobristKeys keys {};
+		for (auto &color : keys.pieces)
+			for (auto &type : color)
+				for (auto &key : type) key = next();
+		// every right gets its own key, combinations are their xor
+		uint64_t rights[4] = {next(), next(), next(), next()};
+		for (int i = 0; i < 16; i++)
+			for (int right = 0; right < 4; right++)
+				if (i & (1 << right))
+					keys.castling[i] ^= rights[right];
+		for (auto &key : keys.enPassantFile) key = next();
+		keys.blackToMove = next();
+		return keys;
+	}
+
+	constexpr ZobristKeys Zobrist = GenZobristKeys();
+
+	// fen letters of the black pieces, indexed by PieceType
+	constexpr char PieceChars[] = "pnbrqk";
+
+	// -1 if c isn't a piece letter
+	constexpr int PieceFromChar(char c) {
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		for (int type = PawnPiece; type <= KingPiece; type++)
+			if (PieceChars[type] == c)
+				return type;
+		return -1;
+	}
+} // namespace
+
+std::string BoardMove::ToString() const {
+	std::string str = GetFromPosition().ToString() + GetToPosition().ToString();
+	if (IsPromotion())
+		str += "nbrq"[Flags() & 3];
+	return str;
+}
+
+BoardState::BoardState() {
+	Clear();
+	// enough for a long game plus a search on top of it, MakeMove only
+	// allocates past that
+	m_History.reserve(256);
+}
+
+void BoardState::Clear() {
+	for (auto &color : m_Pieces)
+		for (auto &pieces : color) pieces = 0;
+	m_Occupancy[Black] = m_Occupancy[White] = 0;
+	for (auto &square : m_Squares) square = NoPiece;
+
+	m_Turn = White;
+	m_CastlingRights = 0;
+	m_EnPassantSquare = -1;
+	m_HalfMoveClock = 0;
+	m_FullMoveNumber = 1;
+	m_PliesFromNull = 0;
+	m_Key = 0;
+	m_PawnKey = 0;
+	m_Psqt = {};
+	m_Phase = 0;
+	m_History.clear();
+}
+
+void BoardState::SetPiece(int sq, Color color, PieceType type) {
+	RemovePiece(sq);
+	m_Pieces[color][type] |= SquareBB(sq);
+	m_Occupancy[color] |= SquareBB(sq);
+	m_Squares[sq] = type;
+	m_Key ^= Zobrist.pieces[color][type][sq];
+	if (type == PawnPiece)
+		m_PawnKey ^= Zobrist.pieces[color][PawnPiece][sq];
+	m_Psqt += PieceSquareTables::Scores[color][type][sq];
+	m_Phase += PieceSquareTables::PhaseWeights[type];
+}
+
+void BoardState::RemovePiece(int sq) {
+	if (m_Squares[sq] == NoPiece)
+		return;
+
+	Color color = GetPieceColor(sq);
+	m_Pieces[color][m_Squares[sq]] &= ~SquareBB(sq);
+	m_Occupancy[color] &= ~SquareBB(sq);
+	m_Key ^= Zobrist.pieces[color][m_Squares[sq]][sq];
+	if (m_Squares[sq] == PawnPiece)
+		m_PawnKey ^= Zobrist.pieces[color][PawnPiece][sq];
+	m_Psqt -= PieceSquareTables::Scores[color][m_Squares[sq]][sq];
+	m_Phase -= PieceSquareTables::PhaseWeights[m_Squares[sq]];
+	m_Squares[sq] = NoPiece;
+}
+
+void BoardState::MovePiece(int from, int to) {
+	BitBoard fromTo = SquareBB(from) | SquareBB(to);
+	Color color = GetPieceColor(from);
+	m_Pieces[color][m_Squares[from]] ^= fromTo;
+	m_Occupancy[color] ^= fromTo;
+	m_Key ^= Zobrist.pieces[color][m_Squares[from]][from] ^
+	         Zobrist.pieces[color][m_Squares[from]][to];
+	if (m_Squares[from] == PawnPiece)
+		m_PawnKey ^= Zobrist.pieces[color][PawnPiece][from] ^
+		             Zobrist.pieces[color][PawnPiece][to];
+	m_Psqt -= PieceSquareTables::Scores[color][m_Squares[from]][from];
+	m_Psqt += PieceSquareTables::Scores[color][m_Squares[from]][to];
+	m_Squares[to] = m_Squares[from];
+	m_Squares[from] = NoPiece;
+}
+
+///////////////////////////////////// Fen //////////////////////////////////////
+
+bool BoardState::ReadFen(std::string_view fen, const char **error) {
+	Clear();
+
+	size_t i = 0;
+	auto skipSpaces = [&]() {
+		while (i < fen.size() && fen[i] == ' ') i++;
+	};
+	auto atFieldEnd = [&]() { return i == fen.size() || fen[i] == ' '; };
+	auto fail = [&](const char *reason) {
+		if (error)
+			*error = reason;
+		Clear();
+		return false;
+	};
+
+	skipSpaces();
+
+	// piece placement, a8 to h8 down to a1 to h1
+	int rank = 7, file = 0;
+	for (; !atFieldEnd(); i++) {
+		char c = fen[i];
+		if (c == '/') {
+			if (file != 8 || rank == 0)
+				return fail("bad rank");
+			rank--;
+			file = 0;
+		} else if (c >= '1' && c <= '8') {
+			file += c - '0';
+			if (file > 8)
+				return fail("bad rank");
+		} else {
+			int type = PieceFromChar(c);
+			if (type < 0 || file == 8)
+				return fail("bad piece");
+			SetPiece(rank * 8 + file++, (Color) (c < 'a'), (PieceType) type);
+		}
+	}
+	if (rank != 0 || file != 8)
+		return fail("bad board");
+
+	// active color
+	skipSpaces();
+	if (i == fen.size() || (fen[i] != 'w' && fen[i] != 'b'))
+		return fail("bad active color");
+	m_Turn = fen[i++] == 'w' ? White : Black;
+	if (!atFieldEnd())
+		return fail("bad active color");
+
+	// castling rights, in any order
+	skipSpaces();
+	if (i == fen.size())
+		return fail("missing castling rights");
+	if (fen[i] == '-') {
+		i++;
+	} else {
+		for (; !atFieldEnd(); i++) {
+			switch (fen[i]) {
+			case 'K': m_CastlingRights |= WhiteKingSide; break;
+			case 'Q': m_CastlingRights |= WhiteQueenSide; break;
+			case 'k': m_CastlingRights |= BlackKingSide; break;
+			case 'q': m_CastlingRights |= BlackQueenSide; break;
+			default: return fail("bad castling rights");
+			}
+		}
+	}
+	if (!atFieldEnd())
+		return fail("bad castling rights");
+
+	// en passant square
+	skipSpaces();
+	if (i == fen.size())
+		return fail("missing en passant square");
+	if (fen[i] == '-') {
+		i++;
+	} else {
+		if (i + 1 >= fen.size() || fen[i] < 'a' || fen[i] > 'h' ||
+		    fen[i + 1] != (m_Turn == White ? '6' : '3'))
+			return fail("bad en passant square");
+		m_EnPassantSquare = (fen[i + 1] - '1') * 8 + (fen[i] - 'a');
+		i += 2;
+	}
+	if (!atFieldEnd())
+		return fail("bad en passant square");
+
+	// move counters, missing in epd where operations may follow instead
+	auto readNumber = [&](int &number) {
+		skipSpaces();
+		size_t start = i;
+		int value = 0;
+		while (i < fen.size() && fen[i] >= '0' && fen[i] <= '9' && value < 1000000)
+			value = value * 10 + (fen[i++] - '0');
+		if (i == start || !atFieldEnd()) {
+			i = start;
+			return false;
+		}
+		number = value;
+		return true;
+	};
+	if (readNumber(m_HalfMoveClock))
+		readNumber(m_FullMoveNumber);
+	if (m_FullMoveNumber < 1)
+		m_FullMoveNumber = 1;
+
+	// the position itself has to be legal
+	for (Color color : {Black, White})
+		if (PopCount(m_Pieces[color][KingPiece]) != 1)
+			return fail("need exactly one king per side");
+	if ((m_Pieces[Black][PawnPiece] | m_Pieces[White][PawnPiece]) &
+	    (Rank1 | Rank8))
+		return fail("pawn on the back rank");
+	if (IsSquareAttacked(
+			GetKingSquare((Color) !m_Turn), m_Turn, GetOccupancy()
+		))
+		return fail("side not to move is in check");
+
+	// drop castling rights that no longer have their king and rook
+	auto hasPiece = [&](int sq, Color color, PieceType type) {
+		return Contains(m_Pieces[color][type], sq);
+	};
+	if (!hasPiece(4, White, KingPiece))
+		m_CastlingRights &= ~(WhiteKingSide | WhiteQueenSide);
+	if (!hasPiece(7, White, RookPiece))
+		m_CastlingRights &= ~WhiteKingSide;
+	if (!hasPiece(0, White, RookPiece))
+		m_CastlingRights &= ~WhiteQueenSide;
+	if (!hasPiece(60, Black, KingPiece))
+		m_CastlingRights &= ~(BlackKingSide | BlackQueenSide);
+	if (!hasPiece(63, Black, RookPiece))
+		m_CastlingRights &= ~BlackKingSide;
+	if (!hasPiece(56, Black, RookPiece))
+		m_CastlingRights &= ~BlackQueenSide;
+
+	// and en passant squares that no pawn could have just passed over
+	if (m_EnPassantSquare >= 0) {
+		Color them = (Color) !m_Turn;
+		int pushed = m_EnPassantSquare + (m_Turn == White ? South : North);
+		int start = m_EnPassantSquare + (m_Turn == White ? North : South);
+		if (!hasPiece(pushed, them, PawnPiece) ||
+		    m_Squares[m_EnPassantSquare] != NoPiece ||
+		    m_Squares[start] != NoPiece)
+			m_EnPassantSquare = -1;
+	}
+
+	m_Key = ComputeKey();
+	return true;
+}
+
+uint64_t BoardState::ComputeKey() const {
+	uint64_t key = 0;
+	for (int sq = 0; sq < 64; sq++)
+		if (m_Squares[sq] != NoPiece)
+			key ^= Zobrist.pieces[GetPieceColor(sq)][m_Squares[sq]][sq];
+
+	key ^= Zobrist.castling[m_CastlingRights];
+	key ^= EnPassantKey();
+	if (m_Turn == Black)
+		key ^= Zobrist.blackToMove;
+	return key;
+}
+
+uint64_t BoardState::ComputePawnKey() const {
+	uint64_t key = 0;
+	for (int color = Black; color <= White; color++) {
+		BitBoard pawns = m_Pieces[color][PawnPiece];
+		while (pawns) key ^= Zobrist.pieces[color][PawnPiece][PopLowest(pawns)];
+	}
+	return key;
+}
+
+uint64_t BoardState::EnPassantKey() const {
+	// positions that only differ by an en passant square nobody can use are
+	// the same position
+	if (m_EnPassantSquare < 0 ||
+	    !(PawnAttacks[!m_Turn][m_EnPassantSquare] &
+	      m_Pieces[m_Turn][PawnPiece]))
+		return 0;
+	return Zobrist.enPassantFile[m_EnPassantSquare % 8];
+}
+
+TaperedScore BoardState::ComputePsqt() const {
+	TaperedScore psqt;
+	for (int sq = 0; sq < 64; sq++) {
+		if (m_Squares[sq] == NoPiece)
+			continue;
+		Color color = GetPieceColor(sq);
+		psqt += PieceSquareTables::Scores[color][m_Squares[sq]][sq];
+	}
+	return psqt;
+}
+
+int BoardState::ComputePhase() const {
+	int phase = 0;
+	for (int sq = 0; sq < 64; sq++)
+		if (m_Squares[sq] != NoPiece)
+			phase += PieceSquareTables::PhaseWeights[m_Squares[sq]];
+	return phase;
+}
+
+void BoardState::VerifyPsqt() const {
+	if (m_Psqt != ComputePsqt() || m_Phase != ComputePhase())
+		std::cout << "Incremental evaluation out of sync: " << ToFen()
+				  << std::endl;
+}
+
+std::string BoardState::ToFen() const {
+	std::string fen;
+	fen.reserve(96);
+
+	for (int rank = 7; rank >= 0; rank--) {
+		int empty = 0;
+		for (int file = 0; file < 8; file++) {
+			int sq = rank * 8 + file;
+			if (m_Squares[sq] == NoPiece) {
+				empty++;
+				continue;
+			}
+			if (empty)
+				fen += (char) ('0' + empty);
+			empty = 0;
+
+			char c = PieceChars[m_Squares[sq]];
+			fen += GetPieceColor(sq) == White ? (char) (c - 'a' + 'A') : c;
+		}
+		if (empty)
+			fen += (char) ('0' + empty);
+		if (rank)
+			fen += '/';
+	}
+
+	fen += m_Turn == White ? " w " : " b ";
+
+	if (!m_CastlingRights)
+		fen += '-';
+	if (m_CastlingRights & WhiteKingSide)
+		fen += 'K';
+	if (m_CastlingRights & WhiteQueenSide)
+		fen += 'Q';
+	if (m_CastlingRights & BlackKingSide)
+		fen += 'k';
+	if (m_CastlingRights & BlackQueenSide)
+		fen += 'q';
+
+	fen += ' ';
+	if (m_EnPassantSquare >= 0) {
+		fen += (char) ('a' + m_EnPassantSquare % 8);
+		fen += (char) ('1' + m_EnPassantSquare / 8);
+	} else {
+		fen += '-';
+	}
+
+	fen += ' ';
+	fen += std::to_string(m_HalfMoveClock);
+	fen += ' ';
+	fen += std::to_string(m_FullMoveNumber);
+	return fen;
+}
+
+/////////////////////////////////// Attacks ////////////////////////////////////
+
+BitBoard BoardState::AttackersTo(int sq, BitBoard occupancy) const {
+	BitBoard rooks = m_Pieces[Black][RookPiece] | m_Pieces[White][RookPiece] |
+	                 m_Pieces[Black][QueenPiece] | m_Pieces[White][QueenPiece];
+	BitBoard bishops = m_Pieces[Black][BishopPiece] |
+	                   m_Pieces[White][BishopPiece] |
+	                   m_Pieces[Black][QueenPiece] | m_Pieces[White][QueenPiece];
+
+	return (PawnAttacks[White][sq] & m_Pieces[Black][PawnPiece]) |
+	       (PawnAttacks[Black][sq] & m_Pieces[White][PawnPiece]) |
+	       (KnightAttacks[sq] &
+	        (m_Pieces[Black][KnightPiece] | m_Pieces[White][KnightPiece])) |
+	       (KingAttacks[sq] &
+	        (m_Pieces[Black][KingPiece] | m_Pieces[White][KingPiece])) |
+	       (RookAttacks(sq, occupancy) & rooks) |
+	       (BishopAttacks(sq, occupancy) & bishops);
+}
+
+bool BoardState::IsSquareAttacked(int sq, Color by, BitBoard occupancy) const {
+	const BitBoard *pieces = m_Pieces[by];
+	return (PawnAttacks[!by][sq] & pieces[PawnPiece]) ||
+	       (KnightAttacks[sq] & pieces[KnightPiece]) ||
+	       (KingAttacks[sq] & pieces[KingPiece]) ||
+	       (RookAttacks(sq, occupancy) &
+	        (pieces[RookPiece] | pieces[QueenPiece])) ||
+	       (BishopAttacks(sq, occupancy) &
+	        (pieces[BishopPiece] | pieces[QueenPiece]));
+}
+
+int BoardState::See(BoardMove move) const {
+	if (move.IsCastle())
+		return 0;
+
+	int from = move.From(), to = move.To();
+	BitBoard occupancy = GetOccupancy() ^ SquareBB(from);
+
+	// gain[d] is the balance after capture d for the side making it
+	int gain[32];
+	int d = 0;
+	if (move.Flags() == BoardMove::EnPassant) {
+		gain[0] = SeeValues[PawnPiece];
+		occupancy ^= SquareBB(to + (GetPieceColor(from) ? South : North));
+	} else {
+		gain[0] = SeeValues[m_Squares[to]];
+	}
+
+	int onSquare = m_Squares[from];
+	if (move.IsPromotion()) {
+		onSquare = move.GetPromotionType();
+		gain[0] += SeeValues[onSquare] - SeeValues[PawnPiece];
+	}
+
+	BitBoard diagonal = m_Pieces[Black][BishopPiece] |
+	                    m_Pieces[White][BishopPiece] |
+	                    m_Pieces[Black][QueenPiece] | m_Pieces[White][QueenPiece];
+	BitBoard straight = m_Pieces[Black][RookPiece] | m_Pieces[White][RookPiece] |
+	                    m_Pieces[Black][QueenPiece] | m_Pieces[White][QueenPiece];
+
+	BitBoard attackers = AttackersTo(to, occupancy) & occupancy;
+	Color side = (Color) !GetPieceColor(from);
+
+	do {
+		// what the side to capture gets if it takes and nothing comes back
+		d++;
+		gain[d] = SeeValues[onSquare] - gain[d - 1];
+
+		BitBoard ours = attackers & m_Occupancy[side];
+		if (!ours)
+			break;
+
+		// recapture with the least valuable attacker
+		int type = PawnPiece;
+		while (!(ours & m_Pieces[side][type])) type++;
+		occupancy ^= SquareBB(LowestSquare(ours & m_Pieces[side][type]));
+		onSquare = type;
+
+		// sliders behind it can now see the square
+		attackers |= (BishopAttacks(to, occupancy) & diagonal) |
+		             (RookAttacks(to, occupancy) & straight);
+		attackers &= occupancy;
+		side = (Color) !side;
+	} while (d < 31);
+
+	// the last gain was never played, then let each side pick between
+	// capturing and standing pat from the back
+	while (--d) gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+	return gain[0];
+}
+
+BitBoard BoardState::GetAttacks(Color by, BitBoard occupancy) const {
+	return AttackMap::SideAttacks(m_Pieces[by], by, occupancy);
+}
+
+BitBoard BoardState::GetPinnedPieces() const {
+	Color them = (Color) !m_Turn;
+	int kingSq = GetKingSquare(m_Turn);
+	BitBoard occupancy = GetOccupancy();
+
+	// enemy sliders that would see the king on an empty board
+	BitBoard snipers =
+		(RookAttacks(kingSq, 0) &
+	     (m_Pieces[them][RookPiece] | m_Pieces[them][QueenPiece])) |
+		(BishopAttacks(kingSq, 0) &
+	     (m_Pieces[them][BishopPiece] | m_Pieces[them][QueenPiece]));
+
+	BitBoard pinned = 0;
+	while (snipers) {
+		BitBoard blockers = Between[kingSq][PopLowest(snipers)] & occupancy;
+		if (PopCount(blockers) == 1)
+			pinned |= blockers & m_Occupancy[m_Turn];
+	}
+	return pinned;
+}
+
+void BoardState::GenerateLegalMoves(MoveList &moves) const {
+	moves.size = 0;
+
+	Color us = m_Turn, them = (Color) !m_Turn;
+	int kingSq = GetKingSquare(us);
+	BitBoard occupancy = GetOccupancy();
+	BitBoard checkers = AttackersTo(kingSq, occupancy) & m_Occupancy[them];
+
+	// the king can't hide behind itself from a slider, so take it off the
+	// board while testing its destination squares
+	BitBoard kingTargets = KingAttacks[kingSq] & ~m_Occupancy[us];
+	while (kingTargets) {
+		int to = PopLowest(kingTargets);
+		if (!IsSquareAttacked(to, them, occupancy ^ SquareBB(kingSq)))
+			moves.Add(
+				{kingSq, to,
+			     Contains(m_Occupancy[them], to) ? BoardMove::Capture
+			                                     : BoardMove::Quiet}
+			);
+	}
+
+	if (PopCount(checkers) > 1)
+		return; // only the king can get out of a double check
+
+	// squares that either capture the checker or block the check
+	BitBoard checkMask = All;
+	if (checkers)
+		checkMask = checkers | Between[kingSq][LowestSquare(checkers)];
+	else
+		GenerateCastlingMoves(moves);
+
+	BitBoard pinned = GetPinnedPieces();
+	BitBoard targets = ~m_Occupancy[us] & checkMask;
+
+	GeneratePawnMoves(moves, checkMask, pinned, kingSq);
+
+	for (int type = KnightPiece; type <= QueenPiece; type++) {
+		BitBoard pieces = m_Pieces[us][type];
+		while (pieces) {
+			int from = PopLowest(pieces);
+
+			BitBoard attacks;
+			switch (type) {
+			case KnightPiece: attacks = KnightAttacks[from]; break;
+			case BishopPiece: attacks = BishopAttacks(from, occupancy); break;
+			case RookPiece: attacks = RookAttacks(from, occupancy); break;
+			default: attacks = QueenAttacks(from, occupancy); break;
+			}
+
+			attacks &= targets;
+			if (Contains(pinned, from))
+				attacks &= Line[kingSq][from];
+
+			while (attacks) {
+				int to = PopLowest(attacks);
+				moves.Add(
+					{from, to,
+				     Contains(m_Occupancy[them], to) ? BoardMove::Capture
+				                                     : BoardMove::Quiet}
+				);
+			}
+		}
+	}
+}
+
+void BoardState::GeneratePawnMoves(
+	MoveList &moves, BitBoard checkMask, BitBoard pinned, int kingSq
+) const {
+	Color us = m_Turn, them = (Color) !m_Turn;
+	BitBoard pawns = m_Pieces[us][PawnPiece];
+	BitBoard empty = ~GetOccupancy();
+	BitBoard lastRank = us ? Rank8 : Rank1;
+	BitBoard doublePushRank = us ? Rank3 : Rank6;
+	int forward = us ? North : South;
+
+	auto addMoves = [&](int from, BitBoard destinations, bool capture) {
+		if (Contains(pinned, from))
+			destinations &= Line[kingSq][from];
+
+		while (destinations) {
+			int to = PopLowest(destinations);
+			if (Contains(lastRank, to)) {
+				int flags = capture ? BoardMove::PromotionCapture
+				                    : BoardMove::Promotion;
+				// queen first, it is by far the most likely choice
+				for (int piece = 3; piece >= 0; piece--)
+					moves.Add({from, to, flags | piece});
+			} else {
+				moves.Add({from, to, capture ? BoardMove::Capture : 0});
+			}
+		}
+	};
+
+	while (pawns) {
+		int from = PopLowest(pawns);
+
+		BitBoard single = SquareBB(from + forward) & empty;
+		BitBoard pushes = single;
+		if (single & doublePushRank) {
+			BitBoard twice = SquareBB(from + 2 * forward) & empty & checkMask;
+			if (twice && (!Contains(pinned, from) ||
+			              Contains(Line[kingSq][from], from + 2 * forward)))
+				moves.Add({from, from + 2 * forward, BoardMove::DoublePush});
+		}
+		addMoves(from, pushes & checkMask, false);
+
+		addMoves(
+			from, PawnAttacks[us][from] & m_Occupancy[them] & checkMask, true
+		);
+
+		if (m_EnPassantSquare >= 0 &&
+		    Contains(PawnAttacks[us][from], m_EnPassantSquare) &&
+		    IsLegalEnPassant(from))
+			moves.Add({from, m_EnPassantSquare, BoardMove::EnPassant});
+	}
+}
+
+bool BoardState::IsLegalEnPassant(int from) const {
+	Color us = m_Turn, them = (Color) !m_Turn;
+	int to = m_EnPassantSquare;
+	int captured = to + (us ? South : North);
+	int kingSq = GetKingSquare(us);
+
+	// play the capture on a copy of the occupancy and see if anything
+	// (other than the captured pawn) can still reach the king
+	BitBoard occupancy = (GetOccupancy() ^ SquareBB(from) ^ SquareBB(captured)) |
+	                     SquareBB(to);
+	BitBoard attackers = AttackersTo(kingSq, occupancy) & m_Occupancy[them] &
+	                     ~SquareBB(captured);
+	return !attackers;
+}
+
+void BoardState::GenerateCastlingMoves(MoveList &moves) const {
+	Color us = m_Turn, them = (Color) !m_Turn;
+	BitBoard occupancy = GetOccupancy();
+	int kingSq = us ? 4 : 60;
+
+	int kingSide = us ? WhiteKingSide : BlackKingSide;
+	int queenSide = us ? WhiteQueenSide : BlackQueenSide;
+
+	if ((m_CastlingRights & kingSide) &&
+	    !(occupancy & (SquareBB(kingSq + 1) | SquareBB(kingSq + 2))) &&
+	    !IsSquareAttacked(kingSq + 1, them, occupancy) &&
+	    !IsSquareAttacked(kingSq + 2, them, occupancy))
+		moves.Add({kingSq, kingSq + 2, BoardMove::KingCastle});
+
+	if ((m_CastlingRights & queenSide) &&
+	    !(occupancy & (SquareBB(kingSq - 1) | SquareBB(kingSq - 2) |
+	                   SquareBB(kingSq - 3))) &&
+	    !IsSquareAttacked(kingSq - 1, them, occupancy) &&
+	    !IsSquareAttacked(kingSq - 2, them, occupancy))
+		moves.Add({kingSq, kingSq - 2, BoardMove::QueenCastle});
+}
+
+void BoardState::GenerateCaptures(MoveList &moves) const {
+	Color us = m_Turn, them = (Color) !m_Turn;
+	BitBoard occupancy = GetOccupancy();
+	BitBoard enemies = m_Occupancy[them];
+	BitBoard lastRank = us ? Rank8 : Rank1;
+	int forward = us ? North : South;
+
+	BitBoard pawns = m_Pieces[us][PawnPiece];
+	while (pawns) {
+		int from = PopLowest(pawns);
+
+		BitBoard targets = PawnAttacks[us][from] & enemies;
+		while (targets) {
+			int to = PopLowest(targets);
+			if (Contains(lastRank, to)) {
+				for (int piece = 3; piece >= 0; piece--)
+					moves.Add({from, to, BoardMove::PromotionCapture | piece});
+			} else {
+				moves.Add({from, to, BoardMove::Capture});
+			}
+		}
+
+		int push = from + forward;
+		if (Contains(lastRank, push) && !Contains(occupancy, push))
+			moves.Add({from, push, BoardMove::Promotion | 3});
+
+		if (m_EnPassantSquare >= 0 &&
+		    Contains(PawnAttacks[us][from], m_EnPassantSquare))
+			moves.Add({from, m_EnPassantSquare, BoardMove::EnPassant});
+	}
+
+	for (int type = KnightPiece; type <= KingPiece; type++) {
+		BitBoard pieces = m_Pieces[us][type];
+		while (pieces) {
+			int from = PopLowest(pieces);
+			BitBoard targets =
+				PieceAttacks((PieceType) type, from, occupancy) & enemies;
+			while (targets)
+				moves.Add({from, PopLowest(targets), BoardMove::Capture});
+		}
+	}
+}
+
+void BoardState::GenerateQuiets(MoveList &moves) const {
+	Color us = m_Turn;
+	BitBoard occupancy = GetOccupancy();
+	BitBoard lastRank = us ? Rank8 : Rank1;
+	BitBoard doublePushRank = us ? Rank3 : Rank6;
+	int forward = us ? North : South;
+
+	BitBoard pawns = m_Pieces[us][PawnPiece];
+	while (pawns) {
+		int from = PopLowest(pawns);
+		int push = from + forward;
+		if (Contains(occupancy, push))
+			continue;
+
+		if (Contains(lastRank, push)) {
+			// the queen promotion goes with the captures
+			for (int piece = 2; piece >= 0; piece--)
+				moves.Add({from, push, BoardMove::Promotion | piece});
+			continue;
+		}
+
+		moves.Add({from, push});
+		if (Contains(doublePushRank, push) &&
+		    !Contains(occupancy, push + forward))
+			moves.Add({from, push + forward, BoardMove::DoublePush});
+	}
+
+	for (int type = KnightPiece; type <= KingPiece; type++) {
+		BitBoard pieces = m_Pieces[us][type];
+		while (pieces) {
+			int from = PopLowest(pieces);
+			BitBoard targets =
+				PieceAttacks((PieceType) type, from, occupancy) & ~occupancy;
+			while (targets) moves.Add({from, PopLowest(targets)});
+		}
+	}
+
+	if (!IsInCheck())
+		GenerateCastlingMoves(moves);
+}
+
+bool BoardState::IsPseudoLegal(BoardMove move) const {
+	if (move.IsNull())
+		return false;
+
+	Color us = m_Turn, them = (Color) !m_Turn;
+	int from = move.From(), to = move.To(), flags = move.Flags();
+	if (!Contains(m_Occupancy[us], from) || Contains(m_Occupancy[us], to))
+		return false;
+
+	if (move.IsCastle()) {
+		if (m_Squares[from] != KingPiece || IsInCheck())
+			return false;
+		MoveList castles;
+		GenerateCastlingMoves(castles);
+		return std::find(castles.begin(), castles.end(), move) != castles.end();
+	}
+
+	BitBoard occupancy = GetOccupancy();
+	bool capture = Contains(m_Occupancy[them], to);
+
+	if (m_Squares[from] != PawnPiece) {
+		return (flags == BoardMove::Quiet || flags == BoardMove::Capture) &&
+		       capture == (flags == BoardMove::Capture) &&
+		       Contains(
+				   PieceAttacks((PieceType) m_Squares[from], from, occupancy),
+				   to
+			   );
+	}
+
+	int forward = us ? North : South;
+	if (flags == BoardMove::EnPassant)
+		return to == m_EnPassantSquare && Contains(PawnAttacks[us][from], to);
+
+	if (flags == BoardMove::DoublePush)
+		return to == from + 2 * forward &&
+		       Contains(us ? Rank2 : Rank7, from) &&
+		       !Contains(occupancy, from + forward) && !Contains(occupancy, to);
+
+	// promotions exactly when reaching the last rank
+	if (move.IsPromotion() != Contains(us ? Rank8 : Rank1, to) ||
+	    (!move.IsPromotion() && flags != BoardMove::Quiet &&
+	     flags != BoardMove::Capture))
+		return false;
+
+	if (move.IsCapture())
+		return capture && Contains(PawnAttacks[us][from], to);
+	return to == from + forward && !Contains(occupancy, to);
+}
+
+bool BoardState::IsLegal(BoardMove move, BitBoard pinned) const {
+	int from = move.From(), to = move.To();
+	int kingSq = GetKingSquare(m_Turn);
+
+	// castling is checked completely when it is generated
+	if (from == kingSq)
+		return move.IsCastle() ||
+		       !IsSquareAttacked(
+				   to, (Color) !m_Turn, GetOccupancy() ^ SquareBB(from)
+			   );
+
+	if (move.Flags() == BoardMove::EnPassant)
+		return IsLegalEnPassant(from);
+
+	return !Contains(pinned, from) || Contains(Line[kingSq][from], to);
+}
+
+unsigned int BoardState::CountLegalMoves() const {
+	MoveList moves;
+	GenerateLegalMoves(moves);
+	return moves.size;
+}
+
+void BoardState::MakeMove(BoardMove move) {
+	int from = move.From(), to = move.To(), flags = move.Flags();
+	Color us = m_Turn;
+
+	m_History.push_back(
+		{(uint8_t) m_CastlingRights, (int8_t) m_EnPassantSquare, NoPiece,
+	     (uint16_t) m_HalfMoveClock, (uint16_t) m_PliesFromNull, m_Key}
+	);
+	UndoInfo &undo = m_History.back();
+
+	m_Key ^= EnPassantKey();
+
+	bool resetsClock = m_Squares[from] == PawnPiece;
+
+	if (flags == BoardMove::EnPassant) {
+		undo.captured = PawnPiece;
+		RemovePiece(to + (us ? South : North));
+	} else if (move.IsCapture()) {
+		undo.captured = m_Squares[to];
+		RemovePiece(to);
+		resetsClock = true;
+	}
+
+	MovePiece(from, to);
+
+	if (move.IsPromotion())
+		SetPiece(to, us, move.GetPromotionType());
+	else if (flags == BoardMove::KingCastle)
+		MovePiece(to + 1, to - 1);
+	else if (flags == BoardMove::QueenCastle)
+		MovePiece(to - 2, to + 1);
+
+	m_EnPassantSquare = flags == BoardMove::DoublePush ? (from + to) / 2 : -1;
+	m_Key ^= Zobrist.castling[m_CastlingRights];
+	m_CastlingRights &= CastlingMasks[from] & CastlingMasks[to];
+	m_Key ^= Zobrist.castling[m_CastlingRights];
+	m_HalfMoveClock = resetsClock ? 0 : m_HalfMoveClock + 1;
+	m_PliesFromNull++;
+	if (us == Black)
+		m_FullMoveNumber++;
+
+	m_Turn = (Color) !m_Turn;
+	m_Key ^= Zobrist.blackToMove ^ EnPassantKey();
+
+#ifdef DEBUG
+	VerifyPsqt();
+#endif
+}
+
+void BoardState::UndoMove(BoardMove move) {
+	int from = move.From(), to = move.To(), flags = move.Flags();
+
+	m_Turn = (Color) !m_Turn;
+	Color us = m_Turn;
+	if (us == Black)
+		m_FullMoveNumber--;
+
+	UndoInfo undo = m_History.back();
+	m_History.pop_back();
+
+	if (move.IsPromotion())
+		SetPiece(to, us, PawnPiece);
+	else if (flags == BoardMove::KingCastle)
+		MovePiece(to - 1, to + 1);
+	else if (flags == BoardMove::QueenCastle)
+		MovePiece(to + 1, to - 2);
+
+	MovePiece(to, from);
+
+	if (flags == BoardMove::EnPassant)
+		SetPiece(to + (us ? South : North), (Color) !us, PawnPiece);
+	else if (undo.captured != NoPiece)
+		SetPiece(to, (Color) !us, (PieceType) undo.captured);
+
+	m_CastlingRights = undo.castlingRights;
+	m_EnPassantSquare = undo.enPassantSquare;
+	m_HalfMoveClock = undo.halfMoveClock;
+	m_PliesFromNull = undo.pliesFromNull;
+	m_Key = undo.key;
+
+#ifdef DEBUG
+	VerifyPsqt();
+#endif
+}
+
+void BoardState::MakeNullMove() {
+	m_History.push_back(
+		{(uint8_t) m_CastlingRights, (int8_t) m_EnPassantSquare, NoPiece,
+	     (uint16_t) m_HalfMoveClock, (uint16_t) m_PliesFromNull, m_Key}
+	);
+
+	m_Key ^= EnPassantKey();
+	m_EnPassantSquare = -1;
+	m_HalfMoveClock++;
+	m_PliesFromNull = 0;
+	if (m_Turn == Black)
+		m_FullMoveNumber++;
+
+	m_Turn = (Color) !m_Turn;
+	m_Key ^= Zobrist.blackToMove;
+}
+
+void BoardState::UndoNullMove() {
+	m_Turn = (Color) !m_Turn;
+	if (m_Turn == Black)
+		m_FullMoveNumber--;
+
+	UndoInfo undo = m_History.back();
+	m_History.pop_back();
+
+	m_EnPassantSquare = undo.enPassantSquare;
+	m_HalfMoveClock = undo.halfMoveClock;
+	m_PliesFromNull = undo.pliesFromNull;
+	m_Key = undo.key;
+}
+
+bool BoardState::IsRepetition(int searchPlies) const {
+	// nothing before an irreversible move can come back, and a position
+	// with the same side to move is an even number of plies away.
+	// m_History[size - n] holds the key from n plies ago.
+	int size = (int) m_History.size();
+	int limit = std::min(m_HalfMoveClock, m_PliesFromNull);
+	bool repeatedOnce = false;
+	for (int plies = 4; plies <= limit; plies += 2) {
+		if (m_History[size - plies].key != m_Key)
+			continue;
+		if (plies <= searchPlies || repeatedOnce)
+			return true;
+		repeatedOnce = true;
+	}
+	return false;
+}
+
+uint64_t BoardState::Perft(int depth) {
+	if (depth == 0)
+		return 1;
+
+	MoveList moves;
+	GenerateLegalMoves(moves);
+
+	// bulk count, the leaves don't need to be made
+	if (depth == 1)
+		return moves.size;
+
+	uint64_t nodes = 0;
+	for (BoardMove move : moves) {
+		MakeMove(move);
+		nodes += Perft(depth - 1);
+		UndoMove(move);
+	}
+	return nodes;
+}
+
+Engine::Generator<PerftDivideEntry> BoardState::PerftDivide(int depth) {
+	if (depth <= 0)
+		co_return;
+
+	MoveList moves;
+	GenerateLegalMoves(moves);
+
+	for (BoardMove move : moves) {
+		MakeMove(move);
+		uint64_t nodes = Perft(depth - 1);
+		UndoMove(move);
+		co_yield PerftDivideEntry {move, nodes};
+	}
+}
@@ -0,0 +1,329 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BitBoard.h"
+#include "Engine/Generator.h"
+#include "PieceSquareTables.h"
+#include "Position.h"
+
+// a move packed into 16 bits: 6 bits from square, 6 bits to square and
+// 4 bits of flags
+struct BoardMove {
+	enum Flag {
+		Quiet = 0,
+		DoublePush = 1,
+		KingCastle = 2,
+		QueenCastle = 3,
+		Capture = 4,
+		EnPassant = 5,
+		// the low two bits pick the piece: knight, bishop, rook, queen
+		Promotion = 8,
+		PromotionCapture = 12
+	};
+
+	uint16_t data = 0;
+
+	BoardMove() = default;
+
+	constexpr BoardMove(int from, int to, int flags = Quiet)
+		: data((uint16_t) (from | (to << 6) | (flags << 12))) {}
+
+	inline int From() const { return data & 63; }
+
+	inline int To() const { return (data >> 6) & 63; }
+
+	inline int Flags() const { return data >> 12; }
+
+	inline bool IsNull() const { return data == 0; }
+
+	inline bool IsCapture() const { return Flags() & Capture; }
+
+	inline bool IsPromotion() const { return Flags() & Promotion; }
+
+	inline bool IsCastle() const {
+		return Flags() == KingCastle || Flags() == QueenCastle;
+	}
+
+	inline PieceType GetPromotionType() const {
+		return (PieceType) (KnightPiece + (Flags() & 3));
+	}
+
+	// matches Move::indexOfPiecePromotedTo (1 queen, 2 rook, 3 bishop,
+	// 4 knight), -1 if this is not a promotion
+	inline int GetPromotionIndex() const {
+		return IsPromotion() ? 4 - (Flags() & 3) : -1;
+	}
+
+	inline Position GetFromPosition() const { return {From() % 8, From() / 8}; }
+
+	inline Position GetToPosition() const { return {To() % 8, To() / 8}; }
+
+	// long algebraic notation, e.g. "e2e4" or "e7e8q"
+	std::string ToString() const;
+
+	bool operator==(BoardMove other) const { return data == other.data; }
+
+	bool operator!=(BoardMove other) const { return data != other.data; }
+};
+
+// leaves below one root move, see BoardState::PerftDivide
+struct PerftDivideEntry {
+	BoardMove move;
+	uint64_t nodes = 0;
+};
+
+struct MoveList {
+	BoardMove moves[256];
+	int size = 0;
+
+	inline void Add(BoardMove move) { moves[size++] = move; }
+
+	inline BoardMove *begin() { return moves; }
+
+	inline BoardMove *end() { return moves + size; }
+
+	inline const BoardMove *begin() const { return moves; }
+
+	inline const BoardMove *end() const { return moves + size; }
+};
+
+// Compact, renderer free board used wherever positions have to be
+// processed in bulk (perft, move generation for datasets, search). The GUI
+// Board can produce one of these with Board::GetBoardState().
+class BoardState
+{
+public:
+	enum CastlingRight {
+		WhiteKingSide = 1,
+		WhiteQueenSide = 2,
+		BlackKingSide = 4,
+		BlackQueenSide = 8
+	};
+
+public: // construction
+	BoardState();
+
+	void Clear();
+
+	void SetPiece(int sq, Color color, PieceType type);
+
+	void RemovePiece(int sq);
+
+	inline void SetTurn(Color turn) {
+		m_Turn = turn;
+		m_Key = ComputeKey();
+	}
+
+	inline void SetCastlingRights(int rights) {
+		m_CastlingRights = rights;
+		m_Key = ComputeKey();
+	}
+
+	inline void SetEnPassantSquare(int sq) {
+		m_EnPassantSquare = sq;
+		m_Key = ComputeKey();
+	}
+
+	inline void SetMoveCounters(int halfMoveClock, int fullMoveNumber) {
+		m_HalfMoveClock = halfMoveClock;
+		m_FullMoveNumber = fullMoveNumber;
+	}
+
+public: // fen
+	// Loads a FEN, or an EPD (the move counters are optional and anything
+	// after the en passant field that isn't a counter is ignored). Doesn't
+	// allocate after construction, the move history it clears keeps its
+	// capacity. Returns false and leaves the board cleared if the position
+	// is malformed or illegal. Castling rights without the king and rook on
+	// their squares and en passant squares without the pushed pawn are
+	// dropped instead of rejected. Prints nothing, error (if given) is set
+	// to the reason a fen was rejected.
+	bool ReadFen(std::string_view fen, const char **error = nullptr);
+
+	std::string ToFen() const;
+
+public: // calculating legal moves
+	void GenerateLegalMoves(MoveList &moves) const;
+
+	unsigned int CountLegalMoves() const;
+
+	// Pseudo-legal generation for the staged move picker, both append to
+	// moves. Captures are every capture plus pushes promoting to a queen,
+	// quiets are everything else (castling only when not in check).
+	void GenerateCaptures(MoveList &moves) const;
+
+	void GenerateQuiets(MoveList &moves) const;
+
+	// whether move could have been generated in this position, for moves
+	// taken from somewhere else (the hash table, killers)
+	bool IsPseudoLegal(BoardMove move) const;
+
+	// whether a pseudo-legal move leaves the own king safe, only valid when
+	// not in check. pinned is GetPinnedPieces().
+	bool IsLegal(BoardMove move, BitBoard pinned) const;
+
+	// pieces of either color attacking sq
+	BitBoard AttackersTo(int sq, BitBoard occupancy) const;
+
+	bool IsSquareAttacked(int sq, Color by, BitBoard occupancy) const;
+
+	// every square attacked by one side, see AttackMap
+	BitBoard GetAttacks(Color by, BitBoard occupancy) const;
+
+	// pieces of the side to move that are pinned to their own king
+	BitBoard GetPinnedPieces() const;
+
+	inline BitBoard GetCheckers() const {
+		return AttackersTo(GetKingSquare(m_Turn), GetOccupancy()) &
+		       m_Occupancy[!m_Turn];
+	}
+
+	inline bool IsInCheck() const { return GetCheckers() != 0; }
+
+	// static exchange evaluation: material won (in SeeValues) by playing
+	// move and then letting both sides keep recapturing on its square with
+	// their least valuable attacker, either side stopping whenever that
+	// is better for them. Pieces behind the attackers join in once the
+	// attacker in front of them has gone. Pins are ignored.
+	int See(BoardMove move) const;
+
+	static constexpr int SeeValues[7] = {100, 320, 330, 500, 900, 20000, 0};
+
+public: // moving pieces
+	void MakeMove(BoardMove move);
+
+	void UndoMove(BoardMove move);
+
+	// passes the turn without moving, for null-move pruning. Never while in
+	// check.
+	void MakeNullMove();
+
+	void UndoNullMove();
+
+	uint64_t Perft(int depth);
+
+	// Perft of every root move in turn, yielded as soon as it is counted.
+	// Counts on this board, which is back in the root position whenever
+	// the generator is suspended. Leave the board alone until the generator
+	// is done or dropped.
+	Engine::Generator<PerftDivideEntry> PerftDivide(int depth);
+
+public: // utility functions
+	inline BitBoard GetPieces(Color color, PieceType type) const {
+		return m_Pieces[color][type];
+	}
+
+	inline BitBoard GetOccupancy(Color color) const {
+		return m_Occupancy[color];
+	}
+
+	inline BitBoard GetOccupancy() const {
+		return m_Occupancy[Black] | m_Occupancy[White];
+	}
+
+	inline PieceType GetPieceType(int sq) const {
+		return (PieceType) m_Squares[sq];
+	}
+
+	inline Color GetPieceColor(int sq) const {
+		return (Color) BitBoards::Contains(m_Occupancy[White], sq);
+	}
+
+	inline int GetKingSquare(Color color) const {
+		return BitBoards::LowestSquare(m_Pieces[color][KingPiece]);
+	}
+
+	// anything besides pawns and the king
+	inline bool HasNonPawnMaterial(Color color) const {
+		return m_Occupancy[color] !=
+		       (m_Pieces[color][PawnPiece] | m_Pieces[color][KingPiece]);
+	}
+
+	inline Color GetTurn() const { return m_Turn; }
+
+	inline int GetCastlingRights() const { return m_CastlingRights; }
+
+	// -1 when no en passant capture is possible
+	inline int GetEnPassantSquare() const { return m_EnPassantSquare; }
+
+	inline int GetHalfMoveClock() const { return m_HalfMoveClock; }
+
+	inline int GetFullMoveNumber() const { return m_FullMoveNumber; }
+
+	// whether the position was already on the board since the last pawn
+	// move, capture or null move: once within the last searchPlies plies
+	// (the ones being searched) or twice before that (in the game)
+	bool IsRepetition(int searchPlies) const;
+
+	// zobrist key of the position, kept up to date by every change. The en
+	// passant square only counts when the side to move can capture on it.
+	inline uint64_t GetKey() const { return m_Key; }
+
+	// recomputes the key from scratch
+	uint64_t ComputeKey() const;
+
+	// zobrist key of the pawns alone, for caching pawn structure terms
+	inline uint64_t GetPawnKey() const { return m_PawnKey; }
+
+	uint64_t ComputePawnKey() const;
+
+	// material and piece-square values of every piece on the board, kept
+	// up to date like the key. From white's point of view.
+	inline TaperedScore GetPsqt() const { return m_Psqt; }
+
+	// sum of PieceSquareTables::PhaseWeights over the pieces on the board
+	inline int GetPhase() const { return m_Phase; }
+
+	TaperedScore ComputePsqt() const;
+
+	int ComputePhase() const;
+
+private:
+	void MovePiece(int from, int to);
+
+	void GeneratePawnMoves(
+		MoveList &moves, BitBoard checkMask, BitBoard pinned, int kingSq
+	) const;
+
+	void GenerateCastlingMoves(MoveList &moves) const;
+
+	bool IsLegalEnPassant(int from) const;
+
+	uint64_t EnPassantKey() const;
+
+	// prints an error when the incremental psqt or phase went out of sync
+	// with a full recompute, only called in debug builds
+	void VerifyPsqt() const;
+
+private:
+	struct UndoInfo {
+		uint8_t castlingRights;
+		int8_t enPassantSquare;
+		uint8_t captured;
+		uint16_t halfMoveClock;
+		uint16_t pliesFromNull;
+		uint64_t key;
+	};
+
+	BitBoard m_Pieces[2][6] {};
+	BitBoard m_Occupancy[2] {};
+	uint8_t m_Squares[64];
+
+	Color m_Turn = White;
+	int m_CastlingRights = 0;
+	int m_EnPassantSquare = -1;
+	int m_HalfMoveClock = 0;
+	int m_FullMoveNumber = 1;
+	// plies made since the last null move, or since the position was set
+	int m_PliesFromNull = 0;
+	uint64_t m_Key = 0;
+	uint64_t m_PawnKey = 0;
+	TaperedScore m_Psqt;
+	int m_Phase = 0;
+
+	std::vector<UndoInfo> m_History;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+#include "BitBoard.h"
+#include "Position.h"
+
+// What the renderer draws, copied out of the Board after the logic thread
+// changes it. The render thread only ever sees these, never the Board.
+struct BoardView {
+	static constexpr int8_t Empty = -1;
+
+	// color * 6 + PieceType of the piece on each square, or Empty
+	int8_t pieces[64];
+	// square of the piece picked up, -1 for none
+	int8_t picked = -1;
+	// where the picked up piece is drawn, relative to its square
+	float dragOffset[2] = {0, 0};
+	// legal moves of the picked up piece, onto empty squares and captures
+	BitBoard moveTargets = 0;
+	BitBoard captureTargets = 0;
+	// squares attacked by each color
+	BitBoard controlled[2] = {0, 0};
+
+	// the promotion board is up on this file
+	bool promoting = false;
+	int8_t promotionFile = 0;
+	Color promotionColor = White;
+
+	BoardView() {
+		for (int8_t &piece : pieces) piece = Empty;
+	}
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+
+#include "BitBoard.h"
+#include "Position.h"
+
+// middlegame and endgame halves of an evaluation term, blended by the game
+// phase once the position is evaluated
+struct TaperedScore {
+	int middlegame = 0;
+	int endgame = 0;
+
+	inline TaperedScore &operator+=(TaperedScore other) {
+		middlegame += other.middlegame;
+		endgame += other.endgame;
+		return *this;
+	}
+
+	inline TaperedScore &operator-=(TaperedScore other) {
+		middlegame -= other.middlegame;
+		endgame -= other.endgame;
+		return *this;
+	}
+
+	bool operator==(TaperedScore other) const {
+		return middlegame == other.middlegame && endgame == other.endgame;
+	}
+
+	bool operator!=(TaperedScore other) const { return !(*this == other); }
+};
+
+// Material and piece-square values (PeSTO's) that BoardState keeps summed
+// up as pieces move, so the evaluation doesn't have to visit every piece.
+namespace PieceSquareTables
+{
+	// how much each piece counts towards the game phase, MaxPhase with
+	// all of them on the board and 0 with only kings and pawns
+	constexpr int PhaseWeights[6] = {0, 1, 1, 2, 4, 0};
+	constexpr int MaxPhase = 24;
+
+	typedef std::array<std::array<std::array<TaperedScore, 64>, 6>, 2>
+		ScoreTable;
+
+	// material plus square bonus of a piece by color, type and square.
+	// Positive for white pieces, negative for black ones.
+	extern const ScoreTable Scores;
+
+	// mg * phase + eg * (MaxPhase - phase), phase capped at MaxPhase
+	inline int Blend(TaperedScore score, int phase) {
+		phase = phase < MaxPhase ? phase : MaxPhase;
+		return (score.middlegame * phase +
+		        score.endgame * (MaxPhase - phase)) /
+		       MaxPhase;
+	}
+} // namespace PieceSquareTables
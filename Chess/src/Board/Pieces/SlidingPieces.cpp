@@ -147,12 +147,6 @@ Rook::Rook(Color color, Position pos, float squareSize, Board *board)
 void Rook::Castle(Position pos) {
 	m_IsVirgin = false;
 
-	// change visual position
-	float viewPos[3] = {
-		(-1 + m_SquareSize / 2) + ((float) pos.file * m_SquareSize),
-		(-1 + m_SquareSize / 2) + ((float) pos.rank * m_SquareSize), 0};
-	Engine::Renderer::MoveQuad(m_Object, viewPos, m_SquareSize);
-
 	m_OwnerBoard->SetPiece(pos, m_OwnerBoard->GetFullPiecePtr(m_Position));
 	m_Position = pos;
 }
@@ -160,12 +154,6 @@ void Rook::Castle(Position pos) {
 void Rook::UnCastle(Position from) {
 	m_IsVirgin = true;
 
-	// change visual position
-	float viewPos[3] = {
-		(-1 + m_SquareSize / 2) + ((float) from.file * m_SquareSize),
-		(-1 + m_SquareSize / 2) + ((float) from.rank * m_SquareSize), 0};
-	Engine::Renderer::MoveQuad(m_Object, viewPos, m_SquareSize);
-
 	m_OwnerBoard->SetPiece(from, m_OwnerBoard->GetFullPiecePtr(m_Position));
 	m_Position = from;
 }
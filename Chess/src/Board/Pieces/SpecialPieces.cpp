@@ -280,8 +280,7 @@ bool Pawn::Move(Position to) {
 		// pawn promotion
 		if (CheckIsPromotionMove(to)) {
 			auto pb = std::make_unique<PromotionBoard>(
-				m_Position, m_OwnerBoard, m_Color, "Assets/Shaders/Board.vert",
-				"Assets/Shaders/Board.frag"
+				m_Position, m_OwnerBoard, m_Color
 			);
 			Application::AddLayer(pb->GetBoardLayer());
 			m_OwnerBoard->p_PromotionBoard = std::move(pb);
@@ -330,6 +329,11 @@ EnPassantPiece::CancelEnPassantOffer(bool deletePawn /*=false*/) {
 	return pawn;
 }
 
+void EnPassantPiece::ClearMoveCache() {
+	while (!m_MoveCache.empty()) m_MoveCache.pop();
+	SetPawn(nullptr, {});
+}
+
 void EnPassantPiece::UndoMove(Position from) {
 	if (m_MoveCache.empty())
 		return;
@@ -382,10 +386,6 @@ LegalMoveSprite::LegalMoveSprite(
 		(capture ? "Assets/Textures/Capture.png"
 	             : "Assets/Textures/LegalMove.png")
 	));
-	float tint[4] = {0.35f, 0.35f, 0.35f, 0.5f};
-	m_Obj.shader.SetUniformVec(
-		m_Obj.shader.GetUniformLocation("tint"), 4, tint
-	);
 }
 
 LegalMoveSprite::~LegalMoveSprite() { Engine::Renderer::DeleteQuad(m_Obj); }
@@ -399,4 +399,11 @@ void LegalMoveSprite::SetPosition(Position pos) const {
 	);
 }
 
-void LegalMoveSprite::Render() const { Engine::Renderer::SubmitObject(m_Obj); }
+void LegalMoveSprite::Render() const {
+	// the program is shared with the pieces, which aren't tinted
+	float tint[4] = {0.35f, 0.35f, 0.35f, 0.5f};
+	m_Obj.shader.SetUniformVec(
+		m_Obj.shader.GetUniformLocation("tint"), 4, tint
+	);
+	Engine::Renderer::SubmitObject(m_Obj);
+}
@@ -3,6 +3,7 @@
 
 #include "Board/Board.h"
 #include "Board/PromotionBoard.h"
+#include "Engine/Renderer.h"
 #include "Piece.h"
 #include "SlidingPieces.h"
 
@@ -32,6 +33,10 @@ public:
 
 	void SetCastling(bool K, bool Q);
 
+	inline bool GetCanCastle(bool kingSide) const {
+		return kingSide ? m_CanCastleK : m_CanCastleQ;
+	}
+
 private:
 	std::vector<Piece *> m_Pins;
 
@@ -72,10 +77,9 @@ public:
 			m_Color, m_Position, m_SquareSize, m_OwnerBoard
 		);
 
+		// the legal moves are up to Board::FinishPromotion
 		m_OwnerBoard->SetPiece(m_Position, std::move(piece));
 
-		m_OwnerBoard->CalculateAllLegalMoves();
-
 		// return pawn unique_ptr
 		return pawn;
 	}
@@ -97,14 +101,15 @@ public:
 
 	std::unique_ptr<Piece> CancelEnPassantOffer(bool deletePawn = false);
 
+	// forgets every en passant offer, used when a new position is loaded
+	void ClearMoveCache();
+
 	Position *GetPosition() { return &m_Position; }
 
 	// This doesn't have legal move, but it still
 	// needs to delete itself after the first move
 	void CalculateLegalMoves() override;
 
-	void Render() override {}
-
 public:
 	Pawn *p_OwningPawn;
 
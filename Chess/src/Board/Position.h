@@ -0,0 +1,82 @@
+#pragma once
+
+#include <sstream>
+#include <string>
+
+struct Position {
+	int file = -1;
+	int rank = -1;
+
+	bool operator==(const Position &other) const {
+		return other.file == file && other.rank == rank;
+	}
+
+	bool operator!=(const Position &other) const {
+		return other.file != file || other.rank != rank;
+	}
+
+	bool operator<(const Position &other) const {
+		return ToIndex() < other.ToIndex();
+	}
+
+	bool operator>(const Position &other) const {
+		return ToIndex() > other.ToIndex();
+	}
+
+	Position operator+(const Position &other) const {
+		return {file + other.file, rank + other.rank};
+	}
+
+	Position operator-(const Position &other) const {
+		return {file - other.file, rank - other.rank};
+	}
+
+	Position operator-() const { return {0 - file, 0 - rank}; }
+
+	Position operator*(const Position &other) const {
+		return {file * other.file, rank * other.rank};
+	}
+
+	Position operator*(const int &other) const {
+		return {file * other, rank * other};
+	}
+
+	Position operator/(const Position &other) const {
+		return {file / other.file, rank / other.rank};
+	}
+
+	Position operator/(const int &other) const {
+		return {file / other, rank / other};
+	}
+
+	Position &operator+=(const Position &other) {
+		file += other.file;
+		rank += other.rank;
+		return *this;
+	}
+
+	Position &operator-=(const Position &other) {
+		file -= other.file;
+		rank -= other.rank;
+		return *this;
+	}
+
+	std::string ToString() const {
+		std::stringstream ss;
+		ss << (char) ('a' + file) << rank + 1;
+		return ss.str();
+	}
+
+	int ToIndex() const { return rank * 8 + file; }
+
+	bool IsValid() const {
+		return file >= 0 && file < 8 && rank >= 0 && rank < 8;
+	}
+
+	Position Normalized() const {
+		auto sign = [](int x) -> int { return (x > 0) - (x < 0); };
+		return {sign(file), sign(rank)};
+	}
+};
+
+enum Color { Black = 0, White = 1 };
@@ -5,10 +5,7 @@
 #include "Board/Pieces/SlidingPieces.h"
 #include "Board/Pieces/SpecialPieces.h"
 
-PromotionBoard::PromotionBoard(
-	Position position, Board *board, Color color, const char *vertShaderPath,
-	const char *fragShaderPath
-)
+PromotionBoard::PromotionBoard(Position position, Board *board, Color color)
 	: m_Layer(this), m_Board(board), m_Origin(position), m_Color(color),
 	  m_PromotionBoard(5) {
 	float squareSize = m_Board->m_SquareSize;
@@ -16,20 +13,6 @@ PromotionBoard::PromotionBoard(
 		Square &square = m_PromotionBoard[i];
 
 		square.pos = {position.file, (m_Color == Color::White ? 7 - i : i)};
-		float pos[3] = {
-			(-1 + squareSize / 2) + ((float) square.pos.file * squareSize),
-			(-1 + squareSize / 2) + ((float) square.pos.rank * squareSize), 0};
-
-		square.background = Engine::Renderer::GenQuad(
-			pos, squareSize, vertShaderPath, fragShaderPath
-		);
-
-		square.background.shader.SetUniform(
-			square.background.shader.GetUniformLocation("isWhite"),
-			((square.pos.file + square.pos.rank) % 2)
-		);
-
-
 		square.piece = nullptr;
 		switch (i) {
 		case 1:
@@ -68,16 +51,6 @@ PromotionBoard::PromotionBoard(
 
 PromotionBoard::~PromotionBoard() { Application::GetLayerStack()->PopFront(); };
 
-void PromotionBoard::RenderBoard() {
-	for (Square &square : m_PromotionBoard) {
-		// Render every piece except for fake pieces
-		Engine::Renderer::SubmitObject(square.background);
-
-		if (square.piece && square.piece->GetPieceName() != "en_passant")
-			square.piece->Render();
-	}
-}
-
 // always returns true because we don't want events passing through
 bool PromotionBoard::HandleMouseReleased(Engine::MouseButtonReleasedEvent &e) {
 	float mouseX, mouseY;
@@ -97,14 +70,18 @@ bool PromotionBoard::HandleMouseReleased(Engine::MouseButtonReleasedEvent &e) {
 
 	auto pawn = dynamic_cast<Pawn *>(m_Board->GetPiece(m_Origin));
 	//	pawn->Promote<decltype(chosenSquare->piece.get())>();
-	switch (m_Color ? 7 - squarePos.rank : squarePos.rank) {
+	int promotion = m_Color ? 7 - squarePos.rank : squarePos.rank;
+	switch (promotion) {
 	case 1: pawn->Promote<Queen>(); break;
 	case 2: pawn->Promote<Rook>(); break;
 	case 3: pawn->Promote<Bishop>(); break;
 	case 4: pawn->Promote<Knight>(); break;
 	}
 
-	m_Board->p_PromotionBoard.reset();
+	// resetting the promotion board deletes this
+	Board *board = m_Board;
+	board->p_PromotionBoard.reset();
+	board->FinishPromotion(promotion);
 	return true; // event was handled
 }
 
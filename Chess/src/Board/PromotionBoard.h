@@ -26,15 +26,10 @@ private:
 class PromotionBoard
 {
 public:
-	PromotionBoard(
-		Position position, Board *board, Color color,
-		const char *vertShaderPath, const char *fragShaderPath
-	);
+	PromotionBoard(Position position, Board *board, Color color);
 
 	~PromotionBoard();
 
-	void RenderBoard();
-
 	void SetPiece(Position pos, std::unique_ptr<Piece> piece);
 
 	class Square *GetSquare(Position pos, bool ignore0 = false);
@@ -45,6 +40,10 @@ public:
 public:
 	inline PromotionBoardLayer *GetBoardLayer() { return &m_Layer; }
 
+	inline Position GetOrigin() const { return m_Origin; }
+
+	inline Color GetColor() const { return m_Color; }
+
 private:
 	std::vector<Square> m_PromotionBoard;
 	Board *m_Board;
@@ -0,0 +1,98 @@
+#include "SpeculativeMoves.h"
+
+#include <algorithm>
+
+SpeculativeMoves::SpeculativeMoves() {
+	m_Replies.reserve(256);
+	m_Worker = std::thread(&SpeculativeMoves::Run, this);
+}
+
+SpeculativeMoves::~SpeculativeMoves() {
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stop = true;
+	}
+	m_Wake.notify_one();
+	m_Worker.join();
+}
+
+void SpeculativeMoves::Start(const BoardState &root) {
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Generation++;
+		m_Root = root;
+		m_HasRoot = true;
+		m_Replies.clear();
+	}
+	m_Wake.notify_one();
+}
+
+void SpeculativeMoves::Cancel() {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Generation++;
+	m_HasRoot = false;
+	m_Replies.clear();
+}
+
+bool SpeculativeMoves::Take(
+	Position from, Position to, Reply &reply, int promotion /*=-1*/
+) {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	for (const Reply &r : m_Replies) {
+		if (r.move.From() == from.ToIndex() && r.move.To() == to.ToIndex() &&
+		    r.move.GetPromotionIndex() == promotion) {
+			reply = r;
+			return true;
+		}
+	}
+	return false;
+}
+
+void SpeculativeMoves::Run() {
+	BoardState state;
+
+	while (true) {
+		uint64_t generation;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Wake.wait(lock, [this] { return m_Stop || m_HasRoot; });
+			if (m_Stop)
+				return;
+
+			state = m_Root;
+			generation = m_Generation;
+			m_HasRoot = false;
+		}
+
+		Speculate(state, generation);
+	}
+}
+
+void SpeculativeMoves::Speculate(BoardState &state, uint64_t generation) {
+	MoveList moves;
+	state.GenerateLegalMoves(moves);
+
+	// the user is far more likely to capture or promote, do those first
+	std::stable_partition(moves.begin(), moves.end(), [](BoardMove move) {
+		return move.IsCapture() || move.IsPromotion();
+	});
+
+	Reply reply;
+	for (BoardMove move : moves) {
+		reply.move = move;
+		state.MakeMove(move);
+		state.GenerateLegalMoves(reply.legalMoves);
+		for (Color color : {Black, White}) {
+			BitBoard occupancy = state.GetOccupancy() &
+			                     ~state.GetPieces((Color) !color, KingPiece);
+			reply.controlledSquares[color] = state.GetAttacks(color, occupancy);
+		}
+		state.UndoMove(move);
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		// the position changed under us, the rest is useless
+		if (generation != m_Generation || m_Stop)
+			return;
+		m_Replies.push_back(reply);
+	}
+}
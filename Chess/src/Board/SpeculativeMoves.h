@@ -0,0 +1,63 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BoardState.h"
+
+// Background worker that, while the user is thinking, plays every legal
+// move of the position on screen and precomputes what the board needs
+// afterwards. Committing one of those moves then only has to copy the
+// result instead of running the piece by piece legal move calculation.
+// Only the legal moves and attacked squares after each move are worked
+// out, the board has no engine opponent whose reply could be searched
+// ahead of time. Promotions are played to all four pieces.
+class SpeculativeMoves
+{
+public:
+	struct Reply {
+		BoardMove move;
+		// legal moves of the side to move after move was played
+		MoveList legalMoves;
+		// squares attacked by each color, same as Board::m_ControlledSquares
+		BitBoard controlledSquares[2];
+	};
+
+public:
+	SpeculativeMoves();
+
+	~SpeculativeMoves();
+
+	// throws away the old results and starts working on the position
+	void Start(const BoardState &root);
+
+	// stops working and forgets the current position
+	void Cancel();
+
+	// copies the precomputed reply for the move from -> to of the current
+	// position into reply, false if the worker didn't get to it (yet).
+	// promotion is the piece promoted to as in Move::indexOfPiecePromotedTo
+	// (1 queen to 4 knight), -1 for moves that aren't promotions.
+	bool Take(Position from, Position to, Reply &reply, int promotion = -1);
+
+private:
+	void Run();
+
+	void Speculate(BoardState &state, uint64_t generation);
+
+private:
+	std::mutex m_Mutex;
+	std::condition_variable m_Wake;
+	std::thread m_Worker;
+	bool m_Stop = false;
+
+	// bumped every time the position changes, results of older
+	// generations are dropped by the worker
+	uint64_t m_Generation = 0;
+	BoardState m_Root;
+	bool m_HasRoot = false;
+
+	std::vector<Reply> m_Replies;
+};
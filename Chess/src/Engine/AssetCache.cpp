@@ -0,0 +1,39 @@
+#include "AssetCache.h"
+
+namespace Engine
+{
+	unsigned int AssetCache::Acquire(
+		Kind kind, const std::string &key,
+		const std::function<unsigned int()> &create
+	) {
+		Table &table = GetTable(kind);
+		auto it = table.ids.find(key);
+		if (it != table.ids.end()) {
+			table.entries[it->second].references++;
+			return it->second;
+		}
+
+		unsigned int id = create();
+		table.ids[key] = id;
+		table.entries[id] = {key, 1};
+		return id;
+	}
+
+	bool AssetCache::Release(Kind kind, unsigned int id) {
+		Table &table = GetTable(kind);
+		auto it = table.entries.find(id);
+		if (it == table.entries.end())
+			return true;
+		if (--it->second.references > 0)
+			return false;
+
+		table.ids.erase(it->second.key);
+		table.entries.erase(it);
+		return true;
+	}
+
+	AssetCache::Table &AssetCache::GetTable(Kind kind) {
+		static Table tables[2];
+		return tables[kind];
+	}
+} // namespace Engine
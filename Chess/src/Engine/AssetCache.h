@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+namespace Engine
+{
+	// Shares GL objects loaded from disk, shader programs by the paths of
+	// their sources and textures by the path of their image, between
+	// everything that uses them. Every Acquire counts a reference and every
+	// Release gives one back, and only the last Release has the caller
+	// delete the object. Like all GL work it is only used from the thread
+	// holding the context.
+	class AssetCache
+	{
+	public:
+		enum Kind : uint8_t { ShaderProgram, TextureImage };
+
+	public:
+		// the object cached under key, made with create if there is none
+		static unsigned int Acquire(
+			Kind kind, const std::string &key,
+			const std::function<unsigned int()> &create
+		);
+
+		// true if that was the last reference and the object has to be
+		// deleted, which includes objects that never were in the cache
+		static bool Release(Kind kind, unsigned int id);
+
+	private:
+		struct Entry {
+			std::string key;
+			int references = 0;
+		};
+
+		struct Table {
+			std::unordered_map<std::string, unsigned int> ids;
+			std::unordered_map<unsigned int, Entry> entries;
+		};
+
+		static Table &GetTable(Kind kind);
+	};
+} // namespace Engine
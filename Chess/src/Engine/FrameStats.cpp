@@ -0,0 +1,45 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace Engine
+{
+	FrameStats::FrameStats(const char *name) : m_Name(name) {
+		m_FrameTimesMs.reserve(ReportInterval);
+	}
+
+	void FrameStats::OnFrame() {
+		auto now = std::chrono::steady_clock::now();
+		if (m_Started)
+			m_FrameTimesMs.push_back(
+				std::chrono::duration<float, std::milli>(now - m_LastFrame)
+					.count()
+			);
+		m_LastFrame = now;
+		m_Started = true;
+
+		if (m_FrameTimesMs.size() >= ReportInterval)
+			Report();
+	}
+
+	void FrameStats::Report() {
+		float sum = 0;
+		for (float ms : m_FrameTimesMs) sum += ms;
+		float mean = sum / (float) m_FrameTimesMs.size();
+
+		float variance = 0;
+		for (float ms : m_FrameTimesMs) variance += (ms - mean) * (ms - mean);
+		float deviation = std::sqrt(variance / (float) m_FrameTimesMs.size());
+
+		std::sort(m_FrameTimesMs.begin(), m_FrameTimesMs.end());
+		size_t p99 = m_FrameTimesMs.size() * 99 / 100;
+
+		std::cout << m_Name << " frame time ms: mean " << mean
+				  << ", stddev " << deviation << ", p99 "
+				  << m_FrameTimesMs[p99] << ", max "
+				  << m_FrameTimesMs.back() << std::endl;
+		m_FrameTimesMs.clear();
+	}
+} // namespace Engine
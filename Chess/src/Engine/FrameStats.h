@@ -0,0 +1,31 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+namespace Engine
+{
+	// Times frames and every ReportInterval of them prints the mean frame
+	// time and how much it jitters around it: the standard deviation, the
+	// 99th percentile and the worst frame.
+	class FrameStats
+	{
+	public:
+		static constexpr int ReportInterval = 1000;
+
+	public:
+		explicit FrameStats(const char *name);
+
+		// call once per frame, after presenting it
+		void OnFrame();
+
+	private:
+		void Report();
+
+	private:
+		const char *m_Name;
+		std::chrono::steady_clock::time_point m_LastFrame;
+		bool m_Started = false;
+		std::vector<float> m_FrameTimesMs;
+	};
+} // namespace Engine
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace Engine
+{
+	// Lazily evaluated sequence written as a coroutine that co_yields its
+	// values. Nothing runs until the first value is asked for, and the
+	// coroutine is suspended between values with all of its locals kept, so
+	// a consumer can pull values one at a time (Next/Value) or with a
+	// range-for, and simply drop the generator to stop early. Yielded values
+	// are referred to, not copied, and stay valid until the next resume.
+	template<typename T>
+	class Generator
+	{
+	public:
+		struct promise_type {
+			const T *value = nullptr;
+
+			Generator get_return_object() {
+				return Generator(Handle::from_promise(*this));
+			}
+
+			std::suspend_always initial_suspend() noexcept { return {}; }
+
+			std::suspend_always final_suspend() noexcept { return {}; }
+
+			std::suspend_always yield_value(const T &v) noexcept {
+				value = std::addressof(v);
+				return {};
+			}
+
+			void return_void() noexcept {}
+
+			// nothing in here throws
+			void unhandled_exception() { std::terminate(); }
+
+			// generators only yield, they never wait on anything
+			template<typename U>
+			std::suspend_never await_transform(U &&) = delete;
+		};
+
+		using Handle = std::coroutine_handle<promise_type>;
+
+		class Iterator
+		{
+		public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = T;
+			using difference_type = std::ptrdiff_t;
+
+			Iterator() = default;
+
+			explicit Iterator(Handle handle) : m_Handle(handle) {}
+
+			const T &operator*() const { return *m_Handle.promise().value; }
+
+			const T *operator->() const { return m_Handle.promise().value; }
+
+			Iterator &operator++() {
+				m_Handle.resume();
+				return *this;
+			}
+
+			void operator++(int) { ++*this; }
+
+			bool operator==(std::default_sentinel_t) const {
+				return !m_Handle || m_Handle.done();
+			}
+
+		private:
+			Handle m_Handle;
+		};
+
+	public:
+		Generator() = default;
+
+		Generator(Generator &&other) noexcept
+			: m_Handle(std::exchange(other.m_Handle, {})) {}
+
+		Generator &operator=(Generator &&other) noexcept {
+			if (this != &other) {
+				if (m_Handle)
+					m_Handle.destroy();
+				m_Handle = std::exchange(other.m_Handle, {});
+			}
+			return *this;
+		}
+
+		Generator(const Generator &) = delete;
+
+		Generator &operator=(const Generator &) = delete;
+
+		~Generator() {
+			if (m_Handle)
+				m_Handle.destroy();
+		}
+
+		// runs the coroutine up to its next value, false once it returned
+		bool Next() {
+			if (!m_Handle || m_Handle.done())
+				return false;
+			m_Handle.resume();
+			return !m_Handle.done();
+		}
+
+		// the value Next stopped at
+		const T &Value() const { return *m_Handle.promise().value; }
+
+		// starts (or continues) the sequence, a generator can only be
+		// iterated over once
+		Iterator begin() {
+			if (m_Handle && !m_Handle.done())
+				m_Handle.resume();
+			return Iterator(m_Handle);
+		}
+
+		std::default_sentinel_t end() const { return {}; }
+
+	private:
+		explicit Generator(Handle handle) : m_Handle(handle) {}
+
+	private:
+		Handle m_Handle;
+	};
+} // namespace Engine
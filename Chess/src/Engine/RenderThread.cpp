@@ -0,0 +1,45 @@
+#include "RenderThread.h"
+
+#include "GLFW/glfw3.h"
+
+namespace Engine
+{
+	RenderThread::RenderThread(
+		GLFWwindow *window, std::function<void()> setUp,
+		std::function<void()> drawFrame, std::function<void()> tearDown
+	)
+		: m_Window(window), m_SetUp(std::move(setUp)),
+		  m_DrawFrame(std::move(drawFrame)), m_TearDown(std::move(tearDown)),
+		  m_Stats("render") {}
+
+	RenderThread::~RenderThread() { Stop(); }
+
+	void RenderThread::Start() {
+		if (m_Running)
+			return;
+		m_Running = true;
+		m_Thread = std::thread(&RenderThread::Run, this);
+	}
+
+	void RenderThread::Stop() {
+		m_Running = false;
+		if (m_Thread.joinable())
+			m_Thread.join();
+	}
+
+	void RenderThread::RenderFrame() {
+		m_DrawFrame();
+		glfwSwapBuffers(m_Window);
+		m_Stats.OnFrame();
+	}
+
+	void RenderThread::Run() {
+		glfwMakeContextCurrent(m_Window);
+		m_SetUp();
+
+		while (m_Running) RenderFrame();
+
+		m_TearDown();
+		glfwMakeContextCurrent(nullptr);
+	}
+} // namespace Engine
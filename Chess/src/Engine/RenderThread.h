@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include "FrameStats.h"
+
+struct GLFWwindow;
+
+namespace Engine
+{
+	// Draws and presents frames on a thread of its own, so nothing the
+	// logic thread does (moves, legal move generation, perft) holds up a
+	// frame. The window's GL context belongs to the thread while it runs:
+	// setUp and tearDown are where GL objects get made and deleted, and
+	// drawFrame draws one frame, which the thread then presents.
+	class RenderThread
+	{
+	public:
+		RenderThread(
+			GLFWwindow *window, std::function<void()> setUp,
+			std::function<void()> drawFrame, std::function<void()> tearDown
+		);
+
+		~RenderThread();
+
+		// the calling thread has to give up the context first
+		void Start();
+
+		// joins the thread, which gives the context up again
+		void Stop();
+
+		// draws, presents and times one frame on the calling thread, what
+		// the thread does in a loop. For rendering without the thread.
+		void RenderFrame();
+
+	private:
+		void Run();
+
+	private:
+		GLFWwindow *m_Window;
+		std::function<void()> m_SetUp;
+		std::function<void()> m_DrawFrame;
+		std::function<void()> m_TearDown;
+
+		std::thread m_Thread;
+		std::atomic<bool> m_Running = false;
+
+		FrameStats m_Stats;
+	};
+} // namespace Engine
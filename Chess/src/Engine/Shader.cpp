@@ -1,5 +1,6 @@
 #include "Shader.h"
 
+#include "AssetCache.h"
 #include "glad/glad.h"
 #include "stb/stb_image.h"
 
@@ -56,10 +57,20 @@ namespace Engine
 	}
 
 	Shader Shader::Compile(const char *vertPath, const char *fragPath) {
-		std::string vertShaderSource = ReadFile(vertPath);
-		std::string fragShaderSource = ReadFile(fragPath);
-
-		return Shader(vertShaderSource.c_str(), fragShaderSource.c_str());
+		Shader shader;
+		shader.m_ShaderProgramID = AssetCache::Acquire(
+			AssetCache::ShaderProgram,
+			std::string(vertPath) + "\n" + fragPath,
+			[&] {
+				std::string vertShaderSource = ReadFile(vertPath);
+				std::string fragShaderSource = ReadFile(fragPath);
+				Shader compiled(
+					vertShaderSource.c_str(), fragShaderSource.c_str()
+				);
+				return compiled.m_ShaderProgramID;
+			}
+		);
+		return shader;
 	}
 
 #pragma region SetUniformFuncs
@@ -130,8 +141,10 @@ namespace Engine
 	void Shader::AttachTexture(Texture tex) { m_Textures.push_back(tex); }
 
 	void Shader::Destroy() {
-		glDeleteProgram(m_ShaderProgramID);
+		if (AssetCache::Release(AssetCache::ShaderProgram, m_ShaderProgramID))
+			glDeleteProgram(m_ShaderProgramID);
 		for (Texture &texture : m_Textures) { texture.Destroy(); }
+		m_Textures.clear();
 	}
 
 	std::string Shader::ReadFile(const char *path) {
@@ -183,6 +196,12 @@ namespace Engine
 	// ////////////////////////////////////////////////////////////////////
 
 	Texture::Texture(const char *path) {
+		m_TextureID = AssetCache::Acquire(AssetCache::TextureImage, path, [&] {
+			return Load(path);
+		});
+	}
+
+	unsigned int Texture::Load(const char *path) {
 		stbi_set_flip_vertically_on_load(true);
 
 		int width, height, channels = 4;
@@ -193,8 +212,9 @@ namespace Engine
 			std::cout << "ERROR: Image not opened" << std::endl;
 		}
 
-		glGenTextures(1, &m_TextureID);
-		Bind();
+		unsigned int id;
+		glGenTextures(1, &id);
+		glBindTexture(GL_TEXTURE_2D, id);
 
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -205,15 +225,19 @@ namespace Engine
 			GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
 			GL_UNSIGNED_BYTE, image
 		);
-		UnBind();
+		glBindTexture(GL_TEXTURE_2D, 0);
 
 		stbi_image_free(image);
+		return id;
 	}
 
 	void Texture::Bind() const { glBindTexture(GL_TEXTURE_2D, m_TextureID); }
 
 	void Texture::UnBind() const { glBindTexture(GL_TEXTURE_2D, 0); }
 
-	void Texture::Destroy() { glDeleteTextures(1, &m_TextureID); }
+	void Texture::Destroy() {
+		if (AssetCache::Release(AssetCache::TextureImage, m_TextureID))
+			glDeleteTextures(1, &m_TextureID);
+	}
 
 } // namespace Engine
\ No newline at end of file
@@ -16,6 +16,8 @@ namespace Engine
 			const char *fragShaderSource = nullptr
 		);
 
+		// the program is shared with every other shader compiled from the
+		// same files, see AssetCache
 		static Shader Compile(const char *vertPath, const char *fragPath);
 
 		void SetUniform(int loc, int value) const;
@@ -54,6 +56,7 @@ namespace Engine
 	class Texture
 	{
 	public:
+		// shared with every other texture of the same image, see AssetCache
 		explicit Texture(const char *path);
 
 		void Bind() const;
@@ -62,6 +65,9 @@ namespace Engine
 
 		void Destroy();
 
+	private:
+		static unsigned int Load(const char *path);
+
 	private:
 		unsigned int m_TextureID {};
 	};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace Engine
+{
+	// Hands the latest snapshot of a T from one writer thread to one reader
+	// thread without either waiting on the other. Double buffered from both
+	// sides: the writer fills its back buffer while the reader draws from
+	// its front buffer, and a third, pending buffer sits between them so
+	// that publishing and acquiring are a single atomic exchange of indices.
+	// Snapshots the reader doesn't get to in time are skipped.
+	template<typename T>
+	class SnapshotBuffer
+	{
+	public:
+		// writer only
+		inline T &GetBack() { return m_Buffers[m_Back]; }
+
+		// writer only, the back buffer becomes the newest snapshot and the
+		// writer gets a buffer to fill for the next one
+		void Publish() {
+			uint8_t old =
+				m_Pending.exchange(m_Back | Fresh, std::memory_order_acq_rel);
+			m_Back = old & IndexMask;
+		}
+
+		// reader only, false (keeping the front buffer) if nothing was
+		// published since the last call
+		bool Acquire() {
+			if (!(m_Pending.load(std::memory_order_relaxed) & Fresh))
+				return false;
+			uint8_t old =
+				m_Pending.exchange(m_Front, std::memory_order_acq_rel);
+			m_Front = old & IndexMask;
+			return true;
+		}
+
+		// reader only
+		inline const T &GetFront() const { return m_Buffers[m_Front]; }
+
+	private:
+		static constexpr uint8_t IndexMask = 3;
+		static constexpr uint8_t Fresh = 4;
+
+		T m_Buffers[3] {};
+
+		uint8_t m_Front = 0;
+		alignas(64) std::atomic<uint8_t> m_Pending = 1;
+		alignas(64) uint8_t m_Back = 2;
+	};
+} // namespace Engine
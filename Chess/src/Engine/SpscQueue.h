@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace Engine
+{
+	// Bounded lock-free queue between exactly one producer thread and one
+	// consumer thread, neither of them ever waits on the other. The two
+	// indices live on cache lines of their own and each side keeps a copy
+	// of the other side's index, so the shared lines are only touched when
+	// the queue looks full (or empty) from the copy.
+	template<typename T, size_t Capacity>
+	class SpscQueue
+	{
+		static_assert(
+			Capacity && (Capacity & (Capacity - 1)) == 0,
+			"capacity has to be a power of two"
+		);
+
+	public:
+		// producer only, false (leaving value alone) if the queue is full
+		bool TryPush(T &&value) {
+			size_t tail = m_Tail.load(std::memory_order_relaxed);
+			if (tail - m_CachedHead == Capacity) {
+				m_CachedHead = m_Head.load(std::memory_order_acquire);
+				if (tail - m_CachedHead == Capacity)
+					return false;
+			}
+
+			m_Slots[tail & (Capacity - 1)] = std::move(value);
+			m_Tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool TryPush(const T &value) {
+			T copy = value;
+			return TryPush(std::move(copy));
+		}
+
+		// consumer only, false if the queue is empty
+		bool TryPop(T &value) {
+			size_t head = m_Head.load(std::memory_order_relaxed);
+			if (head == m_CachedTail) {
+				m_CachedTail = m_Tail.load(std::memory_order_acquire);
+				if (head == m_CachedTail)
+					return false;
+			}
+
+			value = std::move(m_Slots[head & (Capacity - 1)]);
+			m_Head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		// consumer only
+		bool IsEmpty() const {
+			return m_Head.load(std::memory_order_relaxed) ==
+			       m_Tail.load(std::memory_order_acquire);
+		}
+
+	private:
+		// written by the consumer
+		alignas(64) std::atomic<size_t> m_Head = 0;
+		size_t m_CachedTail = 0;
+
+		// written by the producer
+		alignas(64) std::atomic<size_t> m_Tail = 0;
+		size_t m_CachedHead = 0;
+
+		alignas(64) std::array<T, Capacity> m_Slots {};
+	};
+} // namespace Engine
@@ -1,5 +1,6 @@
 #include "Window.h"
 
+#include <chrono>
 #include <utility>
 
 namespace Engine
@@ -43,16 +44,14 @@ namespace Engine
 		glfwSetWindowUserPointer(m_Window, (void *) this);
 		glfwSetWindowCloseCallback(m_Window, [](GLFWwindow *window) {
 			Window &win = *(Window *) glfwGetWindowUserPointer(window);
-			WindowClosedEvent e;
-			win.m_OnEventFunc(e);
+			win.Queue({WindowClosed});
 		});
 
 		glfwSetWindowSizeCallback(
 			m_Window,
 			[](GLFWwindow *window, int width, int height) {
 				Window &win = *(Window *) glfwGetWindowUserPointer(window);
-				WindowResizedEvent e(width, height);
-				win.m_OnEventFunc(e);
+				win.Queue({WindowResized, width, height});
 			}
 		);
 
@@ -67,18 +66,16 @@ namespace Engine
 				int width, height;
 				glfwGetWindowSize(window, &width, &height);
 
-				if (action == GLFW_PRESS) {
-					MouseButtonPressedEvent e(
-						button, (float) mouseX * 2 / (float) width - 1,
-						-(float) mouseY * 2 / (float) height + 1
-					);
-					win.m_OnEventFunc(e);
-				} else if (action == GLFW_RELEASE) {
-					MouseButtonReleasedEvent e(
-						button, (float) mouseX * 2 / (float) width - 1,
-						-(float) mouseY * 2 / (float) height + 1
-					);
-					win.m_OnEventFunc(e);
+				QueuedEvent e = {
+					MouseButtonPressed, button, 0,
+					(float) mouseX * 2 / (float) width - 1,
+					-(float) mouseY * 2 / (float) height + 1
+				};
+				if (action == GLFW_PRESS)
+					win.Queue(e);
+				else if (action == GLFW_RELEASE) {
+					e.type = MouseButtonReleased;
+					win.Queue(e);
 				}
 			}
 		);
@@ -91,11 +88,10 @@ namespace Engine
 				int width, height;
 				glfwGetWindowSize(window, &width, &height);
 
-				MouseMovedEvent e(
-					(float) mouseX * 2 / (float) width - 1,
-					-(float) mouseY * 2 / (float) height + 1
+				win.Queue(
+					{MouseMoved, 0, 0, (float) mouseX * 2 / (float) width - 1,
+				     -(float) mouseY * 2 / (float) height + 1}
 				);
-				win.m_OnEventFunc(e);
 			}
 		);
 
@@ -106,33 +102,109 @@ namespace Engine
 				Window &win = *(Window *) glfwGetWindowUserPointer(window);
 
 				switch (action) {
-				case GLFW_PRESS: {
-					KeyPressedEvent e(key);
-
-					win.m_OnEventFunc(e);
-					break;
-				}
-				case GLFW_RELEASE: {
-					KeyReleasedEvent e(key);
-
-					win.m_OnEventFunc(e);
-					break;
-				}
+				case GLFW_PRESS: win.Queue({KeyPressed, key}); break;
+				case GLFW_RELEASE: win.Queue({KeyReleased, key}); break;
 				default: break;
 				}
 			}
 		);
 	}
 
-	void Window::Update() {
-		glfwSwapBuffers(m_Window);
+	void Window::Queue(const QueuedEvent &event) {
+		m_QueuedSinceWake |= m_Events.TryPush(event);
+	}
+
+	void Window::WakeConsumer() {
+		if (!m_QueuedSinceWake)
+			return;
+		m_QueuedSinceWake = false;
+
+		// the consumer checks the queue with the lock held, so once we have
+		// had it the consumer is either waiting or will see the events
+		{ std::lock_guard<std::mutex> lock(m_WakeMutex); }
+		m_Wake.notify_one();
+	}
+
+	void Window::WaitForQueuedEvents(double timeout) {
+		std::unique_lock<std::mutex> lock(m_WakeMutex);
+		m_Wake.wait_for(lock, std::chrono::duration<double>(timeout), [this] {
+			return !m_Events.IsEmpty();
+		});
+	}
+
+	void Window::DispatchEvents() {
+		// a mouse move waits until the next event that isn't one
+		QueuedEvent move;
+		bool moved = false;
+
+		QueuedEvent queued;
+		while (true) {
+			bool popped = m_Events.TryPop(queued);
+			if (popped && queued.type == MouseMoved) {
+				move = queued;
+				moved = true;
+				continue;
+			}
+			if (moved) {
+				MouseMovedEvent e(move.x, move.y);
+				m_OnEventFunc(e);
+				moved = false;
+			}
+			if (!popped)
+				break;
+
+			switch (queued.type) {
+			case WindowClosed: {
+				WindowClosedEvent e;
+				m_OnEventFunc(e);
+				break;
+			}
+			case WindowResized: {
+				WindowResizedEvent e(queued.code, queued.extra);
+				m_OnEventFunc(e);
+				break;
+			}
+			case MouseButtonPressed: {
+				MouseButtonPressedEvent e(queued.code, queued.x, queued.y);
+				m_OnEventFunc(e);
+				break;
+			}
+			case MouseButtonReleased: {
+				MouseButtonReleasedEvent e(queued.code, queued.x, queued.y);
+				m_OnEventFunc(e);
+				break;
+			}
+			case KeyPressed: {
+				KeyPressedEvent e(queued.code);
+				m_OnEventFunc(e);
+				break;
+			}
+			case KeyReleased: {
+				KeyReleasedEvent e(queued.code);
+				m_OnEventFunc(e);
+				break;
+			}
+			default: break;
+			}
+		}
+	}
+
+	void Window::PollEvents() {
 		glfwPollEvents();
+		WakeConsumer();
+	}
+
+	void Window::WaitEvents(double timeout) {
+		glfwWaitEventsTimeout(timeout);
+		WakeConsumer();
 	}
 
 	GLFWwindow *Window::GetWindow() { return m_Window; }
 
 	bool Window::OnEvent_WindowClosed(WindowClosedEvent &e) {
 		m_ShouldCloseWindow = true;
+		// the polling thread may be waiting for input
+		glfwPostEmptyEvent();
 		return true;
 	}
 
@@ -6,8 +6,12 @@
 #include "Events/KeyboardEvents.h"
 #include "Events/MouseEvents.h"
 #include "Events/WindowEvents.h"
+#include "SpscQueue.h"
 
+#include <atomic>
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
 
 namespace Engine
 {
@@ -25,7 +29,21 @@ namespace Engine
 
 		void SetWindowCallbacks();
 
-		void Update();
+		// presenting is up to whoever renders, see RenderThread. Only on
+		// the thread that created the window.
+		void PollEvents();
+
+		// PollEvents, but waits up to timeout seconds for an event first
+		void WaitEvents(double timeout);
+
+		// the thread handling events: waits up to timeout seconds for the
+		// callbacks to queue something
+		void WaitForQueuedEvents(double timeout);
+
+		// the thread handling events: hands every event queued by the
+		// callbacks since the last call to the event function, in order,
+		// with each run of mouse moves cut down to its last position
+		void DispatchEvents();
 
 		GLFWwindow *GetWindow();
 
@@ -33,17 +51,49 @@ namespace Engine
 
 		bool OnEvent_WindowResize(WindowResizedEvent &e);
 
-		inline bool GetShouldCloseWindow() const { return m_ShouldCloseWindow; }
+		inline bool GetShouldCloseWindow() const {
+			return m_ShouldCloseWindow.load(std::memory_order_relaxed);
+		}
 
 		std::function<void(Event &)> m_OnEventFunc;
 
 	private:
+		// what a callback queues, the Event is only built when dispatched
+		struct QueuedEvent {
+			EventType type = WindowClosed;
+			// button, key or width
+			int code = 0;
+			// height
+			int extra = 0;
+			float x = 0, y = 0;
+		};
+
+		// the callbacks run inside glfwPollEvents and only queue the event,
+		// so whatever handles it (moves, legal move generation) runs on the
+		// thread handling events instead of holding up input polling. A full
+		// queue drops the event instead of waiting.
+		void Queue(const QueuedEvent &event);
+
+		// after polling, wakes the thread handling events if anything was
+		// queued
+		void WakeConsumer();
+
+	private:
+		static constexpr size_t EventQueueSize = 1024;
+
 		GLFWwindow *m_Window;
 
+		SpscQueue<QueuedEvent, EventQueueSize> m_Events;
+		// polling thread only
+		bool m_QueuedSinceWake = false;
+		std::mutex m_WakeMutex;
+		std::condition_variable m_Wake;
+
 		unsigned int m_WindowWidth, m_WindowHeight;
 		const char *m_WindowTitle;
 
-		bool m_ShouldCloseWindow;
+		// set by the thread handling events, read by the polling one
+		std::atomic<bool> m_ShouldCloseWindow;
 	};
 
 
@@ -0,0 +1,198 @@
+#include "AnalysisService.h"
+
+#include <chrono>
+
+AnalysisService::AnalysisService(
+	int threads /*=1*/, size_t hashMegabytes /*=16*/
+)
+	: m_Search(threads, hashMegabytes) {
+	m_Worker = std::thread(&AnalysisService::Run, this);
+}
+
+AnalysisService::~AnalysisService() {
+	Cancel();
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Quit = true;
+	}
+	m_Wake.notify_one();
+	m_Worker.join();
+}
+
+uint64_t
+AnalysisService::StartSearch(const BoardState &state, const SearchLimits &limits) {
+	Job job;
+	job.type = Job::Search;
+	job.state = state;
+	job.limits = limits;
+	StartJob(std::move(job));
+	return m_LastJob;
+}
+
+uint64_t
+AnalysisService::StartPerft(const BoardState &state, int depth, bool divide) {
+	Job job;
+	job.type = Job::Perft;
+	job.state = state;
+	job.depth = depth;
+	job.divide = divide;
+	StartJob(std::move(job));
+	return m_LastJob;
+}
+
+void AnalysisService::Cancel() {
+	m_CurrentJob = 0;
+	m_Busy = false;
+	m_Search.Stop();
+}
+
+bool AnalysisService::Poll(Result &result) {
+	uint64_t current = m_CurrentJob.load(std::memory_order_relaxed);
+	while (m_Results.TryPop(result)) {
+		if (result.job != current)
+			continue;
+
+		if (result.type == Result::BestMove || result.type == Result::PerftDone)
+			m_Busy = false;
+		return true;
+	}
+	return false;
+}
+
+void AnalysisService::StartJob(Job &&job) {
+	job.id = ++m_LastJob;
+	m_CurrentJob = job.id;
+	m_Busy = true;
+	// the old job notices the new id on its own, only the search needs to
+	// be told
+	m_Search.Stop();
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Pending = std::move(job);
+		m_HasPending = true;
+	}
+	m_Wake.notify_one();
+}
+
+void AnalysisService::Run() {
+	Job job;
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Wake.wait(lock, [this] { return m_Quit || m_HasPending; });
+			if (m_Quit)
+				return;
+
+			job = std::move(m_Pending);
+			m_HasPending = false;
+		}
+
+		if (IsCancelled(job.id))
+			continue;
+
+		if (job.type == Job::Search)
+			RunSearch(job);
+		else
+			RunPerft(job);
+	}
+}
+
+void AnalysisService::RunSearch(Job &job) {
+	using namespace std::chrono;
+	auto start = steady_clock::now();
+
+	Result result;
+	result.job = job.id;
+
+	BoardMove best =
+		m_Search.Think(job.state, job.limits, [&](const SearchInfo &info) {
+			// a cancel that came in before the search started was
+			// cleared by it, pass it on again
+			if (IsCancelled(job.id)) {
+				m_Search.Stop();
+				return;
+			}
+
+			result.info = info;
+			Result update = result;
+			update.type = Result::Info;
+			Publish(std::move(update));
+		});
+
+	// info is the last iteration the search finished
+	result.type = Result::BestMove;
+	result.move = best;
+	result.nodes = m_Search.GetNodes();
+	result.timeMs =
+		duration_cast<milliseconds>(steady_clock::now() - start).count();
+	Publish(std::move(result));
+}
+
+void AnalysisService::RunPerft(Job &job) {
+	using namespace std::chrono;
+	auto start = steady_clock::now();
+
+	Result result;
+	result.job = job.id;
+
+	if (job.divide && job.depth > 0) {
+		MoveList moves;
+		job.state.GenerateLegalMoves(moves);
+		for (BoardMove move : moves) {
+			if (IsCancelled(job.id))
+				return;
+
+			job.state.MakeMove(move);
+			uint64_t nodes = Perft(job.state, job.depth - 1, job.id);
+			job.state.UndoMove(move);
+
+			Result divide = result;
+			divide.type = Result::PerftDivide;
+			divide.move = move;
+			divide.nodes = nodes;
+			Publish(std::move(divide));
+			result.nodes += nodes;
+		}
+	} else {
+		result.nodes = Perft(job.state, job.depth, job.id);
+	}
+
+	result.type = Result::PerftDone;
+	result.timeMs =
+		duration_cast<milliseconds>(steady_clock::now() - start).count();
+	Publish(std::move(result));
+}
+
+uint64_t AnalysisService::Perft(BoardState &state, int depth, uint64_t job) {
+	if (depth == 0)
+		return 1;
+
+	// checked once per node above the leaves, each of which bulk counts a
+	// batch of up to a couple hundred leaves
+	if (IsCancelled(job))
+		return 0;
+
+	if (depth == 1)
+		return state.CountLegalMoves();
+
+	MoveList moves;
+	state.GenerateLegalMoves(moves);
+
+	uint64_t nodes = 0;
+	for (BoardMove move : moves) {
+		state.MakeMove(move);
+		nodes += Perft(state, depth - 1, job);
+		state.UndoMove(move);
+	}
+	return nodes;
+}
+
+void AnalysisService::Publish(Result &&result) {
+	while (!m_Results.TryPush(std::move(result))) {
+		if (result.type == Result::Info || IsCancelled(result.job))
+			return;
+		std::this_thread::yield();
+	}
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "Board/BoardState.h"
+#include "Engine/SpscQueue.h"
+#include "SmpSearch.h"
+
+// Runs searches and perfts on worker threads so the render loop never
+// waits on them. Jobs are position snapshots handed over with Start*,
+// results come back through a lock-free queue that the render loop drains
+// with Poll every frame. Starting a job cancels the one before it, the
+// old job stops within one node (search) or one batch of bulk counted
+// leaves (perft) and whatever it still reports is dropped by Poll.
+//
+// Start*, Cancel, Poll and IsBusy are for one thread (the render loop).
+class AnalysisService
+{
+public:
+	struct Result {
+		enum Type {
+			// an iteration of a search finished, see info
+			Info,
+			// a search is done, move is the best move
+			BestMove,
+			// nodes below the root move move, for perfts with divide
+			PerftDivide,
+			// a perft is done, nodes in total
+			PerftDone
+		};
+
+		Type type = Info;
+		uint64_t job = 0;
+		SearchInfo info;
+		BoardMove move;
+		uint64_t nodes = 0;
+		int64_t timeMs = 0;
+	};
+
+public:
+	explicit AnalysisService(int threads = 1, size_t hashMegabytes = 16);
+
+	~AnalysisService();
+
+	// searches state until one of the limits is hit, returns the job id
+	// the results carry
+	uint64_t StartSearch(const BoardState &state, const SearchLimits &limits);
+
+	// counts the leaves depth plies below state, with divide the count
+	// below every root move is reported as well
+	uint64_t StartPerft(const BoardState &state, int depth, bool divide);
+
+	// stops the current job without starting another
+	void Cancel();
+
+	// takes the next result of the current job, false if there is none
+	// right now. Never blocks.
+	bool Poll(Result &result);
+
+	// whether the current job hasn't delivered its final result yet
+	inline bool IsBusy() const { return m_Busy; }
+
+private:
+	struct Job {
+		enum Type { Search, Perft };
+
+		Type type = Search;
+		uint64_t id = 0;
+		BoardState state;
+		SearchLimits limits;
+		int depth = 0;
+		bool divide = false;
+	};
+
+	void StartJob(Job &&job);
+
+	void Run();
+
+	void RunSearch(Job &job);
+
+	void RunPerft(Job &job);
+
+	uint64_t Perft(BoardState &state, int depth, uint64_t job);
+
+	inline bool IsCancelled(uint64_t job) const {
+		return m_CurrentJob.load(std::memory_order_relaxed) != job;
+	}
+
+	// Info results are dropped when the queue is full (the next one comes
+	// soon enough), anything else waits for the render loop to make room
+	// unless its job was cancelled
+	void Publish(Result &&result);
+
+private:
+	SmpSearch m_Search;
+
+	std::thread m_Worker;
+	std::mutex m_Mutex;
+	std::condition_variable m_Wake;
+	Job m_Pending;
+	bool m_HasPending = false;
+	bool m_Quit = false;
+
+	// id of the job results are wanted for, 0 once cancelled
+	std::atomic<uint64_t> m_CurrentJob = 0;
+	uint64_t m_LastJob = 0;
+	bool m_Busy = false;
+
+	Engine::SpscQueue<Result, 256> m_Results;
+};
@@ -0,0 +1,134 @@
+#include "Evaluation.h"
+
+#include <algorithm>
+
+using namespace BitBoards;
+
+namespace
+{
+	constexpr TaperedScore DoubledPawn = {-10, -25};
+	constexpr TaperedScore IsolatedPawn = {-8, -15};
+	// can't be defended by a pawn and can't advance safely
+	constexpr TaperedScore BackwardPawn = {-8, -12};
+	// by rank from the pawn's own side
+	constexpr TaperedScore PassedPawn[8] = {{0, 0},   {0, 10},   {5, 15},
+	                                        {10, 25}, {25, 45},  {45, 80},
+	                                        {70, 120}, {0, 0}};
+
+	// king shelter, per file in front of and next to the king
+	constexpr int ShieldPawnClose = 20;
+	constexpr int ShieldPawnFar = 10;
+	constexpr int ShieldPawnMissing = -15;
+	// no pawns of either color, the file is open for rooks
+	constexpr int ShieldFileOpen = -10;
+
+	// every rank in front of rank, as seen by color
+	inline BitBoard RanksAhead(Color color, int rank) {
+		if (color == White)
+			return rank == 7 ? 0 : All << (8 * (rank + 1));
+		return (1ULL << (8 * rank)) - 1;
+	}
+
+	inline int KingShelter(
+		const BoardState &state, const PawnEntry &pawns, Color color
+	) {
+		int kingSq = state.GetKingSquare(color);
+		int rank = color == White ? kingSq / 8 : 7 - kingSq / 8;
+		return rank <= 1 ? pawns.shelter[color][kingSq % 8] : 0;
+	}
+} // namespace
+
+int Evaluation::Evaluate(const BoardState &state) {
+	const BitBoard pawns[2] = {
+		state.GetPieces(Black, PawnPiece), state.GetPieces(White, PawnPiece)};
+	PawnEntry entry;
+	EvaluatePawns(pawns, entry);
+	return Combine(state, entry);
+}
+
+int Evaluation::Evaluate(const BoardState &state, PawnTable &pawnTable) {
+	return Combine(state, pawnTable.Probe(state));
+}
+
+int Evaluation::Material(const BoardState &state, Color color) {
+	int material = 0;
+	for (int type = PawnPiece; type < KingPiece; type++)
+		material += BitBoards::PopCount(state.GetPieces(color, (PieceType) type)) *
+		            PieceValues[type];
+	return material;
+}
+
+void Evaluation::EvaluatePawns(const BitBoard (&pawns)[2], PawnEntry &entry) {
+	entry.score = {};
+
+	for (int c = Black; c <= White; c++) {
+		Color color = (Color) c;
+		BitBoard own = pawns[color], enemy = pawns[!color];
+		BitBoard enemyAttacks =
+			color == White ? Shift<SouthEast>(enemy) | Shift<SouthWest>(enemy)
+						   : Shift<NorthEast>(enemy) | Shift<NorthWest>(enemy);
+		int forward = color == White ? North : South;
+
+		TaperedScore score;
+		entry.passed[color] = 0;
+
+		BitBoard remaining = own;
+		while (remaining) {
+			int sq = PopLowest(remaining);
+			int rank = sq / 8;
+			BitBoard file = FileA << (sq % 8);
+			BitBoard adjacentFiles = Shift<East>(file) | Shift<West>(file);
+			BitBoard ahead = RanksAhead(color, rank);
+
+			// only the rear pawn of a doubled pair pays
+			if (own & file & ahead)
+				score += DoubledPawn;
+
+			if (!(own & adjacentFiles))
+				score += IsolatedPawn;
+			else if (!(own & adjacentFiles & ~ahead) &&
+			         Contains(enemyAttacks, sq + forward))
+				score += BackwardPawn;
+
+			if (!(enemy & (file | adjacentFiles) & ahead)) {
+				entry.passed[color] |= SquareBB(sq);
+				score += PassedPawn[color == White ? rank : 7 - rank];
+			}
+		}
+
+		if (color == White)
+			entry.score += score;
+		else
+			entry.score -= score;
+
+		BitBoard closeRank = color == White ? Rank2 : Rank7;
+		BitBoard farRank = color == White ? Rank3 : Rank6;
+		for (int kingFile = 0; kingFile < 8; kingFile++) {
+			// a king on the edge is sheltered by the same three files as one
+			// next to it
+			int center = std::clamp(kingFile, 1, 6);
+			int shelter = 0;
+			for (int f = center - 1; f <= center + 1; f++) {
+				BitBoard file = FileA << f;
+				if (own & file & closeRank)
+					shelter += ShieldPawnClose;
+				else if (own & file & farRank)
+					shelter += ShieldPawnFar;
+				else
+					shelter += ShieldPawnMissing +
+					           ((own | enemy) & file ? 0 : ShieldFileOpen);
+			}
+			entry.shelter[color][kingFile] = (int16_t) shelter;
+		}
+	}
+}
+
+int Evaluation::Combine(const BoardState &state, const PawnEntry &pawns) {
+	TaperedScore score = state.GetPsqt();
+	score += pawns.score;
+	score.middlegame +=
+		KingShelter(state, pawns, White) - KingShelter(state, pawns, Black);
+
+	int blended = PieceSquareTables::Blend(score, state.GetPhase());
+	return state.GetTurn() == White ? blended : -blended;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Board/BoardState.h"
+#include "PawnTable.h"
+
+// Static evaluation of a BoardState in centipawns, from the point of view
+// of the side to move: material and piece-square values plus pawn
+// structure and king shelter, blended between middlegame and endgame by the
+// game phase. BoardState keeps the first two summed up as moves are made
+// and the pawn terms come from a PawnTable, so evaluating is O(1) on a pawn
+// table hit.
+class Evaluation
+{
+public:
+	// indexed by PieceType, rough values for pruning margins
+	static constexpr int PieceValues[6] = {100, 320, 330, 500, 900, 0};
+
+	// works out the pawn terms on the spot
+	static int Evaluate(const BoardState &state);
+
+	static int Evaluate(const BoardState &state, PawnTable &pawnTable);
+
+	static int Material(const BoardState &state, Color color);
+
+	// everything in entry but the key, pawns indexed by Color
+	static void EvaluatePawns(const BitBoard (&pawns)[2], PawnEntry &entry);
+
+private:
+	static int Combine(const BoardState &state, const PawnEntry &pawns);
+};
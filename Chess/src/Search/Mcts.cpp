@@ -0,0 +1,492 @@
+#include "Mcts.h"
+
+#include <cmath>
+#include <thread>
+
+#include "Evaluation.h"
+
+namespace
+{
+	// centipawns at which a static evaluation counts as about three
+	// quarters of a win
+	constexpr float EvaluationScale = 400.0f;
+
+	// playouts between two looks at the clock by the main worker
+	constexpr int TimeCheckInterval = 16;
+
+	// xorshift64*, each worker runs its own
+	inline uint64_t NextRandom(uint64_t &state) {
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return state * 0x2545F4914F6CDD1Dull;
+	}
+
+	inline float ToValue(int centipawns) {
+		return std::tanh((float) centipawns / EvaluationScale);
+	}
+
+	inline int ToCentipawns(double value) {
+		return (int) std::lround(
+			EvaluationScale * std::atanh(std::clamp(value, -0.999, 0.999))
+		);
+	}
+
+	// how promising a move looks before it is searched, the priors are
+	// the softmax of these. Winning captures and promotions first, then
+	// quiet moves, losing captures last.
+	float PriorLogit(const BoardState &state, BoardMove move) {
+		float logit = 0;
+		if (move.IsPromotion())
+			logit += move.GetPromotionType() == QueenPiece ? 2.0f : -1.0f;
+		if (move.IsCapture()) {
+			int see = state.See(move);
+			logit += see >= 0 ? 1.0f + std::min(see, 900) / 300.0f : -1.0f;
+		} else if (move.IsCastle()) {
+			logit += 0.5f;
+		}
+		return logit;
+	}
+} // namespace
+
+float MctsStaticEvaluator::Evaluate(BoardState &state, uint64_t &) const {
+	return ToValue(Evaluation::Evaluate(state));
+}
+
+float MctsPlayoutEvaluator::Evaluate(BoardState &state, uint64_t &random)
+	const {
+	BoardMove played[Search::MaxPly];
+	int plies = 0;
+	int maxPlies = std::clamp(m_MaxPlies, 0, Search::MaxPly);
+
+	float value;
+	MoveList moves;
+	while (true) {
+		state.GenerateLegalMoves(moves);
+		if (moves.size == 0) {
+			value = state.IsInCheck() ? -1.0f : 0.0f;
+			break;
+		}
+		if (state.GetHalfMoveClock() >= 100) {
+			value = 0;
+			break;
+		}
+		if (plies == maxPlies) {
+			value = ToValue(Evaluation::Evaluate(state));
+			break;
+		}
+		BoardMove move = moves.moves[NextRandom(random) % moves.size];
+		state.MakeMove(move);
+		played[plies++] = move;
+	}
+
+	// value is for whoever was to move where the playout stopped
+	if (plies & 1)
+		value = -value;
+	while (plies > 0) state.UndoMove(played[--plies]);
+	return value;
+}
+
+void Mcts::Node::Reset(BoardMove move, float prior) {
+	valueSum.store(0, std::memory_order_relaxed);
+	visits.store(0, std::memory_order_relaxed);
+	virtualLoss.store(0, std::memory_order_relaxed);
+	firstChild = 0;
+	this->prior = prior;
+	this->move = move;
+	childCount = 0;
+	state.store(Unexpanded, std::memory_order_relaxed);
+	terminalValue = 0;
+}
+
+void Mcts::Node::CopyFrom(const Node &other) {
+	valueSum.store(
+		other.valueSum.load(std::memory_order_relaxed),
+		std::memory_order_relaxed
+	);
+	visits.store(
+		other.visits.load(std::memory_order_relaxed), std::memory_order_relaxed
+	);
+	virtualLoss.store(0, std::memory_order_relaxed);
+	firstChild = other.firstChild;
+	prior = other.prior;
+	move = other.move;
+	childCount = other.childCount;
+	state.store(
+		other.state.load(std::memory_order_relaxed), std::memory_order_relaxed
+	);
+	terminalValue = other.terminalValue;
+}
+
+Mcts::Mcts(size_t megabytes) { Resize(megabytes); }
+
+void Mcts::Resize(size_t megabytes) {
+	// half of it for each arena
+	m_Capacity =
+		std::max<size_t>(megabytes * 1024 * 1024 / 2 / sizeof(Node), 1024);
+	for (Arena &arena : m_Arenas) {
+		arena.nodes = std::make_unique<Node[]>(m_Capacity);
+		arena.used = 0;
+	}
+	Clear();
+}
+
+void Mcts::Clear() {
+	m_HasTree = false;
+	m_ReusedNodes = 0;
+}
+
+void Mcts::SetEvaluator(const MctsEvaluator *evaluator) {
+	m_Evaluator = evaluator ? evaluator : &m_StaticEvaluator;
+}
+
+BoardMove Mcts::Think(
+	const BoardState &state, const SearchLimits &limits,
+	const Search::InfoCallback &onInfo
+) {
+	m_Limits = limits;
+	m_Stop = false;
+	m_PonderHit = false;
+	m_Playouts = 0;
+	m_TreeFull = false;
+	m_StartTime = std::chrono::steady_clock::now();
+	m_Time.Start(limits);
+
+	SetRoot(state);
+	Node &root = Root();
+	if (root.state.load(std::memory_order_relaxed) == Unexpanded)
+		Expand(root, m_RootState);
+	if (root.state.load(std::memory_order_relaxed) != Expanded) {
+		m_SearchTimeUs = ElapsedMicroseconds();
+		return {};
+	}
+
+	std::vector<std::thread> helpers;
+	for (int i = 1; i < m_Threads; i++)
+		helpers.emplace_back(&Mcts::RunWorker, this, i);
+
+	// the main worker also keeps an eye on the limits and reports
+	BoardState board = m_RootState;
+	uint64_t random = 0x9E3779B97F4A7C15ull;
+	Node *path[Search::MaxPly + 1];
+	int64_t nextInfoUs = InfoIntervalMs * 1000;
+	int countdown = TimeCheckInterval;
+	while (!m_Stop) {
+		Playout(board, random, path);
+
+		if (m_PonderHit.load(std::memory_order_relaxed) &&
+		    m_PonderHit.exchange(false))
+			m_Time.PonderHit();
+
+		if (m_Limits.nodes &&
+		    m_Playouts.load(std::memory_order_relaxed) >= m_Limits.nodes)
+			m_Stop = true;
+
+		if (--countdown > 0)
+			continue;
+		countdown = TimeCheckInterval;
+		// the search can end after any playout, so there is no reason to
+		// go past the optimum
+		int64_t elapsed = ElapsedMicroseconds();
+		if (m_Time.IsActive() && elapsed >= m_Time.GetOptimumMs() * 1000)
+			m_Stop = true;
+		else if (onInfo && elapsed >= nextInfoUs) {
+			onInfo(MakeInfo());
+			nextInfoUs = elapsed + InfoIntervalMs * 1000;
+		}
+	}
+
+	for (std::thread &helper : helpers) helper.join();
+	m_SearchTimeUs = ElapsedMicroseconds();
+
+	SearchInfo info = MakeInfo();
+	if (onInfo)
+		onInfo(info);
+	return info.pv.empty() ? MostVisited(root)->move : info.pv[0];
+}
+
+MctsStats Mcts::GetStats() const {
+	MctsStats stats;
+	stats.playouts = m_Playouts.load(std::memory_order_relaxed);
+	stats.timeMs = m_SearchTimeUs / 1000;
+	stats.playoutsPerSecond =
+		stats.playouts * 1000000 / std::max<int64_t>(m_SearchTimeUs, 1);
+	stats.treeNodes = std::min(
+		m_Arenas[m_Current].used.load(std::memory_order_relaxed), m_Capacity
+	);
+	stats.treeBytes = stats.treeNodes * sizeof(Node);
+	stats.capacityBytes = 2 * m_Capacity * sizeof(Node);
+	stats.reusedNodes = m_ReusedNodes;
+	return stats;
+}
+
+void Mcts::RunWorker(int index) {
+	BoardState board = m_RootState;
+	uint64_t random = 0x9E3779B97F4A7C15ull * (index + 1);
+	Node *path[Search::MaxPly + 1];
+	while (!m_Stop) {
+		Playout(board, random, path);
+
+		// the main worker only notices the node limit after its own
+		// playout, which may take much longer than ours
+		if (m_Limits.nodes &&
+		    m_Playouts.load(std::memory_order_relaxed) >= m_Limits.nodes)
+			return;
+	}
+}
+
+void Mcts::Playout(BoardState &state, uint64_t &random, Node **path) {
+	Node *node = &Root();
+	path[0] = node;
+	int length = 0;
+
+	float value;
+	while (true) {
+		uint8_t nodeState = node->state.load(std::memory_order_acquire);
+		if (nodeState == Terminal) {
+			value = node->terminalValue;
+			break;
+		}
+		if (nodeState == Expanded && length < Search::MaxPly) {
+			Node &child = SelectChild(*node);
+			child.virtualLoss.fetch_add(1, std::memory_order_relaxed);
+			state.MakeMove(child.move);
+			path[++length] = node = &child;
+			continue;
+		}
+		if (state.GetHalfMoveClock() >= 100) {
+			value = 0;
+			break;
+		}
+
+		// a leaf, expanded by whoever gets there first. Others that arrive
+		// while it is being expanded, or once the tree is full, just
+		// evaluate it.
+		uint8_t expected = Unexpanded;
+		if (nodeState == Unexpanded &&
+		    !m_TreeFull.load(std::memory_order_relaxed) &&
+		    node->state.compare_exchange_strong(
+				expected, Expanding, std::memory_order_acq_rel
+			)) {
+			if (!Expand(*node, state)) {
+				m_TreeFull = true;
+				node->state.store(Unexpanded, std::memory_order_release);
+			} else if (node->state.load(std::memory_order_relaxed) ==
+			           Terminal) {
+				value = node->terminalValue;
+				break;
+			}
+		}
+		value = m_Evaluator->Evaluate(state, random);
+		break;
+	}
+
+	// value is for the side to move at the leaf, every node stores it for
+	// the side that moved into it
+	for (int i = length; i >= 0; i--) {
+		value = -value;
+		Node &pathNode = *path[i];
+		pathNode.valueSum.fetch_add(
+			std::llround(value * ValueScale), std::memory_order_relaxed
+		);
+		pathNode.visits.fetch_add(1, std::memory_order_relaxed);
+		if (i > 0) {
+			pathNode.virtualLoss.fetch_sub(1, std::memory_order_relaxed);
+			state.UndoMove(pathNode.move);
+		}
+	}
+
+	m_Playouts.fetch_add(1, std::memory_order_relaxed);
+}
+
+Mcts::Node &Mcts::SelectChild(Node &node) {
+	uint32_t visits = node.visits.load(std::memory_order_relaxed);
+	float sqrtVisits = std::sqrt((float) std::max<uint32_t>(
+		visits + node.virtualLoss.load(std::memory_order_relaxed), 1
+	));
+
+	// an unvisited child is assumed to be a bit worse than the node itself,
+	// whose value is stored for the other side
+	float firstPlay = -FirstPlayReduction;
+	if (visits)
+		firstPlay -= (float) (node.valueSum.load(std::memory_order_relaxed) /
+		                      ValueScale / visits);
+
+	Node *children = &GetNode(node.firstChild);
+	Node *best = children;
+	float bestScore = -1e9f;
+	for (int i = 0; i < node.childCount; i++) {
+		Node &child = children[i];
+		uint32_t childVisits = child.visits.load(std::memory_order_relaxed);
+		// every virtual loss is counted as a visit that lost
+		uint32_t virtualLoss =
+			child.virtualLoss.load(std::memory_order_relaxed);
+		uint32_t total = childVisits + virtualLoss;
+
+		float q = firstPlay;
+		if (total)
+			q = (float) ((child.valueSum.load(std::memory_order_relaxed) /
+			                  ValueScale -
+			              virtualLoss) /
+			             total);
+		float score = q + Exploration * child.prior * sqrtVisits / (1 + total);
+		if (score > bestScore) {
+			bestScore = score;
+			best = &child;
+		}
+	}
+	return *best;
+}
+
+const Mcts::Node *Mcts::MostVisited(const Node &node) const {
+	const Node *children = &GetNode(node.firstChild);
+	const Node *best = children;
+	for (int i = 1; i < node.childCount; i++)
+		if (children[i].visits.load(std::memory_order_relaxed) >
+		    best->visits.load(std::memory_order_relaxed))
+			best = &children[i];
+	return best;
+}
+
+bool Mcts::Expand(Node &node, const BoardState &state) {
+	MoveList moves;
+	state.GenerateLegalMoves(moves);
+	if (moves.size == 0) {
+		node.terminalValue = state.IsInCheck() ? -1 : 0;
+		node.state.store(Terminal, std::memory_order_release);
+		return true;
+	}
+
+	Arena &arena = m_Arenas[m_Current];
+	size_t first = arena.used.fetch_add(moves.size, std::memory_order_relaxed);
+	if (first + moves.size > m_Capacity)
+		return false;
+
+	float priors[256];
+	float maxLogit = -1e9f;
+	for (int i = 0; i < moves.size; i++) {
+		priors[i] = PriorLogit(state, moves.moves[i]);
+		maxLogit = std::max(maxLogit, priors[i]);
+	}
+	float sum = 0;
+	for (int i = 0; i < moves.size; i++)
+		sum += priors[i] = std::exp(priors[i] - maxLogit);
+
+	for (int i = 0; i < moves.size; i++)
+		arena.nodes[first + i].Reset(moves.moves[i], priors[i] / sum);
+
+	node.firstChild = (uint32_t) first;
+	node.childCount = (uint16_t) moves.size;
+	// publishes the children to the other workers
+	node.state.store(Expanded, std::memory_order_release);
+	return true;
+}
+
+void Mcts::SetRoot(const BoardState &state) {
+	uint64_t key = state.GetKey();
+	Node *found = nullptr;
+	if (m_HasTree) {
+		BoardState board = m_RootState;
+		found = FindNode(Root(), board, key, 2);
+	}
+
+	if (found)
+		KeepSubtree((uint32_t) (found - m_Arenas[m_Current].nodes.get()));
+	else {
+		Arena &arena = m_Arenas[m_Current];
+		arena.nodes[0].Reset({}, 1);
+		arena.used = 1;
+		m_ReusedNodes = 0;
+	}
+
+	m_RootState = state;
+	m_HasTree = true;
+}
+
+void Mcts::KeepSubtree(uint32_t node) {
+	Arena &from = m_Arenas[m_Current];
+	Arena &to = m_Arenas[1 - m_Current];
+
+	// breadth first, so the children of every node stay one slice. The
+	// copies point into the old arena until they are reached.
+	to.nodes[0].CopyFrom(from.nodes[node]);
+	size_t used = 1;
+	for (size_t i = 0; i < used; i++) {
+		Node &copy = to.nodes[i];
+		if (copy.state.load(std::memory_order_relaxed) != Expanded)
+			continue;
+		uint32_t source = copy.firstChild;
+		copy.firstChild = (uint32_t) used;
+		for (int child = 0; child < copy.childCount; child++)
+			to.nodes[used + child].CopyFrom(from.nodes[source + child]);
+		used += copy.childCount;
+	}
+
+	to.used = used;
+	m_Current = 1 - m_Current;
+	m_ReusedNodes = used;
+}
+
+Mcts::Node *
+Mcts::FindNode(Node &node, BoardState &board, uint64_t key, int plies) {
+	if (board.GetKey() == key)
+		return &node;
+	if (plies == 0 || node.state.load(std::memory_order_relaxed) != Expanded)
+		return nullptr;
+
+	Node *children = &GetNode(node.firstChild);
+	for (int i = 0; i < node.childCount; i++) {
+		board.MakeMove(children[i].move);
+		Node *found = FindNode(children[i], board, key, plies - 1);
+		board.UndoMove(children[i].move);
+		if (found)
+			return found;
+	}
+	return nullptr;
+}
+
+SearchInfo Mcts::MakeInfo() const {
+	SearchInfo info;
+	const Node *node = &Root();
+	while (node->state.load(std::memory_order_acquire) == Expanded &&
+	       (int) info.pv.size() < Search::MaxPly) {
+		node = MostVisited(*node);
+		if (!node->visits.load(std::memory_order_relaxed))
+			break;
+		info.pv.push_back(node->move);
+	}
+
+	if (!info.pv.empty()) {
+		const Node &best = *MostVisited(Root());
+		uint32_t visits = best.visits.load(std::memory_order_relaxed);
+		if (best.state.load(std::memory_order_relaxed) == Terminal &&
+		    best.terminalValue < 0)
+			info.score = Search::MateScore - 1;
+		else
+			info.score = ToCentipawns(
+				best.valueSum.load(std::memory_order_relaxed) / ValueScale /
+				std::max<uint32_t>(visits, 1)
+			);
+	}
+
+	int64_t elapsed = ElapsedMicroseconds();
+	info.depth = (int) info.pv.size();
+	info.nodes = m_Playouts.load(std::memory_order_relaxed);
+	info.timeMs = elapsed / 1000;
+	info.nps = info.nodes * 1000000 / std::max<int64_t>(elapsed, 1);
+	info.hashFull = (int) (std::min(
+							   m_Arenas[m_Current].used.load(
+								   std::memory_order_relaxed
+							   ),
+							   m_Capacity
+						   ) *
+	                       1000 / m_Capacity);
+	return info;
+}
+
+int64_t Mcts::ElapsedMicroseconds() const {
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+			   std::chrono::steady_clock::now() - m_StartTime
+	)
+		.count();
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include "Board/BoardState.h"
+#include "Search.h"
+#include "TimeManager.h"
+
+// Values a leaf the first time MCTS reaches it. One evaluator is shared by
+// every worker, so Evaluate is called from several threads at once.
+class MctsEvaluator
+{
+public:
+	virtual ~MctsEvaluator() = default;
+
+	// expected result for the side to move, from -1 (lost) to 1 (won).
+	// state may be changed as long as it is put back, random is the
+	// calling worker's own generator state.
+	virtual float Evaluate(BoardState &state, uint64_t &random) const = 0;
+};
+
+// the static evaluation squashed into a result
+class MctsStaticEvaluator : public MctsEvaluator
+{
+public:
+	float Evaluate(BoardState &state, uint64_t &random) const override;
+};
+
+// plays random legal moves up to maxPlies deep and scores where the game
+// ended, or the static evaluation of where it stopped
+class MctsPlayoutEvaluator : public MctsEvaluator
+{
+public:
+	explicit MctsPlayoutEvaluator(int maxPlies = 40) : m_MaxPlies(maxPlies) {}
+
+	float Evaluate(BoardState &state, uint64_t &random) const override;
+
+private:
+	int m_MaxPlies;
+};
+
+struct MctsStats {
+	uint64_t playouts = 0;
+	uint64_t playoutsPerSecond = 0;
+	int64_t timeMs = 0;
+	// nodes in the tree and the memory they take, out of the arena's
+	size_t treeNodes = 0;
+	size_t treeBytes = 0;
+	size_t capacityBytes = 0;
+	// nodes kept from the last search's tree
+	size_t reusedNodes = 0;
+};
+
+// Monte Carlo tree search with PUCT selection, for experimenting next to
+// the alpha-beta Search. Worker threads descend the same tree at once,
+// each adding a virtual loss to the nodes on its way down so the others
+// spread out over different lines, and expand and evaluate one leaf per
+// playout. The tree lives in a preallocated arena of nodes where the
+// children of a node are one contiguous slice. When the next position is
+// the root or two plies below it (our move and the reply), the subtree
+// that was already built is kept.
+class Mcts
+{
+public:
+	// exploration constant of PUCT and how much worse than its parent an
+	// unvisited child is assumed to be
+	static constexpr float Exploration = 1.5f;
+	static constexpr float FirstPlayReduction = 0.2f;
+
+	// how often the main worker reports while searching
+	static constexpr int64_t InfoIntervalMs = 1000;
+
+public:
+	explicit Mcts(size_t megabytes = 64);
+
+	// drops the tree
+	void Resize(size_t megabytes);
+
+	void Clear();
+
+	inline void SetThreadCount(int threads) {
+		m_Threads = std::max(threads, 1);
+	}
+
+	// evaluator has to outlive the searches, nullptr goes back to the
+	// static one. Not while Think is running.
+	void SetEvaluator(const MctsEvaluator *evaluator);
+
+	// searches until one of the limits is hit (nodes counts playouts, the
+	// depth is ignored) or Stop() is called. Once the tree is full its
+	// leaves are only evaluated, no longer expanded. onInfo
+	// gets the most visited line every InfoIntervalMs and at the end, with
+	// playouts as nodes and the tree's fill in hashfull. Returns the most
+	// visited move, a null move if there are no legal moves.
+	BoardMove Think(
+		const BoardState &state, const SearchLimits &limits,
+		const Search::InfoCallback &onInfo = nullptr
+	);
+
+	// can be called from any thread while Think is running
+	inline void Stop() { m_Stop = true; }
+
+	// see Search::PonderHit
+	inline void PonderHit() { m_PonderHit = true; }
+
+	// of the last search
+	MctsStats GetStats() const;
+
+private:
+	enum NodeState : uint8_t { Unexpanded, Expanding, Expanded, Terminal };
+
+	struct Node {
+		// from the point of view of the side that played move, in
+		// ValueScale units
+		std::atomic<int64_t> valueSum;
+		std::atomic<uint32_t> visits;
+		std::atomic<uint32_t> virtualLoss;
+		uint32_t firstChild;
+		float prior;
+		BoardMove move;
+		uint16_t childCount;
+		std::atomic<uint8_t> state;
+		// result for the side to move of a Terminal node
+		int8_t terminalValue;
+
+		void Reset(BoardMove move, float prior);
+
+		void CopyFrom(const Node &other);
+	};
+
+	static constexpr double ValueScale = 1 << 20;
+
+	struct Arena {
+		std::unique_ptr<Node[]> nodes;
+		std::atomic<size_t> used = 0;
+	};
+
+	void RunWorker(int index);
+
+	// one descent from the root to a leaf, evaluating it and backing the
+	// value up
+	void Playout(BoardState &state, uint64_t &random, Node **path);
+
+	// the child with the best PUCT score, counting virtual losses
+	Node &SelectChild(Node &node);
+
+	const Node *MostVisited(const Node &node) const;
+
+	// gives node its children, or makes it Terminal without legal moves.
+	// False if the arena is full.
+	bool Expand(Node &node, const BoardState &state);
+
+	// reroots the tree at state if it is in it, otherwise starts a new one
+	void SetRoot(const BoardState &state);
+
+	// copies the subtree of node into the other arena, which becomes the
+	// current one
+	void KeepSubtree(uint32_t node);
+
+	// the node up to plies below node (in the position board) whose
+	// position has key
+	Node *FindNode(Node &node, BoardState &board, uint64_t key, int plies);
+
+	SearchInfo MakeInfo() const;
+
+	inline Node &Root() { return m_Arenas[m_Current].nodes[0]; }
+
+	inline const Node &Root() const { return m_Arenas[m_Current].nodes[0]; }
+
+	inline Node &GetNode(uint32_t index) {
+		return m_Arenas[m_Current].nodes[index];
+	}
+
+	inline const Node &GetNode(uint32_t index) const {
+		return m_Arenas[m_Current].nodes[index];
+	}
+
+	int64_t ElapsedMicroseconds() const;
+
+private:
+	// two so that a subtree can be kept by copying it over
+	Arena m_Arenas[2];
+	int m_Current = 0;
+	size_t m_Capacity = 0;
+
+	BoardState m_RootState;
+	bool m_HasTree = false;
+	size_t m_ReusedNodes = 0;
+
+	int m_Threads = 1;
+	MctsStaticEvaluator m_StaticEvaluator;
+	const MctsEvaluator *m_Evaluator = &m_StaticEvaluator;
+
+	SearchLimits m_Limits;
+	TimeManager m_Time;
+	std::atomic<bool> m_Stop = false;
+	std::atomic<bool> m_PonderHit = false;
+	std::atomic<uint64_t> m_Playouts = 0;
+	std::atomic<bool> m_TreeFull = false;
+	std::chrono::steady_clock::time_point m_StartTime;
+	int64_t m_SearchTimeUs = 0;
+};
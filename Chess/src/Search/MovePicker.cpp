@@ -0,0 +1,250 @@
+#include "MovePicker.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+	// score bands, anything in a band beats everything in the ones below
+	constexpr int HashMoveScore = 1 << 30;
+	constexpr int GoodCaptureScore = 1 << 28;
+	constexpr int KillerScore = 1 << 27;
+	constexpr int CounterMoveScore = KillerScore - 2;
+	constexpr int BadCaptureScore = -(1 << 28);
+
+	inline bool IsTactical(BoardMove move) {
+		return move.IsCapture() ||
+		       (move.IsPromotion() && move.GetPromotionType() == QueenPiece);
+	}
+} // namespace
+
+////////////////////////////////// MoveHistory /////////////////////////////////
+
+void MoveHistory::Clear() {
+	for (auto &killer : killers) killer[0] = killer[1] = {};
+	for (auto &color : counterMoves)
+		for (auto &piece : color)
+			for (auto &move : piece) move = {};
+	for (auto &color : butterfly)
+		for (auto &from : color)
+			for (auto &entry : from) entry = 0;
+}
+
+void MoveHistory::UpdateQuiet(
+	const BoardState &state, BoardMove move, BoardMove previousMove, int ply,
+	int depth, const BoardMove *triedQuiets, int triedCount
+) {
+	if (killers[ply][0] != move) {
+		killers[ply][1] = killers[ply][0];
+		killers[ply][0] = move;
+	}
+
+	if (!previousMove.IsNull()) {
+		int to = previousMove.To();
+		counterMoves[!state.GetTurn()][state.GetPieceType(to)][to] = move;
+	}
+
+	Color us = state.GetTurn();
+	int bonus = std::min(depth * depth, 1200);
+	ApplyGravity(butterfly[us][move.From()][move.To()], bonus);
+	for (int i = 0; i < triedCount; i++)
+		ApplyGravity(
+			butterfly[us][triedQuiets[i].From()][triedQuiets[i].To()], -bonus
+		);
+}
+
+void MoveHistory::ApplyGravity(int16_t &entry, int bonus) {
+	entry += bonus - entry * std::abs(bonus) / MaxHistory;
+}
+
+////////////////////////////////// MovePicker //////////////////////////////////
+
+MovePicker::MovePicker(
+	const BoardState &state, BoardMove hashMove, const MoveHistory &history,
+	int ply, BoardMove previousMove
+)
+	: m_State(state), m_History(history), m_HashMove(hashMove) {
+	m_Killers[0] = history.killers[ply][0];
+	m_Killers[1] = history.killers[ply][1];
+	m_CounterMove = history.GetCounterMove(state, previousMove);
+
+	if (state.IsInCheck()) {
+		m_Stage = GenerateEvasionsStage;
+	} else {
+		m_Pinned = state.GetPinnedPieces();
+		m_Stage = HashMoveStage;
+	}
+}
+
+MovePicker::MovePicker(const BoardState &state, const MoveHistory &history)
+	: m_State(state), m_History(history), m_CapturesOnly(true) {
+	if (state.IsInCheck()) {
+		m_Stage = GenerateEvasionsStage;
+	} else {
+		m_Pinned = state.GetPinnedPieces();
+		m_Stage = GenerateCapturesStage;
+	}
+}
+
+BoardMove MovePicker::Next() {
+	switch (m_Stage) {
+	case HashMoveStage:
+		m_Stage = GenerateCapturesStage;
+		if (IsUsable(m_HashMove))
+			return m_HashMove;
+		[[fallthrough]];
+
+	case GenerateCapturesStage:
+		m_State.GenerateCaptures(m_Moves);
+		for (int i = 0; i < m_Moves.size; i++)
+			m_Scores[i] = Score(m_Moves.moves[i]);
+		m_CapturesEnd = m_Moves.size;
+		m_Stage = GoodCapturesStage;
+		[[fallthrough]];
+
+	case GoodCapturesStage:
+		while (m_Current < m_CapturesEnd) {
+			BoardMove move = m_Moves.moves[PickBest(m_CapturesEnd)];
+			m_Current++;
+			if (move == m_HashMove)
+				continue;
+
+			// SEE is only worth computing for the captures we get to
+			if (m_State.See(move) < 0) {
+				m_Moves.moves[m_BadCapturesEnd++] = move;
+				continue;
+			}
+			if (m_State.IsLegal(move, m_Pinned))
+				return move;
+		}
+		if (m_CapturesOnly) {
+			m_Stage = DoneStage;
+			return {};
+		}
+		m_Stage = FirstKillerStage;
+		[[fallthrough]];
+
+	case FirstKillerStage:
+		m_Stage = SecondKillerStage;
+		if (m_Killers[0] != m_HashMove && IsUsableQuiet(m_Killers[0]))
+			return m_Killers[0];
+		[[fallthrough]];
+
+	case SecondKillerStage:
+		m_Stage = CounterMoveStage;
+		if (m_Killers[1] != m_HashMove && m_Killers[1] != m_Killers[0] &&
+		    IsUsableQuiet(m_Killers[1]))
+			return m_Killers[1];
+		[[fallthrough]];
+
+	case CounterMoveStage:
+		m_Stage = GenerateQuietsStage;
+		if (m_CounterMove != m_HashMove && m_CounterMove != m_Killers[0] &&
+		    m_CounterMove != m_Killers[1] && IsUsableQuiet(m_CounterMove))
+			return m_CounterMove;
+		[[fallthrough]];
+
+	case GenerateQuietsStage:
+		m_Moves.size = m_CapturesEnd;
+		m_State.GenerateQuiets(m_Moves);
+		for (int i = m_Current; i < m_Moves.size; i++)
+			m_Scores[i] =
+				m_History.GetHistory(m_State.GetTurn(), m_Moves.moves[i]);
+		m_Stage = QuietsStage;
+		[[fallthrough]];
+
+	case QuietsStage:
+		while (m_Current < m_Moves.size) {
+			BoardMove move = m_Moves.moves[PickBest(m_Moves.size)];
+			m_Current++;
+			if (!WasHandedOut(move) && m_State.IsLegal(move, m_Pinned))
+				return move;
+		}
+		m_Current = 0;
+		m_Stage = BadCapturesStage;
+		[[fallthrough]];
+
+	case BadCapturesStage:
+		while (m_Current < m_BadCapturesEnd) {
+			BoardMove move = m_Moves.moves[m_Current++];
+			if (m_State.IsLegal(move, m_Pinned))
+				return move;
+		}
+		m_Stage = DoneStage;
+		return {};
+
+	case GenerateEvasionsStage:
+		m_State.GenerateLegalMoves(m_Moves);
+		for (int i = 0; i < m_Moves.size; i++) {
+			BoardMove move = m_Moves.moves[i];
+			m_Scores[i] = move == m_HashMove ? HashMoveScore : Score(move);
+		}
+		m_Stage = EvasionsStage;
+		[[fallthrough]];
+
+	case EvasionsStage:
+		if (m_Current < m_Moves.size) {
+			PickBest(m_Moves.size);
+			return m_Moves.moves[m_Current++];
+		}
+		m_Stage = DoneStage;
+		return {};
+
+	case DoneStage:
+		break;
+	}
+	return {};
+}
+
+int MovePicker::PickBest(int end) {
+	// selection sort, one step per call
+	int best = m_Current;
+	for (int i = m_Current + 1; i < end; i++)
+		if (m_Scores[i] > m_Scores[best])
+			best = i;
+
+	std::swap(m_Moves.moves[best], m_Moves.moves[m_Current]);
+	std::swap(m_Scores[best], m_Scores[m_Current]);
+	return m_Current;
+}
+
+bool MovePicker::IsUsable(BoardMove move) const {
+	return m_State.IsPseudoLegal(move) && m_State.IsLegal(move, m_Pinned);
+}
+
+bool MovePicker::IsUsableQuiet(BoardMove move) const {
+	// tactical moves are handed out with the captures
+	return !IsTactical(move) && IsUsable(move);
+}
+
+bool MovePicker::WasHandedOut(BoardMove move) const {
+	return move == m_HashMove || move == m_Killers[0] ||
+	       move == m_Killers[1] || move == m_CounterMove;
+}
+
+int MovePicker::Score(BoardMove move) const {
+	if (IsTactical(move)) {
+		PieceType victim = move.Flags() == BoardMove::EnPassant
+		                       ? PawnPiece
+		                       : m_State.GetPieceType(move.To());
+		int mvvLva = BoardState::SeeValues[victim] * 8 -
+		             m_State.GetPieceType(move.From());
+		if (move.IsPromotion())
+			mvvLva += BoardState::SeeValues[QueenPiece];
+
+		// in check the evasions are scored up front, elsewhere the SEE is
+		// left to the good captures stage
+		if (m_Stage == GenerateEvasionsStage && m_State.See(move) < 0)
+			return BadCaptureScore + mvvLva;
+		return GoodCaptureScore + mvvLva;
+	}
+
+	if (move == m_Killers[0])
+		return KillerScore;
+	if (move == m_Killers[1])
+		return KillerScore - 1;
+	if (move == m_CounterMove)
+		return CounterMoveScore;
+
+	return m_History.GetHistory(m_State.GetTurn(), move);
+}
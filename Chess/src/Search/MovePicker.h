@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Board/BoardState.h"
+
+// Move ordering statistics learned during a search. Every search thread
+// has its own.
+struct MoveHistory {
+	static constexpr int MaxPly = 128;
+	// history scores stay within +-MaxHistory
+	static constexpr int MaxHistory = 16384;
+
+	// quiet moves that caused a beta cutoff at the same ply
+	BoardMove killers[MaxPly][2];
+	// quiet reply that refuted a move, by the moving color and the piece
+	// and destination of the move it refutes
+	BoardMove counterMoves[2][6][64];
+	// butterfly table of how often a quiet move caused a cutoff, by color,
+	// from and to square
+	int16_t butterfly[2][64][64];
+
+	void Clear();
+
+	// a quiet move failed high: remember it and reward it, punishing the
+	// quiets tried before it
+	void UpdateQuiet(
+		const BoardState &state, BoardMove move, BoardMove previousMove,
+		int ply, int depth, const BoardMove *triedQuiets, int triedCount
+	);
+
+	inline int GetHistory(Color color, BoardMove move) const {
+		return butterfly[color][move.From()][move.To()];
+	}
+
+	inline BoardMove
+	GetCounterMove(const BoardState &state, BoardMove previousMove) const {
+		if (previousMove.IsNull())
+			return {};
+		int to = previousMove.To();
+		return counterMoves[!state.GetTurn()][state.GetPieceType(to)][to];
+	}
+
+private:
+	// moves the entry towards +-MaxHistory by bonus, slower the closer it
+	// already is
+	static void ApplyGravity(int16_t &entry, int bonus);
+};
+
+// Hands out the legal moves of a position best first, generating them in
+// stages so that a cutoff early on saves the work of the later ones:
+//  1. the hash move, before anything is generated
+//  2. captures and queen promotions that don't lose material (by SEE),
+//     most valuable victim first and least valuable attacker next
+//  3. the killer moves, then the counter move
+//  4. quiet moves by butterfly history
+//  5. captures that lose material
+// Moves are generated pseudo-legal and checked for legality only when they
+// are handed out. In check all evasions are generated legal at once and
+// picked by the same scores instead. The quiescence search only gets the
+// good captures.
+class MovePicker
+{
+public:
+	MovePicker(
+		const BoardState &state, BoardMove hashMove,
+		const MoveHistory &history, int ply, BoardMove previousMove
+	);
+
+	// for the quiescence search: only the captures and queen promotions
+	// that don't lose material, or every evasion when in check
+	MovePicker(const BoardState &state, const MoveHistory &history);
+
+	// the next best move, a null move once every move was handed out
+	BoardMove Next();
+
+private:
+	enum Stage {
+		HashMoveStage,
+		GenerateCapturesStage,
+		GoodCapturesStage,
+		FirstKillerStage,
+		SecondKillerStage,
+		CounterMoveStage,
+		GenerateQuietsStage,
+		QuietsStage,
+		BadCapturesStage,
+		GenerateEvasionsStage,
+		EvasionsStage,
+		DoneStage
+	};
+
+	int Score(BoardMove move) const;
+
+	// index of the best scored move in [m_Current, end)
+	int PickBest(int end);
+
+	// a move from outside the generated lists that may be played here
+	bool IsUsable(BoardMove move) const;
+
+	// same for the killers and counter move, which must be quiet
+	bool IsUsableQuiet(BoardMove move) const;
+
+	// the stage's generated moves contain a move already handed out
+	bool WasHandedOut(BoardMove move) const;
+
+private:
+	const BoardState &m_State;
+	const MoveHistory &m_History;
+	BoardMove m_HashMove;
+	BoardMove m_Killers[2];
+	BoardMove m_CounterMove;
+	BitBoard m_Pinned = 0;
+	bool m_CapturesOnly = false;
+
+	Stage m_Stage;
+	MoveList m_Moves;
+	int m_Scores[256];
+	int m_Current = 0;
+	// captures end here, losing ones are moved to the front of the list
+	int m_CapturesEnd = 0;
+	int m_BadCapturesEnd = 0;
+};
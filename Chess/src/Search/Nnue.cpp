@@ -0,0 +1,404 @@
+#include "Nnue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+using namespace BitBoards;
+
+struct Nnue::Kernels {
+	decltype(&NnueKernels::UpdateAccumulatorScalar) updateAccumulator;
+	decltype(&NnueKernels::TransformScalar) transform;
+	decltype(&NnueKernels::AffineScalar) affine;
+};
+
+namespace
+{
+	// HalfKP index of a piece seen from perspective, black sees the board
+	// flipped so that both perspectives share the weights
+	inline int FeatureIndex(
+		Color perspective, int kingSq, Color color, PieceType type, int sq
+	) {
+		if (perspective == Black) {
+			kingSq ^= 56;
+			sq ^= 56;
+		}
+		int piece = type * 2 + (color != perspective);
+		return (kingSq * 10 + piece) * 64 + sq;
+	}
+
+	// affine layer output to the next layer's 0..127 input
+	inline void ClipAndShift(const int32_t *in, uint8_t *out, int size) {
+		for (int i = 0; i < size; i++)
+			out[i] = (uint8_t) std::clamp(
+				in[i] >> NnueKernels::WeightScaleBits, 0, 127
+			);
+	}
+
+	// the files are little endian, as is every cpu this runs on
+	template <typename T>
+	bool Read(std::ifstream &file, T *data, size_t count) {
+		file.read((char *) data, (std::streamsize) (count * sizeof(T)));
+		return (bool) file;
+	}
+
+	template <typename T>
+	void Write(std::ofstream &file, const T *data, size_t count) {
+		file.write((const char *) data, (std::streamsize) (count * sizeof(T)));
+	}
+} // namespace
+
+//////////////////////////////// Scalar kernels ////////////////////////////////
+
+void NnueKernels::UpdateAccumulatorScalar(
+	int16_t *out, const int16_t *in, const int16_t *const *added,
+	int addedCount, const int16_t *const *removed, int removedCount
+) {
+	for (int i = 0; i < HalfDimensions; i++) {
+		int16_t value = in[i];
+		for (int row = 0; row < addedCount; row++) value += added[row][i];
+		for (int row = 0; row < removedCount; row++) value -= removed[row][i];
+		out[i] = value;
+	}
+}
+
+void NnueKernels::TransformScalar(
+	const int16_t *us, const int16_t *them, uint8_t *out
+) {
+	for (int i = 0; i < HalfDimensions; i++) {
+		out[i] = (uint8_t) std::clamp<int16_t>(us[i], 0, 127);
+		out[HalfDimensions + i] = (uint8_t) std::clamp<int16_t>(them[i], 0, 127);
+	}
+}
+
+void NnueKernels::AffineScalar(
+	const uint8_t *in, int inDims, const int8_t *weights,
+	const int32_t *biases, int outDims, int32_t *out
+) {
+	for (int o = 0; o < outDims; o++) {
+		const int8_t *row = weights + o * inDims;
+		int32_t sum = biases[o];
+		for (int i = 0; i < inDims; i++) sum += in[i] * row[i];
+		out[o] = sum;
+	}
+}
+
+///////////////////////////////////// Nnue /////////////////////////////////////
+
+Nnue::Nnue() {
+	if (!SetInstructionSet(Avx2) && !SetInstructionSet(Sse41))
+		SetInstructionSet(Scalar);
+}
+
+bool Nnue::Load(const std::string &path, const char **error) {
+	auto fail = [error](const char *reason) {
+		if (error)
+			*error = reason;
+		return false;
+	};
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return fail("can't open");
+
+	uint32_t header[6];
+	if (!Read(file, header, 6))
+		return fail("truncated header");
+	if (header[0] != FileMagic)
+		return fail("not a network");
+	if (header[1] != FileVersion)
+		return fail("unsupported version");
+	if (header[2] != FeatureCount || header[3] != HalfDimensions ||
+	    header[4] != Hidden1 || header[5] != Hidden2)
+		return fail("different architecture");
+
+	// read into a copy so a bad file leaves the current weights alone
+	Nnue network;
+	network.m_FeatureWeights.resize((size_t) FeatureCount * HalfDimensions);
+	if (!Read(file, network.m_FeatureBiases.data(), HalfDimensions) ||
+	    !Read(
+			file, network.m_FeatureWeights.data(),
+			network.m_FeatureWeights.size()
+		) ||
+	    !Read(file, network.m_Hidden1Biases.data(), Hidden1) ||
+	    !Read(
+			file, network.m_Hidden1Weights.data(),
+			network.m_Hidden1Weights.size()
+		) ||
+	    !Read(file, network.m_Hidden2Biases.data(), Hidden2) ||
+	    !Read(
+			file, network.m_Hidden2Weights.data(),
+			network.m_Hidden2Weights.size()
+		) ||
+	    !Read(file, &network.m_OutputBias, 1) ||
+	    !Read(file, network.m_OutputWeights.data(), Hidden2))
+		return fail("truncated weights");
+	if (file.peek() != std::ifstream::traits_type::eof())
+		return fail("trailing data");
+
+	InstructionSet set = m_InstructionSet;
+	*this = std::move(network);
+	SetInstructionSet(set);
+	return true;
+}
+
+bool Nnue::Save(const std::string &path) const {
+	std::ofstream file(path, std::ios::binary);
+	if (!file || !IsLoaded()) {
+		std::cout << "Couldn't save network: " << path << std::endl;
+		return false;
+	}
+
+	uint32_t header[6] = {FileMagic, FileVersion, FeatureCount,
+	                      HalfDimensions, Hidden1, Hidden2};
+	Write(file, header, 6);
+	Write(file, m_FeatureBiases.data(), HalfDimensions);
+	Write(file, m_FeatureWeights.data(), m_FeatureWeights.size());
+	Write(file, m_Hidden1Biases.data(), Hidden1);
+	Write(file, m_Hidden1Weights.data(), m_Hidden1Weights.size());
+	Write(file, m_Hidden2Biases.data(), Hidden2);
+	Write(file, m_Hidden2Weights.data(), m_Hidden2Weights.size());
+	Write(file, &m_OutputBias, 1);
+	Write(file, m_OutputWeights.data(), Hidden2);
+	return (bool) file;
+}
+
+void Nnue::Randomize(uint64_t seed) {
+	std::mt19937_64 rng(seed);
+	auto fill = [&rng](auto &values, int min, int max) {
+		std::uniform_int_distribution<int> dist(min, max);
+		for (auto &value : values) value = dist(rng);
+	};
+
+	// small enough that most accumulator values stay inside the clipped
+	// range
+	m_FeatureWeights.resize((size_t) FeatureCount * HalfDimensions);
+	fill(m_FeatureBiases, 0, 64);
+	fill(m_FeatureWeights, -8, 8);
+	fill(m_Hidden1Biases, -4096, 4096);
+	fill(m_Hidden1Weights, -16, 16);
+	fill(m_Hidden2Biases, -1024, 1024);
+	fill(m_Hidden2Weights, -32, 32);
+	m_OutputBias = 0;
+	fill(m_OutputWeights, -64, 64);
+}
+
+bool Nnue::SetInstructionSet(InstructionSet set) {
+	static const Kernels scalar {
+		NnueKernels::UpdateAccumulatorScalar, NnueKernels::TransformScalar,
+		NnueKernels::AffineScalar};
+	static const Kernels sse41 {
+		NnueKernels::UpdateAccumulatorSse41, NnueKernels::TransformSse41,
+		NnueKernels::AffineSse41};
+	static const Kernels avx2 {
+		NnueKernels::UpdateAccumulatorAvx2, NnueKernels::TransformAvx2,
+		NnueKernels::AffineAvx2};
+
+	if ((set == Avx2 && !CpuSupportsAvx2()) ||
+	    (set == Sse41 && !CpuSupportsSse41()))
+		return false;
+
+	m_InstructionSet = set;
+	m_Kernels = set == Avx2 ? &avx2 : set == Sse41 ? &sse41 : &scalar;
+	return true;
+}
+
+////////////////////////////////// Accumulators ////////////////////////////////
+
+void Nnue::Refresh(const BoardState &state, NnueAccumulator &accumulator)
+	const {
+	RefreshPerspective(state, accumulator, Black);
+	RefreshPerspective(state, accumulator, White);
+}
+
+void Nnue::RefreshPerspective(
+	const BoardState &state, NnueAccumulator &accumulator, Color perspective
+) const {
+	int kingSq = state.GetKingSquare(perspective);
+	const int16_t *rows[32];
+	int count = 0;
+
+	for (int color = Black; color <= White; color++) {
+		for (int type = PawnPiece; type < KingPiece; type++) {
+			BitBoard pieces = state.GetPieces((Color) color, (PieceType) type);
+			while (pieces)
+				rows[count++] = FeatureRow(FeatureIndex(
+					perspective, kingSq, (Color) color, (PieceType) type,
+					PopLowest(pieces)
+				));
+		}
+	}
+
+	m_Kernels->updateAccumulator(
+		accumulator.values[perspective], m_FeatureBiases.data(), rows, count,
+		nullptr, 0
+	);
+}
+
+NnueChange Nnue::GetChange(const BoardState &before, BoardMove move) {
+	NnueChange change;
+	Color us = before.GetTurn(), them = (Color) !us;
+	int from = move.From(), to = move.To(), flags = move.Flags();
+	PieceType moved = before.GetPieceType(from);
+
+	if (flags == BoardMove::EnPassant)
+		change.removed[change.removedCount++] = {
+			them, PawnPiece, to + (us ? South : North)};
+	else if (move.IsCapture())
+		change.removed[change.removedCount++] = {
+			them, before.GetPieceType(to), to};
+
+	if (moved == KingPiece) {
+		change.kingMoved[us] = true;
+		// the rook is the only piece castling moves for the other side
+		if (flags == BoardMove::KingCastle) {
+			change.removed[change.removedCount++] = {us, RookPiece, to + 1};
+			change.added[change.addedCount++] = {us, RookPiece, to - 1};
+		} else if (flags == BoardMove::QueenCastle) {
+			change.removed[change.removedCount++] = {us, RookPiece, to - 2};
+			change.added[change.addedCount++] = {us, RookPiece, to + 1};
+		}
+	} else {
+		change.removed[change.removedCount++] = {us, moved, from};
+		change.added[change.addedCount++] = {
+			us, move.IsPromotion() ? move.GetPromotionType() : moved, to};
+	}
+
+	return change;
+}
+
+void Nnue::Update(
+	const NnueAccumulator &before, NnueAccumulator &accumulator,
+	const NnueChange &change, const BoardState &after
+) const {
+	for (int perspective = Black; perspective <= White; perspective++) {
+		// every feature of a perspective depends on its king square
+		if (change.kingMoved[perspective]) {
+			RefreshPerspective(after, accumulator, (Color) perspective);
+			continue;
+		}
+
+		int kingSq = after.GetKingSquare((Color) perspective);
+		const int16_t *added[2], *removed[2];
+		for (int i = 0; i < change.addedCount; i++) {
+			const NnueChange::Piece &piece = change.added[i];
+			added[i] = FeatureRow(FeatureIndex(
+				(Color) perspective, kingSq, piece.color, piece.type, piece.sq
+			));
+		}
+		for (int i = 0; i < change.removedCount; i++) {
+			const NnueChange::Piece &piece = change.removed[i];
+			removed[i] = FeatureRow(FeatureIndex(
+				(Color) perspective, kingSq, piece.color, piece.type, piece.sq
+			));
+		}
+
+		m_Kernels->updateAccumulator(
+			accumulator.values[perspective], before.values[perspective], added,
+			change.addedCount, removed, change.removedCount
+		);
+	}
+}
+
+/////////////////////////////////// Evaluation /////////////////////////////////
+
+int Nnue::Evaluate(
+	const BoardState &state, const NnueAccumulator &accumulator
+) const {
+	Color us = state.GetTurn();
+
+	alignas(64) uint8_t transformed[2 * HalfDimensions];
+	m_Kernels->transform(
+		accumulator.values[us], accumulator.values[!us], transformed
+	);
+
+	alignas(64) int32_t hidden1[Hidden1];
+	alignas(64) uint8_t hidden1Clipped[Hidden1];
+	m_Kernels->affine(
+		transformed, 2 * HalfDimensions, m_Hidden1Weights.data(),
+		m_Hidden1Biases.data(), Hidden1, hidden1
+	);
+	ClipAndShift(hidden1, hidden1Clipped, Hidden1);
+
+	alignas(64) int32_t hidden2[Hidden2];
+	alignas(64) uint8_t hidden2Clipped[Hidden2];
+	m_Kernels->affine(
+		hidden1Clipped, Hidden1, m_Hidden2Weights.data(),
+		m_Hidden2Biases.data(), Hidden2, hidden2
+	);
+	ClipAndShift(hidden2, hidden2Clipped, Hidden2);
+
+	int32_t output = m_OutputBias;
+	for (int i = 0; i < Hidden2; i++)
+		output += hidden2Clipped[i] * m_OutputWeights[i];
+	return output / OutputScale;
+}
+
+void Nnue::Bench(const std::vector<std::string> &fens, int iterations) {
+	using namespace std::chrono;
+	static const char *names[] = {"scalar", "sse4.1", "avx2"};
+
+	std::vector<BoardState> states;
+	for (const std::string &fen : fens) {
+		BoardState state;
+		if (state.ReadFen(fen))
+			states.push_back(state);
+	}
+
+	InstructionSet current = m_InstructionSet;
+	NnueAccumulator accumulators[2];
+	// keeps the evaluations from being optimized away
+	volatile int sink = 0;
+
+	std::cout << states.size() << " positions, " << iterations
+			  << " iterations\n";
+	for (int set = Scalar; set <= Avx2; set++) {
+		if (!SetInstructionSet((InstructionSet) set))
+			continue;
+
+		uint64_t evals = 0;
+		auto start = steady_clock::now();
+		for (int i = 0; i < iterations; i++) {
+			for (const BoardState &state : states) {
+				Refresh(state, accumulators[0]);
+				sink = sink + Evaluate(state, accumulators[0]);
+				evals++;
+			}
+		}
+		double refreshSeconds =
+			duration<double>(steady_clock::now() - start).count();
+		uint64_t refreshEvals = evals;
+
+		// every move of every position, make and unmake included
+		evals = 0;
+		start = steady_clock::now();
+		for (int i = 0; i < iterations; i++) {
+			for (BoardState &state : states) {
+				MoveList moves;
+				state.GenerateLegalMoves(moves);
+				Refresh(state, accumulators[0]);
+				for (BoardMove move : moves) {
+					NnueChange change = GetChange(state, move);
+					state.MakeMove(move);
+					Update(accumulators[0], accumulators[1], change, state);
+					sink = sink + Evaluate(state, accumulators[1]);
+					state.UndoMove(move);
+					evals++;
+				}
+			}
+		}
+		double updateSeconds =
+			duration<double>(steady_clock::now() - start).count();
+
+		std::cout << names[set] << ": "
+				  << (uint64_t) (refreshEvals / std::max(refreshSeconds, 1e-9))
+				  << " evals/s from scratch, "
+				  << (uint64_t) (evals / std::max(updateSeconds, 1e-9))
+				  << " evals/s incremental\n";
+	}
+	std::cout << std::flush;
+
+	SetInstructionSet(current);
+}
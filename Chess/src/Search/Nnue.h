@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Board/BoardState.h"
+#include "NnueKernels.h"
+
+// accumulated first layer of Nnue for one position, by perspective color
+struct alignas(64) NnueAccumulator {
+	int16_t values[2][NnueKernels::HalfDimensions];
+};
+
+// the non-king pieces a move takes off and puts on the board, worked out
+// from the position before the move
+struct NnueChange {
+	struct Piece {
+		Color color;
+		PieceType type;
+		int sq;
+	};
+
+	Piece removed[2];
+	Piece added[2];
+	int removedCount = 0;
+	int addedCount = 0;
+	// the king of that color moved, its perspective has to be refreshed
+	bool kingMoved[2] {};
+};
+
+// Efficiently updatable neural network evaluation, HalfKP style:
+//  - 2 x 40960 features: for each perspective, every non-king piece on
+//    every square paired with that perspective's king square
+//  - a 256 wide int16 feature transformer per perspective, kept up to date
+//    incrementally in an NnueAccumulator as pieces move
+//  - 512 -> 32 -> 32 -> 1 int8 layers with clipped ReLUs
+// The hot loops run on AVX2 or SSE4.1 when the cpu supports them, and
+// plain C++ otherwise.
+class Nnue
+{
+public:
+	static constexpr int FeatureCount = NnueKernels::FeatureCount;
+	static constexpr int HalfDimensions = NnueKernels::HalfDimensions;
+	static constexpr int Hidden1 = NnueKernels::Hidden1;
+	static constexpr int Hidden2 = NnueKernels::Hidden2;
+
+	// "NNUE" in a little endian file
+	static constexpr uint32_t FileMagic = 0x45554E4E;
+	// bump whenever the architecture or the file layout changes
+	static constexpr uint32_t FileVersion = 1;
+	// network output units per centipawn
+	static constexpr int OutputScale = 16;
+
+	enum InstructionSet { Scalar, Sse41, Avx2 };
+
+public:
+	// no weights until Load or Randomize
+	Nnue();
+
+	// Reads a network file: magic, version and the four layer sizes as
+	// uint32s, then every layer's biases and weights, all little endian.
+	// Returns false (keeping the old weights) if the file can't be used,
+	// with error (if given) set to the reason.
+	bool Load(const std::string &path, const char **error = nullptr);
+
+	bool Save(const std::string &path) const;
+
+	// random weights, enough to benchmark and test without a trained
+	// network
+	void Randomize(uint64_t seed);
+
+	inline bool IsLoaded() const { return !m_FeatureWeights.empty(); }
+
+	// the best the cpu supports unless set lower, returns false for ones
+	// it doesn't support
+	bool SetInstructionSet(InstructionSet set);
+
+	inline InstructionSet GetInstructionSet() const { return m_InstructionSet; }
+
+public: // accumulators
+	// from scratch for both perspectives
+	void Refresh(const BoardState &state, NnueAccumulator &accumulator) const;
+
+	static NnueChange GetChange(const BoardState &before, BoardMove move);
+
+	// the accumulator after a move from the one before it, after is the
+	// position once the move was made
+	void Update(
+		const NnueAccumulator &before, NnueAccumulator &accumulator,
+		const NnueChange &change, const BoardState &after
+	) const;
+
+public: // evaluation
+	// centipawns from the point of view of the side to move
+	int Evaluate(const BoardState &state, const NnueAccumulator &accumulator)
+		const;
+
+	// evaluations per second from scratch and with incremental updates over
+	// the moves of every position, for every instruction set the cpu has
+	void Bench(const std::vector<std::string> &fens, int iterations);
+
+private:
+	void RefreshPerspective(
+		const BoardState &state, NnueAccumulator &accumulator,
+		Color perspective
+	) const;
+
+	inline const int16_t *FeatureRow(int feature) const {
+		return &m_FeatureWeights[(size_t) feature * HalfDimensions];
+	}
+
+private:
+	struct Kernels;
+	const Kernels *m_Kernels;
+	InstructionSet m_InstructionSet;
+
+	alignas(64) std::array<int16_t, HalfDimensions> m_FeatureBiases {};
+	// FeatureCount rows of HalfDimensions
+	std::vector<int16_t> m_FeatureWeights;
+
+	alignas(64) std::array<int32_t, Hidden1> m_Hidden1Biases {};
+	alignas(64) std::array<int8_t, Hidden1 * 2 * HalfDimensions>
+		m_Hidden1Weights {};
+	alignas(64) std::array<int32_t, Hidden2> m_Hidden2Biases {};
+	alignas(64) std::array<int8_t, Hidden2 * Hidden1> m_Hidden2Weights {};
+	int32_t m_OutputBias = 0;
+	alignas(64) std::array<int8_t, Hidden2> m_OutputWeights {};
+};
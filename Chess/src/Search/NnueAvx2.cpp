@@ -0,0 +1,81 @@
+// This file is compiled with AVX2 enabled (see CMakeLists.txt), it is only
+// ever called after BitBoards::CpuSupportsAvx2() said so.
+
+#include "NnueKernels.h"
+
+#include <immintrin.h>
+
+void NnueKernels::UpdateAccumulatorAvx2(
+	int16_t *out, const int16_t *in, const int16_t *const *added,
+	int addedCount, const int16_t *const *removed, int removedCount
+) {
+	// the accumulator stays in registers while the rows are added
+	constexpr int Registers = HalfDimensions / 16;
+	__m256i acc[Registers];
+
+	for (int i = 0; i < Registers; i++)
+		acc[i] = _mm256_loadu_si256((const __m256i *) in + i);
+	for (int row = 0; row < addedCount; row++)
+		for (int i = 0; i < Registers; i++)
+			acc[i] = _mm256_add_epi16(
+				acc[i], _mm256_loadu_si256((const __m256i *) added[row] + i)
+			);
+	for (int row = 0; row < removedCount; row++)
+		for (int i = 0; i < Registers; i++)
+			acc[i] = _mm256_sub_epi16(
+				acc[i], _mm256_loadu_si256((const __m256i *) removed[row] + i)
+			);
+	for (int i = 0; i < Registers; i++)
+		_mm256_storeu_si256((__m256i *) out + i, acc[i]);
+}
+
+void NnueKernels::TransformAvx2(
+	const int16_t *us, const int16_t *them, uint8_t *out
+) {
+	const __m256i zero = _mm256_setzero_si256();
+	const int16_t *halves[2] = {us, them};
+
+	for (int half = 0; half < 2; half++) {
+		for (int i = 0; i < HalfDimensions; i += 32) {
+			__m256i a = _mm256_loadu_si256((const __m256i *) (halves[half] + i));
+			__m256i b =
+				_mm256_loadu_si256((const __m256i *) (halves[half] + i + 16));
+			// packing works per 128 bit lane, the permute puts the
+			// quarters back in order
+			__m256i packed = _mm256_permute4x64_epi64(
+				_mm256_packs_epi16(a, b), 0b11011000
+			);
+			_mm256_storeu_si256(
+				(__m256i *) (out + half * HalfDimensions + i),
+				_mm256_max_epi8(packed, zero)
+			);
+		}
+	}
+}
+
+void NnueKernels::AffineAvx2(
+	const uint8_t *in, int inDims, const int8_t *weights,
+	const int32_t *biases, int outDims, int32_t *out
+) {
+	const __m256i ones = _mm256_set1_epi16(1);
+
+	for (int o = 0; o < outDims; o++) {
+		const int8_t *row = weights + o * inDims;
+		__m256i sum = _mm256_setzero_si256();
+		for (int i = 0; i < inDims; i += 32) {
+			// u8 * i8 pairs summed to i16, then pairs of those to i32
+			__m256i products = _mm256_maddubs_epi16(
+				_mm256_loadu_si256((const __m256i *) (in + i)),
+				_mm256_loadu_si256((const __m256i *) (row + i))
+			);
+			sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+		}
+
+		__m128i half = _mm_add_epi32(
+			_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1)
+		);
+		half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+		half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+		out[o] = biases[o] + _mm_cvtsi128_si32(half);
+	}
+}
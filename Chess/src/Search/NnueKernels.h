@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+
+// The hot loops of Nnue, once per instruction set. The SSE4.1 and AVX2
+// versions live in their own translation units compiled for that
+// instruction set, Nnue picks one at runtime.
+//
+// Only constexpr values and declarations may be used in here, any inline
+// function an SSE4.1 or AVX2 translation unit emitted could be picked by the
+// linker for the whole program.
+
+namespace NnueKernels
+{
+	// king square * 10 kinds of non-king piece * piece square
+	constexpr int FeatureCount = 64 * 10 * 64;
+	// accumulator size of one perspective
+	constexpr int HalfDimensions = 256;
+	constexpr int Hidden1 = 32;
+	constexpr int Hidden2 = 32;
+	// the affine layers' outputs are shifted right by this much
+	constexpr int WeightScaleBits = 6;
+
+	// out = in + every added row - every removed row, HalfDimensions wide.
+	// out and in may be the same.
+	void UpdateAccumulatorScalar(
+		int16_t *out, const int16_t *in, const int16_t *const *added,
+		int addedCount, const int16_t *const *removed, int removedCount
+	);
+
+	// both accumulator halves clipped to 0..127, the side to move's first
+	void TransformScalar(const int16_t *us, const int16_t *them, uint8_t *out);
+
+	// out[o] = biases[o] + dot(in, row o of weights), inDims a multiple of
+	// 32
+	void AffineScalar(
+		const uint8_t *in, int inDims, const int8_t *weights,
+		const int32_t *biases, int outDims, int32_t *out
+	);
+
+	// NnueSse41.cpp, only call when CpuSupportsSse41()
+	void UpdateAccumulatorSse41(
+		int16_t *out, const int16_t *in, const int16_t *const *added,
+		int addedCount, const int16_t *const *removed, int removedCount
+	);
+
+	void TransformSse41(const int16_t *us, const int16_t *them, uint8_t *out);
+
+	void AffineSse41(
+		const uint8_t *in, int inDims, const int8_t *weights,
+		const int32_t *biases, int outDims, int32_t *out
+	);
+
+	// NnueAvx2.cpp, only call when CpuSupportsAvx2()
+	void UpdateAccumulatorAvx2(
+		int16_t *out, const int16_t *in, const int16_t *const *added,
+		int addedCount, const int16_t *const *removed, int removedCount
+	);
+
+	void TransformAvx2(const int16_t *us, const int16_t *them, uint8_t *out);
+
+	void AffineAvx2(
+		const uint8_t *in, int inDims, const int8_t *weights,
+		const int32_t *biases, int outDims, int32_t *out
+	);
+} // namespace NnueKernels
@@ -0,0 +1,79 @@
+// This file is compiled with SSE4.1 enabled (see CMakeLists.txt), it is
+// only ever called after BitBoards::CpuSupportsSse41() said so.
+
+#include "NnueKernels.h"
+
+#include <smmintrin.h>
+
+void NnueKernels::UpdateAccumulatorSse41(
+	int16_t *out, const int16_t *in, const int16_t *const *added,
+	int addedCount, const int16_t *const *removed, int removedCount
+) {
+	// half the accumulator at a time, so that it stays in registers
+	constexpr int Registers = HalfDimensions / 8 / 2;
+
+	for (int part = 0; part < 2; part++) {
+		int offset = part * Registers;
+		__m128i acc[Registers];
+
+		for (int i = 0; i < Registers; i++)
+			acc[i] = _mm_loadu_si128((const __m128i *) in + offset + i);
+		for (int row = 0; row < addedCount; row++)
+			for (int i = 0; i < Registers; i++)
+				acc[i] = _mm_add_epi16(
+					acc[i],
+					_mm_loadu_si128((const __m128i *) added[row] + offset + i)
+				);
+		for (int row = 0; row < removedCount; row++)
+			for (int i = 0; i < Registers; i++)
+				acc[i] = _mm_sub_epi16(
+					acc[i],
+					_mm_loadu_si128((const __m128i *) removed[row] + offset + i)
+				);
+		for (int i = 0; i < Registers; i++)
+			_mm_storeu_si128((__m128i *) out + offset + i, acc[i]);
+	}
+}
+
+void NnueKernels::TransformSse41(
+	const int16_t *us, const int16_t *them, uint8_t *out
+) {
+	const __m128i zero = _mm_setzero_si128();
+	const int16_t *halves[2] = {us, them};
+
+	for (int half = 0; half < 2; half++) {
+		for (int i = 0; i < HalfDimensions; i += 16) {
+			__m128i a = _mm_loadu_si128((const __m128i *) (halves[half] + i));
+			__m128i b =
+				_mm_loadu_si128((const __m128i *) (halves[half] + i + 8));
+			_mm_storeu_si128(
+				(__m128i *) (out + half * HalfDimensions + i),
+				_mm_max_epi8(_mm_packs_epi16(a, b), zero)
+			);
+		}
+	}
+}
+
+void NnueKernels::AffineSse41(
+	const uint8_t *in, int inDims, const int8_t *weights,
+	const int32_t *biases, int outDims, int32_t *out
+) {
+	const __m128i ones = _mm_set1_epi16(1);
+
+	for (int o = 0; o < outDims; o++) {
+		const int8_t *row = weights + o * inDims;
+		__m128i sum = _mm_setzero_si128();
+		for (int i = 0; i < inDims; i += 16) {
+			// u8 * i8 pairs summed to i16, then pairs of those to i32
+			__m128i products = _mm_maddubs_epi16(
+				_mm_loadu_si128((const __m128i *) (in + i)),
+				_mm_loadu_si128((const __m128i *) (row + i))
+			);
+			sum = _mm_add_epi32(sum, _mm_madd_epi16(products, ones));
+		}
+
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+		out[o] = biases[o] + _mm_cvtsi128_si32(sum);
+	}
+}
@@ -0,0 +1,41 @@
+#include "PawnTable.h"
+#include "Evaluation.h"
+
+#include <algorithm>
+#include <bit>
+
+PawnTable::PawnTable(size_t entries) { Resize(entries); }
+
+void PawnTable::Resize(size_t entries) {
+	entries = std::bit_floor(std::max<size_t>(entries, 1));
+	m_Entries.assign(entries, {});
+	m_Mask = entries - 1;
+	Clear();
+}
+
+void PawnTable::Clear() {
+	// an entry for no pawns at all (key 0) is right for every slot, so
+	// there is no need to tell empty slots apart
+	PawnEntry empty {};
+	const BitBoard noPawns[2] = {0, 0};
+	Evaluation::EvaluatePawns(noPawns, empty);
+	for (PawnEntry &entry : m_Entries) entry = empty;
+	ResetStats();
+}
+
+const PawnEntry &PawnTable::Probe(const BoardState &state) {
+	uint64_t key = state.GetPawnKey();
+	PawnEntry &entry = m_Entries[key & m_Mask];
+
+	m_Probes++;
+	if (entry.pawnKey == key) {
+		m_Hits++;
+		return entry;
+	}
+
+	const BitBoard pawns[2] = {
+		state.GetPieces(Black, PawnPiece), state.GetPieces(White, PawnPiece)};
+	Evaluation::EvaluatePawns(pawns, entry);
+	entry.pawnKey = key;
+	return entry;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Board/BoardState.h"
+
+// evaluation terms that only depend on where the pawns are
+struct alignas(64) PawnEntry {
+	uint64_t pawnKey;
+	// passed, isolated, doubled and backward pawns, white minus black
+	TaperedScore score;
+	BitBoard passed[2];
+	// middlegame pawn shield of each color for its king on each file,
+	// counted while the king is on its first two ranks
+	int16_t shelter[2][8];
+};
+
+// Cache of PawnEntry by BoardState::GetPawnKey(). Pawn structures repeat
+// all over a search tree, so nearly every lookup is a hit. Not thread safe,
+// every search thread has its own.
+class PawnTable
+{
+public:
+	explicit PawnTable(size_t entries = 16384);
+
+	// entries is rounded down to a power of two, drops every entry
+	void Resize(size_t entries);
+
+	void Clear();
+
+	// the entry for the pawns of state, computed on a miss
+	const PawnEntry &Probe(const BoardState &state);
+
+	inline void ResetStats() { m_Probes = m_Hits = 0; }
+
+	// share of probes since ResetStats that were hits
+	inline double GetHitRate() const {
+		return m_Probes ? (double) m_Hits / m_Probes : 0;
+	}
+
+private:
+	std::vector<PawnEntry> m_Entries;
+	uint64_t m_Mask = 0;
+	uint64_t m_Probes = 0;
+	uint64_t m_Hits = 0;
+};
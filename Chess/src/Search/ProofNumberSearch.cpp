@@ -0,0 +1,336 @@
+#include "ProofNumberSearch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "Search.h"
+
+namespace
+{
+	// how far past the second best child the best one may go before the
+	// search comes back up, as a fraction of the second best's delta
+	// (the 1 + epsilon trick, fewer trips up and down the tree)
+	constexpr uint32_t EpsilonDivisor = 4;
+
+	// the alpha-beta search in BenchMates gives up after this long
+	constexpr int64_t BenchMateTimeMs = 30000;
+
+	inline uint32_t Saturate(uint64_t value) {
+		return (uint32_t) std::min<uint64_t>(
+			value, ProofNumberSearch::Infinity
+		);
+	}
+} // namespace
+
+std::string ProofResult::ToString() const {
+	std::string str = status == Proven ? "mate in " + std::to_string(mateIn)
+	                  : status == Disproven ? "no mate"
+	                                        : "unknown";
+	str += " nodes " + std::to_string(nodes) + " time " +
+		   std::to_string(timeMs);
+	if (!line.empty()) {
+		str += " pv";
+		for (BoardMove move : line) str += " " + move.ToString();
+	}
+	return str;
+}
+
+ProofNumberSearch::ProofNumberSearch(size_t megabytes) { Resize(megabytes); }
+
+void ProofNumberSearch::Resize(size_t megabytes) {
+	// a power of two number of entries, in buckets of two
+	size_t entries = 2;
+	while (entries * 2 * sizeof(Entry) <= megabytes * 1024 * 1024)
+		entries *= 2;
+	m_Table.assign(entries, {});
+}
+
+void ProofNumberSearch::Clear() {
+	std::fill(m_Table.begin(), m_Table.end(), Entry{});
+}
+
+ProofResult ProofNumberSearch::Solve(
+	BoardState &state, const ProofLimits &limits,
+	const ProgressCallback &onProgress
+) {
+	m_StartTime = std::chrono::steady_clock::now();
+	m_State = &state;
+	m_Limits = limits;
+	m_OnProgress = onProgress;
+	m_NextProgress = ProgressInterval;
+	m_MaxPlies = limits.mateMoves > 0
+	                 ? std::min(limits.mateMoves * 2 - 1, MaxPly - 1)
+	                 : 0;
+	m_Stop = false;
+	m_Nodes = 0;
+
+	ProofResult result;
+	if (state.CountLegalMoves() == 0)
+		result.status = ProofResult::Disproven;
+	else {
+		Numbers root = Expand(0, Infinity, Infinity);
+		if (root.phi == 0) {
+			result.status = ProofResult::Proven;
+			result.mateIn = (root.distance + 1) / 2;
+			result.line = ExtractLine();
+		} else if (root.delta == 0)
+			result.status = ProofResult::Disproven;
+	}
+
+	result.nodes = m_Nodes;
+	result.timeMs = ElapsedMilliseconds();
+	m_OnProgress = nullptr;
+	return result;
+}
+
+ProofNumberSearch::Numbers ProofNumberSearch::Expand(
+	int ply, uint32_t thresholdPhi, uint32_t thresholdDelta
+) {
+	uint64_t startNodes = m_Nodes;
+	m_PathKeys[ply] = m_State->GetKey();
+
+	MoveList moves;
+	m_State->GenerateLegalMoves(moves);
+	uint64_t keys[256];
+	for (int i = 0; i < moves.size; i++) {
+		m_State->MakeMove(moves.moves[i]);
+		keys[i] = m_State->GetKey();
+		m_State->UndoMove(moves.moves[i]);
+	}
+
+	Numbers node;
+	while (true) {
+		// phi is the smallest delta of the children (one reply that wins
+		// is enough), delta the sum of their phis (every reply has to lose)
+		uint64_t deltaSum = 0;
+		uint32_t secondDelta = Infinity;
+		uint16_t shortestWin = UINT16_MAX, longestLoss = 0;
+		int best = 0;
+		Numbers bestChild;
+		node.phi = Infinity;
+		for (int i = 0; i < moves.size; i++) {
+			Numbers child = Child(ply, moves.moves[i], keys[i]);
+			deltaSum += child.phi;
+			if (child.delta < node.phi) {
+				secondDelta = node.phi;
+				node.phi = child.delta;
+				best = i;
+				bestChild = child;
+			} else if (child.delta < secondDelta)
+				secondDelta = child.delta;
+
+			if (child.delta == 0)
+				shortestWin =
+					std::min<uint16_t>(shortestWin, child.distance + 1);
+			longestLoss = std::max<uint16_t>(longestLoss, child.distance + 1);
+		}
+		node.delta = Saturate(deltaSum);
+		node.distance = node.phi == 0 ? shortestWin
+		                : node.delta == 0 ? longestLoss
+		                                  : 0;
+
+		if (node.phi >= thresholdPhi || node.delta >= thresholdDelta ||
+		    m_Stop)
+			break;
+
+		// the best child gets searched until it stops being the best: its
+		// delta passes the second best's, or its phi grows so much that
+		// this node's delta reaches its threshold
+		uint32_t childPhi =
+			Saturate((uint64_t) thresholdDelta - node.delta + bestChild.phi);
+		uint32_t childDelta = std::min<uint64_t>(
+			thresholdPhi,
+			(uint64_t) secondDelta + secondDelta / EpsilonDivisor + 1
+		);
+		m_State->MakeMove(moves.moves[best]);
+		Expand(ply + 1, childPhi, childDelta);
+		m_State->UndoMove(moves.moves[best]);
+
+		if (m_Limits.nodes && m_Nodes >= m_Limits.nodes)
+			m_Stop = true;
+		if (m_OnProgress && m_Nodes >= m_NextProgress) {
+			m_NextProgress = m_Nodes + ProgressInterval;
+			ProofResult progress;
+			progress.nodes = m_Nodes;
+			progress.timeMs = ElapsedMilliseconds();
+			m_OnProgress(progress);
+		}
+	}
+
+	Store(m_PathKeys[ply] ^ DepthKey(ply), node, m_Nodes - startNodes);
+	return node;
+}
+
+ProofNumberSearch::Numbers
+ProofNumberSearch::Child(int ply, BoardMove move, uint64_t key) {
+	if (RepeatsPath(ply + 1, key))
+		return Escape(ply + 1);
+
+	uint64_t tableKey = key ^ DepthKey(ply + 1);
+	Numbers numbers;
+	if (Probe(tableKey, numbers))
+		return numbers;
+
+	// a new node: see whether the game is over there, otherwise it starts
+	// with its number of legal moves as delta
+	m_State->MakeMove(move);
+	m_Nodes++;
+	unsigned int replies = m_State->CountLegalMoves();
+	bool store = true;
+	if (replies == 0)
+		numbers = m_State->IsInCheck() ? Numbers{Infinity, 0, 0}
+		                               : Escape(ply + 1);
+	else if (m_MaxPlies && ply + 1 >= m_MaxPlies)
+		numbers = Escape(ply + 1);
+	else if (m_State->GetHalfMoveClock() >= 100 || ply + 1 >= MaxPly - 1) {
+		// the key doesn't know about either
+		numbers = Escape(ply + 1);
+		store = false;
+	} else
+		numbers = {1, replies, 0};
+	m_State->UndoMove(move);
+
+	if (store)
+		Store(tableKey, numbers, 0);
+	return numbers;
+}
+
+ProofNumberSearch::Numbers ProofNumberSearch::Escape(int ply) const {
+	return IsAttacker(ply) ? Numbers{Infinity, 0, 0} : Numbers{0, Infinity, 0};
+}
+
+bool ProofNumberSearch::RepeatsPath(int ply, uint64_t key) const {
+	// only positions with the same side to move can repeat
+	for (int p = ply - 2; p >= 0; p -= 2)
+		if (m_PathKeys[p] == key)
+			return true;
+	return false;
+}
+
+uint64_t ProofNumberSearch::DepthKey(int ply) const {
+	return m_MaxPlies ? (uint64_t) (m_MaxPlies - ply) * 0x9E3779B97F4A7C15ull
+	                  : 0;
+}
+
+bool ProofNumberSearch::Probe(uint64_t key, Numbers &numbers) const {
+	size_t index = key & (m_Table.size() - 2);
+	for (size_t slot = index; slot < index + 2; slot++)
+		if (m_Table[slot].key == key) {
+			numbers = {
+				m_Table[slot].phi, m_Table[slot].delta, m_Table[slot].distance
+			};
+			return true;
+		}
+	return false;
+}
+
+void ProofNumberSearch::Store(uint64_t key, Numbers numbers, uint64_t work) {
+	// the same position, otherwise whichever of the two took less work
+	size_t index = key & (m_Table.size() - 2);
+	Entry *entry = &m_Table[index];
+	if (m_Table[index + 1].key == key ||
+	    (entry->key != key && m_Table[index + 1].work < entry->work))
+		entry = &m_Table[index + 1];
+
+	entry->key = key;
+	entry->phi = numbers.phi;
+	entry->delta = numbers.delta;
+	entry->work = Saturate(work);
+	entry->distance = numbers.distance;
+}
+
+std::vector<BoardMove> ProofNumberSearch::ExtractLine() {
+	std::vector<BoardMove> line;
+	for (int ply = 0; ply < MaxPly - 1; ply++) {
+		m_PathKeys[ply] = m_State->GetKey();
+		MoveList moves;
+		m_State->GenerateLegalMoves(moves);
+
+		// the attacker takes the shortest mate, the defender holds out for
+		// the longest
+		BoardMove next;
+		int nextDistance = IsAttacker(ply) ? INT32_MAX : -1;
+		for (BoardMove move : moves) {
+			m_State->MakeMove(move);
+			uint64_t key = m_State->GetKey();
+			m_State->UndoMove(move);
+
+			Numbers child = Child(ply, move, key);
+			if (IsAttacker(ply) ? child.delta == 0 &&
+			                          child.distance < nextDistance
+			                    : child.phi == 0 &&
+			                          child.distance > nextDistance) {
+				next = move;
+				nextDistance = child.distance;
+			}
+		}
+		if (next.IsNull())
+			break;
+		m_State->MakeMove(next);
+		line.push_back(next);
+	}
+
+	for (auto it = line.rbegin(); it != line.rend(); ++it)
+		m_State->UndoMove(*it);
+	return line;
+}
+
+int64_t ProofNumberSearch::ElapsedMilliseconds() const {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(
+			   std::chrono::steady_clock::now() - m_StartTime
+	)
+		.count();
+}
+
+void ProofNumberSearch::BenchMates(
+	const std::vector<std::pair<std::string, int>> &problems, uint64_t maxNodes
+) {
+	using namespace std::chrono;
+
+	ProofNumberSearch solver(64);
+	Search search;
+	double solverSeconds = 0, searchSeconds = 0;
+	int solved = 0, found = 0;
+	for (const auto &[fen, mateMoves] : problems) {
+		BoardState state;
+		if (!state.ReadFen(fen))
+			continue;
+
+		solver.Clear();
+		ProofLimits limits;
+		limits.nodes = maxNodes;
+		limits.mateMoves = mateMoves;
+		ProofResult result = solver.Solve(state, limits);
+		solverSeconds += result.timeMs / 1000.0;
+		solved += result.status == ProofResult::Proven;
+
+		// the first iteration that sees a mate at least this short
+		search.GetTable().Clear();
+		SearchLimits searchLimits;
+		searchLimits.depth = Search::MaxPly;
+		searchLimits.moveTimeMs = BenchMateTimeMs;
+		auto start = steady_clock::now();
+		int depth = 0;
+		for (const SearchInfo &info : search.Analyse(state, searchLimits))
+			if (info.score >= Search::MateScore - (mateMoves * 2 - 1)) {
+				depth = info.depth;
+				break;
+			}
+		double seconds = duration<double>(steady_clock::now() - start).count();
+		searchSeconds += seconds;
+		found += depth > 0;
+
+		std::cout << "mate in " << mateMoves << ": df-pn " << result.ToString()
+				  << ", alpha-beta ";
+		if (depth)
+			std::cout << "depth " << depth << " nodes " << search.GetNodes()
+					  << " time " << (int64_t) (seconds * 1000) << "\n";
+		else
+			std::cout << "not found\n";
+	}
+
+	std::cout << "df-pn: " << solved << "/" << problems.size() << " in "
+			  << solverSeconds << "s, alpha-beta: " << found << "/"
+			  << problems.size() << " in " << searchSeconds << "s\n";
+}
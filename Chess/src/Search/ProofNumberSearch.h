@@ -0,0 +1,154 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Board/BoardState.h"
+
+struct ProofLimits {
+	// 0 means no limit
+	uint64_t nodes = 0;
+	// only mates in at most this many moves count, 0 for any length. A
+	// disproof then only says there is no mate this short.
+	int mateMoves = 0;
+};
+
+struct ProofResult {
+	enum Status { Proven, Disproven, Unknown };
+
+	// Unknown when a limit was hit first
+	Status status = Unknown;
+	// moves to mate and the mating line when Proven, the defence being the
+	// longest the table knows of. The first mate proven within the limit,
+	// not necessarily the shortest.
+	int mateIn = 0;
+	std::vector<BoardMove> line;
+	uint64_t nodes = 0;
+	int64_t timeMs = 0;
+
+	// "mate in 3 nodes 1234 time 5 pv ...", "no mate nodes ..." or
+	// "unknown nodes ..."
+	std::string ToString() const;
+};
+
+// Depth-first proof-number search (df-pn) that proves or disproves a forced
+// mate by the side to move. Every node has a proof number (how many leaves
+// still have to be shown to mate at least) and a disproof number (the same
+// for escaping mate), kept from the point of view of the side to move at
+// that node (phi and delta). The search always descends into the most
+// proving child, with thresholds that send it back up as soon as a sibling
+// becomes more promising, so all of the tree that matters lives in the
+// table instead of on the stack. New children start with a delta of their
+// number of legal replies: checks leaving few replies get looked at first.
+// Draws (stalemate, fifty moves, repeating a position of the current path)
+// count as escapes.
+class ProofNumberSearch
+{
+public:
+	// proof and disproof numbers of a decided node
+	static constexpr uint32_t Infinity = 1u << 30;
+
+	// deeper paths count as draws
+	static constexpr int MaxPly = 128;
+
+	// nodes between two calls to the progress callback
+	static constexpr uint64_t ProgressInterval = 1 << 16;
+
+	// the nodes and time so far, status Unknown
+	typedef std::function<void(const ProofResult &)> ProgressCallback;
+
+public:
+	explicit ProofNumberSearch(size_t megabytes = 16);
+
+	// drops every entry
+	void Resize(size_t megabytes);
+
+	void Clear();
+
+	// tries to prove a mate for the side to move in state (which is left
+	// as it was) until it is proven, disproven, a limit is hit or Stop()
+	// is called, calling onProgress every ProgressInterval nodes
+	ProofResult Solve(
+		BoardState &state, const ProofLimits &limits,
+		const ProgressCallback &onProgress = nullptr
+	);
+
+	// can be called from any thread while Solve is running
+	inline void Stop() { m_Stop = true; }
+
+	// solves every problem (a position and its mate in n) with the mate
+	// length as its limit, then searches it with search until that mate
+	// score shows up, and prints the time and nodes both took
+	static void BenchMates(
+		const std::vector<std::pair<std::string, int>> &problems,
+		uint64_t maxNodes
+	);
+
+private:
+	struct Numbers {
+		uint32_t phi = 1;
+		uint32_t delta = 1;
+		// plies to the end of the line of a decided node
+		uint16_t distance = 0;
+	};
+
+	struct Entry {
+		uint64_t key = 0;
+		uint32_t phi = 0;
+		uint32_t delta = 0;
+		// nodes searched below it, the entry with less work is replaced
+		uint32_t work = 0;
+		uint16_t distance = 0;
+	};
+
+	// searches the node m_State is at until its phi or delta reaches its
+	// threshold, stores and returns them
+	Numbers Expand(int ply, uint32_t thresholdPhi, uint32_t thresholdDelta);
+
+	// the numbers of the position reached by move from the node at ply,
+	// from the table or from its replies
+	Numbers Child(int ply, BoardMove move, uint64_t key);
+
+	// a draw or a mate that took too long: lost for the attacker, won for
+	// the defender, whoever is to move at ply
+	Numbers Escape(int ply) const;
+
+	bool RepeatsPath(int ply, uint64_t key) const;
+
+	// xored into the key of a node at ply: with a mate length limit the
+	// same position is a different problem with fewer plies left
+	uint64_t DepthKey(int ply) const;
+
+	bool Probe(uint64_t key, Numbers &numbers) const;
+
+	void Store(uint64_t key, Numbers numbers, uint64_t work);
+
+	// follows the shortest mates, and the longest defences, through the
+	// table
+	std::vector<BoardMove> ExtractLine();
+
+	bool IsAttacker(int ply) const { return (ply & 1) == 0; }
+
+	int64_t ElapsedMilliseconds() const;
+
+private:
+	std::vector<Entry> m_Table;
+
+	BoardState *m_State = nullptr;
+	ProofLimits m_Limits;
+	// 0 without a mate length limit
+	int m_MaxPlies = 0;
+	std::atomic<bool> m_Stop = false;
+	uint64_t m_Nodes = 0;
+	ProgressCallback m_OnProgress;
+	uint64_t m_NextProgress = 0;
+	std::chrono::steady_clock::time_point m_StartTime;
+
+	// keys of the positions on the current path, for repetitions
+	uint64_t m_PathKeys[MaxPly];
+};
@@ -0,0 +1,633 @@
+#include "Search.h"
+#include "Evaluation.h"
+#include "MovePicker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+namespace
+{
+	// what a capture may gain beyond the captured piece in positional terms
+	// before delta pruning gives up on it
+	constexpr int DeltaMargin = 200;
+} // namespace
+
+std::string SearchInfo::ToString() const {
+	std::string str = "depth " + std::to_string(depth);
+	if (multiPv > 0)
+		str += " multipv " + std::to_string(multiPv);
+	str += " score ";
+	if (Search::IsMateScore(score)) {
+		// in moves, negative when we are the ones getting mated
+		int plies = Search::MateScore - std::abs(score);
+		str += "mate " + std::to_string(score > 0 ? (plies + 1) / 2
+		                                          : -(plies + 1) / 2);
+	} else {
+		str += "cp " + std::to_string(score);
+	}
+	str += " nodes " + std::to_string(nodes) + " nps " + std::to_string(nps) +
+	       " time " + std::to_string(timeMs) + " hashfull " +
+	       std::to_string(hashFull) + " pv";
+	for (BoardMove move : pv) str += " " + move.ToString();
+	return str;
+}
+
+Search::Search()
+	: m_OwnTable(std::make_unique<TranspositionTable>()),
+	  m_Table(m_OwnTable.get()) {
+	SetParameters({});
+}
+
+Search::Search(TranspositionTable &table) : m_Table(&table) {
+	SetParameters({});
+}
+
+void Search::SetNetwork(const Nnue *network) {
+	m_Network = network && network->IsLoaded() ? network : nullptr;
+	m_Accumulators.resize(m_Network ? MaxPly + 1 : 0);
+}
+
+void Search::SetParameters(const SearchParameters &parameters) {
+	m_Parameters = parameters;
+
+	// late move reductions grow with the log of both the depth and the
+	// number of moves already searched
+	for (int depth = 1; depth < 64; depth++)
+		for (int moves = 1; moves < 64; moves++)
+			m_Reductions[depth][moves] = (int) (parameters.lmrBase +
+			                                    std::log(depth) *
+			                                        std::log(moves) /
+			                                        parameters.lmrDivisor);
+}
+
+BoardMove Search::Think(
+	BoardState &state, const SearchLimits &limits, const InfoCallback &onInfo
+) {
+	for (const SearchInfo &info : Analyse(state, limits))
+		if (onInfo)
+			onInfo(info);
+
+	return m_BestMove;
+}
+
+Engine::Generator<SearchInfo>
+Search::Analyse(BoardState &state, SearchLimits limits) {
+	m_State = &state;
+	m_Limits = limits;
+	m_Stop = false;
+	m_PonderHit = false;
+	m_Nodes = 0;
+	m_StartTime = std::chrono::steady_clock::now();
+	m_Time.Start(limits);
+	m_Lines.clear();
+	m_BestMove = {};
+	m_LastInfo = {};
+	m_History.Clear();
+	m_BetaCutoffs = m_FirstMoveCutoffs = 0;
+	m_PawnTable.ResetStats();
+	m_NullMoveAllowed = true;
+	for (BoardMove &move : m_ExcludedMoves) move = {};
+	// a shared table is aged by whoever shares it
+	if (m_OwnTable)
+		m_Table->NewSearch();
+
+	if (m_Network)
+		m_Network->Refresh(state, m_Accumulators[0]);
+
+	MoveList rootMoves;
+	state.GenerateLegalMoves(rootMoves);
+	if (rootMoves.size == 0)
+		co_return;
+
+	// something to play even if the first iteration doesn't finish
+	m_BestMove = rootMoves.moves[0];
+	int lineCount = std::min(m_MultiPv, rootMoves.size);
+
+	for (int depth = 1; depth <= std::min(limits.depth, MaxPly - 1); depth++) {
+		if (SkipDepth(depth))
+			continue;
+
+		m_RootDepth = depth;
+		uint64_t iterationStart = m_Nodes;
+		m_IterationLines.clear();
+		for (m_PvIndex = 0; m_PvIndex < lineCount; m_PvIndex++) {
+			int score = Negamax(depth, 0, -Infinity, Infinity);
+			if (m_Stop)
+				break;
+			m_IterationLines.push_back(
+				{score, {m_PvTable[0], m_PvTable[0] + m_PvLength[0]}}
+			);
+		}
+		if (m_Stop)
+			break;
+
+		// a later line can come out ahead of an earlier one once the
+		// earlier one's move is out of the way and the table knows more
+		std::stable_sort(
+			m_IterationLines.begin(), m_IterationLines.end(),
+			[](const RootLine &a, const RootLine &b) {
+				return a.score > b.score;
+			}
+		);
+		m_Lines.swap(m_IterationLines);
+		if (!m_Lines[0].pv.empty())
+			m_BestMove = m_Lines[0].pv[0];
+
+		int64_t elapsed = ElapsedMicroseconds();
+		m_LastInfo.depth = depth;
+		m_LastInfo.multiPv = lineCount > 1 ? 1 : 0;
+		m_LastInfo.score = m_Lines[0].score;
+		m_LastInfo.pv = m_Lines[0].pv;
+		m_LastInfo.nodes = m_Nodes;
+		m_LastInfo.nps =
+			m_LastInfo.nodes * 1000000 / std::max<int64_t>(elapsed, 1);
+		m_LastInfo.timeMs = elapsed / 1000;
+		m_LastInfo.hashFull = m_Table->GetFillRate();
+		m_LastInfo.firstMoveCutoffRate =
+			m_BetaCutoffs ? (double) m_FirstMoveCutoffs / m_BetaCutoffs : 0;
+		m_LastInfo.pawnHashHitRate = m_PawnTable.GetHitRate();
+		co_yield m_LastInfo;
+
+		for (int line = 1; line < lineCount; line++) {
+			SearchInfo info = m_LastInfo;
+			info.multiPv = line + 1;
+			info.score = m_Lines[line].score;
+			info.pv = m_Lines[line].pv;
+			co_yield info;
+		}
+
+		int score = m_Lines[0].score;
+		// no point in looking deeper once a forced mate is found
+		if (IsMateScore(score) && MateScore - std::abs(score) <= depth)
+			break;
+
+		if (m_PonderHit.exchange(false))
+			m_Time.PonderHit();
+		if (!m_Time.ShouldStartIteration(
+				m_Nodes - iterationStart, m_LastInfo.nps
+			))
+			break;
+	}
+}
+
+int Search::Negamax(int depth, int ply, int alpha, int beta) {
+	m_PvLength[ply] = 0;
+
+	if (ShouldStop())
+		return 0;
+
+	if (ply > 0) {
+		// a repetition is a draw, as is the fifty move rule unless the
+		// fiftieth move mated
+		if (m_State->IsRepetition(ply))
+			return 0;
+		if (m_State->GetHalfMoveClock() >= 100)
+			return m_State->IsInCheck() && m_State->CountLegalMoves() == 0
+			           ? -MateScore + ply
+			           : 0;
+	}
+
+	if (depth <= 0)
+		return Quiescence(ply, alpha, beta);
+
+	// only this thread writes the counter, others just read it
+	m_Nodes.store(
+		m_Nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed
+	);
+
+	if (ply >= MaxPly - 1)
+		return Evaluate(ply);
+
+	// cut off with the stored result when it is deep enough, except in pv
+	// nodes where it would cut the pv short and while searching the
+	// alternatives to an excluded move
+	bool pvNode = beta - alpha > 1;
+	BoardMove excludedMove = m_ExcludedMoves[ply];
+	uint64_t key = m_State->GetKey();
+	TTEntry entry;
+	bool hashHit = m_Table->Probe(key, entry);
+	BoardMove hashMove;
+	int hashScore = 0;
+	if (hashHit) {
+		hashMove = entry.move;
+		hashScore = TranspositionTable::ScoreFromTT(entry.score, ply);
+		if (!pvNode && ply > 0 && excludedMove.IsNull() &&
+		    entry.depth >= depth &&
+		    (entry.bound == ExactBound ||
+		     (entry.bound == LowerBound && hashScore >= beta) ||
+		     (entry.bound == UpperBound && hashScore <= alpha)))
+			return hashScore;
+	}
+
+	// the root always starts with the move the line had in the last
+	// iteration
+	if (ply == 0 && m_PvIndex < (int) m_Lines.size() &&
+	    !m_Lines[m_PvIndex].pv.empty())
+		hashMove = m_Lines[m_PvIndex].pv[0];
+
+	const SearchParameters &params = m_Parameters;
+	bool inCheck = m_State->IsInCheck();
+	int staticEval = inCheck     ? -Infinity
+	                 : hashHit ? entry.eval
+	                           : Evaluate(ply);
+	BoardMove previousMove = ply > 0 ? m_MoveStack[ply - 1] : BoardMove();
+
+	if (!pvNode && !inCheck && excludedMove.IsNull()) {
+		// razoring: this far below alpha this close to the leaves only the
+		// captures can still help
+		if (params.razoring && depth <= params.razoringDepth &&
+		    staticEval + params.razoringMargin * depth < alpha) {
+			int score = Quiescence(ply, alpha - 1, alpha);
+			if (score < alpha)
+				return score;
+		}
+
+		// reverse futility: this far above beta the opponent won't catch up
+		// in the few plies left
+		if (params.reverseFutility && depth <= params.reverseFutilityDepth &&
+		    staticEval - params.reverseFutilityMargin * depth >= beta &&
+		    !IsMateScore(beta))
+			return staticEval;
+
+		// null move: if passing still fails high a real move will too. Not
+		// twice in a row and not with only pawns left, where passing would
+		// often be the best move there is (zugzwang).
+		if (params.nullMovePruning && m_NullMoveAllowed &&
+		    depth >= params.nullMoveMinDepth && staticEval >= beta &&
+		    !previousMove.IsNull() &&
+		    m_State->HasNonPawnMaterial(m_State->GetTurn())) {
+			int reduction =
+				params.nullMoveReduction + depth / params.nullMoveDepthDivisor +
+				std::min((staticEval - beta) / params.nullMoveEvalDivisor, 3);
+
+			m_MoveStack[ply] = {};
+			m_State->MakeNullMove();
+			if (m_Network)
+				m_Accumulators[ply + 1] = m_Accumulators[ply];
+			int score =
+				-Negamax(depth - 1 - reduction, ply + 1, -beta, -beta + 1);
+			m_State->UndoNullMove();
+
+			if (m_Stop)
+				return 0;
+
+			if (score >= beta) {
+				// mates found after passing aren't proven
+				if (IsMateScore(score))
+					score = beta;
+				if (depth < params.nullMoveVerifyDepth)
+					return score;
+
+				// deep down zugzwang costs too much, make sure with a
+				// reduced search of our own without null moves
+				m_NullMoveAllowed = false;
+				int verified =
+					Negamax(depth - 1 - reduction, ply, beta - 1, beta);
+				m_NullMoveAllowed = true;
+				if (verified >= beta)
+					return score;
+			}
+		}
+	}
+
+	// futility: this far below alpha near the leaves quiet moves won't get
+	// back up, only the ones giving check are still searched
+	bool futile = params.futilityPruning && !pvNode && !inCheck &&
+	              depth <= params.futilityDepth &&
+	              staticEval + params.futilityMargin * depth <= alpha;
+
+	MovePicker picker(*m_State, hashMove, m_History, ply, previousMove);
+
+	int originalAlpha = alpha;
+	int bestScore = -Infinity;
+	BoardMove bestMove;
+	BoardMove triedQuiets[64];
+	int triedQuietCount = 0;
+	int movesSearched = 0;
+	for (BoardMove move; !(move = picker.Next()).IsNull();) {
+		if (move == excludedMove || (ply == 0 && IsRootExcluded(move)))
+			continue;
+
+		bool quiet = !move.IsCapture() && !move.IsPromotion();
+
+		// singular extension: the hash move is much better than all the
+		// others, search it deeper
+		int extension = 0;
+		if (params.singularExtensions && ply > 0 &&
+		    depth >= params.singularMinDepth && excludedMove.IsNull() &&
+		    hashHit && move == entry.move && (entry.bound & LowerBound) &&
+		    entry.depth >= depth - 3 && !IsMateScore(hashScore)) {
+			int singularBeta = hashScore - params.singularMargin * depth;
+			m_ExcludedMoves[ply] = move;
+			int score =
+				Negamax((depth - 1) / 2, ply, singularBeta - 1, singularBeta);
+			m_ExcludedMoves[ply] = {};
+
+			if (m_Stop)
+				return 0;
+			if (score < singularBeta)
+				extension = 1;
+		}
+
+		m_MoveStack[ply] = move;
+		MakeMove(move, ply);
+		m_Table->Prefetch(m_State->GetKey());
+		bool givesCheck = m_State->IsInCheck();
+
+		if (futile && quiet && !givesCheck && movesSearched > 0) {
+			m_State->UndoMove(move);
+			continue;
+		}
+
+		if (params.checkExtensions && givesCheck)
+			extension = 1;
+		// keeps the extensions from running away
+		if (ply >= 2 * m_RootDepth)
+			extension = 0;
+		int newDepth = depth - 1 + extension;
+
+		// the first move gets the full window, the rest only have to prove
+		// they are no better and are searched again if they are
+		int score;
+		if (movesSearched == 0) {
+			score = -Negamax(newDepth, ply + 1, -beta, -alpha);
+		} else {
+			// late move reductions: quiet moves this far down the list
+			// rarely matter, look at them shallower first
+			int reduction = 0;
+			if (params.lateMoveReductions && quiet && !inCheck &&
+			    !givesCheck && depth >= params.lmrMinDepth &&
+			    movesSearched >= params.lmrMinMoves)
+				reduction = std::clamp(
+					m_Reductions[std::min(depth, 63)]
+								[std::min(movesSearched, 63)] -
+						pvNode,
+					0, newDepth - 1
+				);
+
+			score = -Negamax(newDepth - reduction, ply + 1, -alpha - 1, -alpha);
+			if (reduction > 0 && score > alpha)
+				score = -Negamax(newDepth, ply + 1, -alpha - 1, -alpha);
+			if (score > alpha && score < beta)
+				score = -Negamax(newDepth, ply + 1, -beta, -alpha);
+		}
+
+		m_State->UndoMove(move);
+		movesSearched++;
+
+		if (m_Stop)
+			return 0;
+
+		if (score > bestScore)
+			bestScore = score;
+
+		if (score > alpha) {
+			alpha = score;
+			bestMove = move;
+
+			m_PvTable[ply][0] = move;
+			std::copy(
+				m_PvTable[ply + 1], m_PvTable[ply + 1] + m_PvLength[ply + 1],
+				m_PvTable[ply] + 1
+			);
+			m_PvLength[ply] = m_PvLength[ply + 1] + 1;
+
+			if (alpha >= beta) {
+				m_BetaCutoffs++;
+				if (movesSearched == 1)
+					m_FirstMoveCutoffs++;
+				if (quiet)
+					m_History.UpdateQuiet(
+						*m_State, move, previousMove, ply, depth, triedQuiets,
+						triedQuietCount
+					);
+				break;
+			}
+		}
+
+		if (quiet && triedQuietCount < 64)
+			triedQuiets[triedQuietCount++] = move;
+	}
+
+	// the picker only hands out legal moves, so none means mate or
+	// stalemate, unless the only one was excluded
+	if (movesSearched == 0) {
+		if (!excludedMove.IsNull())
+			return alpha;
+		return inCheck ? -MateScore + ply : 0;
+	}
+
+	// results without the excluded moves don't belong to this position
+	if (!excludedMove.IsNull() || (ply == 0 && m_PvIndex > 0))
+		return bestScore;
+
+	Bound bound = bestScore >= beta            ? LowerBound
+	              : bestScore > originalAlpha ? ExactBound
+	                                          : UpperBound;
+	m_Table->Store(
+		key, bestMove, TranspositionTable::ScoreToTT(bestScore, ply),
+		inCheck ? Evaluate(ply) : staticEval, depth, bound
+	);
+
+	return bestScore;
+}
+
+int Search::Quiescence(int ply, int alpha, int beta) {
+	m_PvLength[ply] = 0;
+
+	if (ShouldStop())
+		return 0;
+
+	m_Nodes.store(
+		m_Nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed
+	);
+
+	if (ply >= MaxPly - 1)
+		return Evaluate(ply);
+
+	// the side to move can usually do at least as well as the static eval
+	// by not capturing anything, except when in check where every evasion
+	// is searched instead
+	bool inCheck = m_State->IsInCheck();
+	int standPat = -Infinity;
+	if (!inCheck) {
+		standPat = Evaluate(ply);
+		if (standPat >= beta)
+			return standPat;
+		alpha = std::max(alpha, standPat);
+	}
+
+	int bestScore = standPat;
+	MovePicker picker(*m_State, m_History);
+	for (BoardMove move; !(move = picker.Next()).IsNull();) {
+		// delta pruning: not even getting the captured piece for free
+		// brings this capture up to alpha
+		if (!inCheck && !move.IsPromotion()) {
+			PieceType victim = move.Flags() == BoardMove::EnPassant
+			                       ? PawnPiece
+			                       : m_State->GetPieceType(move.To());
+			if (standPat + Evaluation::PieceValues[victim] + DeltaMargin <=
+			    alpha)
+				continue;
+		}
+
+		m_MoveStack[ply] = move;
+		MakeMove(move, ply);
+		int score = -Quiescence(ply + 1, -beta, -alpha);
+		m_State->UndoMove(move);
+
+		if (m_Stop)
+			return 0;
+
+		if (score > bestScore) {
+			bestScore = score;
+			if (score > alpha) {
+				alpha = score;
+				if (alpha >= beta)
+					break;
+			}
+		}
+	}
+
+	if (inCheck && bestScore == -Infinity)
+		return -MateScore + ply;
+
+	return bestScore;
+}
+
+void Search::BenchParameters(const std::vector<std::string> &fens, int depth) {
+	SearchLimits limits;
+	limits.depth = depth;
+	auto run = [&](const SearchParameters &parameters) {
+		SetParameters(parameters);
+		return TimeSearches(*this, fens, limits);
+	};
+
+	auto print = [](const char *name, BenchTotals totals,
+	                BenchTotals baseline) {
+		std::cout << name << ": " << totals.seconds << "s, " << totals.nodes
+				  << " nodes, time to depth "
+				  << baseline.seconds / std::max(totals.seconds, 1e-9)
+				  << "x\n";
+	};
+
+	static const std::pair<const char *, bool SearchParameters::*> toggles[] = {
+		{"check extensions", &SearchParameters::checkExtensions},
+		{"singular extensions", &SearchParameters::singularExtensions},
+		{"null move pruning", &SearchParameters::nullMovePruning},
+		{"late move reductions", &SearchParameters::lateMoveReductions},
+		{"reverse futility", &SearchParameters::reverseFutility},
+		{"futility pruning", &SearchParameters::futilityPruning},
+		{"razoring", &SearchParameters::razoring}};
+
+	SearchParameters current = m_Parameters;
+	SearchParameters none = current;
+	for (const auto &toggle : toggles) none.*toggle.second = false;
+
+	std::cout << "depth " << depth << ", " << fens.size() << " positions\n";
+	BenchTotals baseline = run(none);
+	print("none", baseline, baseline);
+	for (const auto &toggle : toggles) {
+		SearchParameters only = none;
+		only.*toggle.second = true;
+		print(toggle.first, run(only), baseline);
+	}
+	print("all", run(current), baseline);
+	std::cout << std::flush;
+
+	SetParameters(current);
+}
+
+void Search::BenchMultiPv(
+	const std::vector<std::string> &fens, int depth, int lines
+) {
+	SearchLimits limits;
+	limits.depth = depth;
+	auto run = [&](int multiPv) {
+		SetMultiPv(multiPv);
+		return TimeSearches(*this, fens, limits);
+	};
+
+	int current = m_MultiPv;
+	BenchTotals single = run(1);
+	BenchTotals multi = run(lines);
+	SetMultiPv(current);
+
+	std::cout << "depth " << depth << ", " << fens.size() << " positions\n"
+			  << "1 line: " << single.seconds << "s, " << single.nodes
+			  << " nodes\n"
+			  << lines << " lines: " << multi.seconds << "s, " << multi.nodes
+			  << " nodes\n"
+			  << "overhead: "
+			  << multi.seconds / std::max(single.seconds, 1e-9) << "x time, "
+			  << (double) multi.nodes / std::max<uint64_t>(single.nodes, 1)
+			  << "x nodes" << std::endl;
+}
+
+void Search::MakeMove(BoardMove move, int ply) {
+	if (!m_Network) {
+		m_State->MakeMove(move);
+		return;
+	}
+
+	NnueChange change = Nnue::GetChange(*m_State, move);
+	m_State->MakeMove(move);
+	m_Network->Update(
+		m_Accumulators[ply], m_Accumulators[ply + 1], change, *m_State
+	);
+}
+
+int Search::Evaluate(int ply) {
+	if (m_Network)
+		return m_Network->Evaluate(*m_State, m_Accumulators[ply]);
+	return Evaluation::Evaluate(*m_State, m_PawnTable);
+}
+
+bool Search::SkipDepth(int depth) const {
+	// helpers skip depths in different patterns so that they don't all
+	// search the same tree as the main thread at the same time
+	static constexpr int SkipSize[] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+	                                   3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+	static constexpr int SkipPhase[] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3,
+	                                    4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+	if (m_HelperIndex == 0)
+		return false;
+
+	int i = (m_HelperIndex - 1) % 20;
+	return ((depth + SkipPhase[i]) / SkipSize[i]) % 2;
+}
+
+bool Search::ShouldStop() {
+	if (m_Stop)
+		return true;
+
+	// a plain load at every node, the exchange only once it was hit
+	if (m_PonderHit.load(std::memory_order_relaxed) &&
+	    m_PonderHit.exchange(false))
+		m_Time.PonderHit();
+
+	uint64_t nodes = m_Nodes.load(std::memory_order_relaxed);
+	if (m_Limits.nodes && nodes >= m_Limits.nodes)
+		m_Stop = true;
+	else if (m_Time.IsTimeUp())
+		m_Stop = true;
+
+	return m_Stop;
+}
+
+bool Search::IsRootExcluded(BoardMove move) const {
+	for (int line = 0; line < m_PvIndex; line++)
+		if (!m_IterationLines[line].pv.empty() &&
+		    m_IterationLines[line].pv[0] == move)
+			return true;
+	return false;
+}
+
+int64_t Search::ElapsedMicroseconds() const {
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+			   std::chrono::steady_clock::now() - m_StartTime
+	)
+		.count();
+}
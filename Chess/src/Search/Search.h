@@ -0,0 +1,289 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Board/BoardState.h"
+#include "Engine/Generator.h"
+#include "MovePicker.h"
+#include "Nnue.h"
+#include "PawnTable.h"
+#include "TimeManager.h"
+#include "TranspositionTable.h"
+
+// switches and tuning values of the selective search, the defaults are
+// what the engine plays with. Depths are in plies, margins in centipawns.
+struct SearchParameters {
+	bool checkExtensions = true;
+	bool singularExtensions = true;
+	bool nullMovePruning = true;
+	bool lateMoveReductions = true;
+	bool reverseFutility = true;
+	bool futilityPruning = true;
+	bool razoring = true;
+
+	// null move reduction: base + depth / depthDivisor + up to 3 more the
+	// further the eval is above beta (one per evalDivisor). From
+	// verifyDepth on a fail high is verified with a normal reduced search.
+	int nullMoveMinDepth = 3;
+	int nullMoveReduction = 3;
+	int nullMoveDepthDivisor = 4;
+	int nullMoveEvalDivisor = 200;
+	int nullMoveVerifyDepth = 10;
+
+	// reduction: base + log(depth) * log(moves searched) / divisor, after
+	// the first minMoves moves
+	int lmrMinDepth = 3;
+	int lmrMinMoves = 3;
+	double lmrBase = 0.75;
+	double lmrDivisor = 2.25;
+
+	// margins grow by one per ply of depth left
+	int reverseFutilityDepth = 6;
+	int reverseFutilityMargin = 90;
+	int futilityDepth = 6;
+	int futilityMargin = 120;
+	int razoringDepth = 2;
+	int razoringMargin = 300;
+
+	// the hash move is singular when every other move fails low against
+	// its score minus margin * depth
+	int singularMinDepth = 8;
+	int singularMargin = 2;
+};
+
+// reported after every completed iteration
+struct SearchInfo {
+	int depth = 0;
+	// which of the best lines this is (1 the best) when searching more
+	// than one, 0 otherwise
+	int multiPv = 0;
+	// centipawns from the side to move's point of view, or a mate score
+	// (see Search::IsMateScore)
+	int score = 0;
+	std::vector<BoardMove> pv;
+	uint64_t nodes = 0;
+	uint64_t nps = 0;
+	int64_t timeMs = 0;
+	// per mille of the transposition table in use
+	int hashFull = 0;
+	// share of beta cutoffs caused by the first move searched, how good
+	// the move ordering is
+	double firstMoveCutoffRate = 0;
+	// share of pawn structure lookups served by the pawn table
+	double pawnHashHitRate = 0;
+
+	// "depth 5 score cp 32 nodes 12345 nps 1000000 time 12 hashfull 3 pv
+	// e2e4 e7e5", with "multipv 2" after the depth for the other lines
+	std::string ToString() const;
+};
+
+// Negamax alpha-beta with iterative deepening and principal variation
+// search ending in a quiescence search, running on BoardState's
+// make/unmake. The selective search (pruning, reductions and extensions)
+// is set up with SearchParameters.
+class Search
+{
+public:
+	static constexpr int MaxPly = 128;
+	static constexpr int Infinity = 32000;
+	static constexpr int MateScore = 31000;
+
+	typedef std::function<void(const SearchInfo &)> InfoCallback;
+
+public:
+	// searches with a table of its own
+	Search();
+
+	// searches with a table that may be shared with other searches
+	explicit Search(TranspositionTable &table);
+
+	// searches state (which is left as it was) until one of the limits is
+	// hit or Stop() is called, calling onInfo after every iteration.
+	// Returns the best move, a null move if there are no legal moves.
+	BoardMove Think(
+		BoardState &state, const SearchLimits &limits,
+		const InfoCallback &onInfo = nullptr
+	);
+
+	// Think as a generator: yields the info of every completed iteration
+	// (one per line with MultiPV, best first) and suspends the search in
+	// between, on the same board and stacks.
+	// state has to outlive the generator and the time limit keeps running
+	// while it is suspended. GetBestMove has the move so far.
+	Engine::Generator<SearchInfo>
+	Analyse(BoardState &state, SearchLimits limits);
+
+	// best move of the last completed iteration (or the first legal move
+	// before that), a null move if there are no legal moves
+	inline BoardMove GetBestMove() const { return m_BestMove; }
+
+	// evaluates with network instead of Evaluation, nullptr (or a network
+	// without weights) switches back. The network has to outlive the
+	// search. Not while Think is running.
+	void SetNetwork(const Nnue *network);
+
+	// not while Think is running
+	void SetParameters(const SearchParameters &parameters);
+
+	inline const SearchParameters &GetParameters() const {
+		return m_Parameters;
+	}
+
+	// how many of the best root moves to find at every depth: each line
+	// is searched with the root moves of the lines before it excluded, all
+	// of them sharing the table. Not while Think is running.
+	inline void SetMultiPv(int lines) { m_MultiPv = std::max(lines, 1); }
+
+	inline int GetMultiPv() const { return m_MultiPv; }
+
+	// searches every position to the same depth with all of the selective
+	// search switched off, then with each technique on its own and then
+	// with the current parameters, and prints the time-to-depth of each
+	void BenchParameters(const std::vector<std::string> &fens, int depth);
+
+	// searches every position to the same depth with a single line and
+	// then with lines lines, and prints the time and nodes of both
+	void BenchMultiPv(
+		const std::vector<std::string> &fens, int depth, int lines
+	);
+
+	// can be called from any thread while Think is running
+	inline void Stop() { m_Stop = true; }
+
+	// the move a ponder search assumed was played, the time limits start
+	// counting now. Can be called from any thread while Think is running,
+	// a search that isn't pondering (anymore) ignores it.
+	inline void PonderHit() { m_PonderHit = true; }
+
+	// safe to read from other threads while searching
+	inline uint64_t GetNodes() const {
+		return m_Nodes.load(std::memory_order_relaxed);
+	}
+
+	// 0 for a search of its own or the main thread of a SmpSearch, helper
+	// threads count from 1 and skip some of the iterations
+	inline void SetHelperIndex(int index) { m_HelperIndex = index; }
+
+	inline TranspositionTable &GetTable() { return *m_Table; }
+
+	inline const SearchInfo &GetLastInfo() const { return m_LastInfo; }
+
+	static inline bool IsMateScore(int score) {
+		return score >= MateScore - MaxPly || score <= -MateScore + MaxPly;
+	}
+
+private:
+	int Negamax(int depth, int ply, int alpha, int beta);
+
+	// searches captures and promotions only until the position is quiet,
+	// so that the leaves aren't evaluated in the middle of an exchange.
+	// Losing captures (by SEE) are skipped.
+	int Quiescence(int ply, int alpha, int beta);
+
+	// MakeMove that also updates the network's accumulator for ply + 1
+	void MakeMove(BoardMove move, int ply);
+
+	// static evaluation of the position at ply
+	int Evaluate(int ply);
+
+	bool SkipDepth(int depth) const;
+
+	bool ShouldStop();
+
+	int64_t ElapsedMicroseconds() const;
+
+	// root move of one of the lines already found in this iteration
+	bool IsRootExcluded(BoardMove move) const;
+
+private:
+	std::unique_ptr<TranspositionTable> m_OwnTable;
+	TranspositionTable *m_Table;
+
+	BoardState *m_State = nullptr;
+	SearchLimits m_Limits;
+	TimeManager m_Time;
+	std::atomic<bool> m_Stop = false;
+	std::atomic<bool> m_PonderHit = false;
+	std::atomic<uint64_t> m_Nodes = 0;
+	int m_HelperIndex = 0;
+	std::chrono::steady_clock::time_point m_StartTime;
+
+	// triangular pv table, row ply holds the pv found from that ply on
+	BoardMove m_PvTable[MaxPly][MaxPly];
+	int m_PvLength[MaxPly] {};
+	struct RootLine {
+		int score;
+		std::vector<BoardMove> pv;
+	};
+
+	// lines of the last completed iteration, best first
+	std::vector<RootLine> m_Lines;
+	BoardMove m_BestMove;
+	int m_MultiPv = 1;
+	// line being searched, the root moves of the lines before it in this
+	// iteration are skipped
+	int m_PvIndex = 0;
+	std::vector<RootLine> m_IterationLines;
+
+	const Nnue *m_Network = nullptr;
+	// accumulator of the position at every ply, only with a network
+	std::vector<NnueAccumulator> m_Accumulators;
+
+	// per search thread, like the move ordering history
+	PawnTable m_PawnTable;
+
+	SearchParameters m_Parameters;
+	// late move reductions by depth and moves searched
+	int m_Reductions[64][64] {};
+	int m_RootDepth = 0;
+	bool m_NullMoveAllowed = true;
+	// move skipped at every ply while testing if the hash move is singular
+	BoardMove m_ExcludedMoves[MaxPly];
+
+	static_assert(MoveHistory::MaxPly >= MaxPly);
+	MoveHistory m_History;
+	// move made at every ply of the current line
+	BoardMove m_MoveStack[MaxPly];
+	uint64_t m_BetaCutoffs = 0;
+	uint64_t m_FirstMoveCutoffs = 0;
+
+	SearchInfo m_LastInfo;
+};
+
+// what searching a set of positions cost, for the benches
+struct BenchTotals {
+	double seconds = 0;
+	uint64_t nodes = 0;
+};
+
+// searches every position with limits using searcher (a Search or an
+// SmpSearch), each from an empty table to be fair, and adds up the time
+// and nodes. Positions that don't read are skipped.
+template<typename Searcher>
+BenchTotals TimeSearches(
+	Searcher &searcher, const std::vector<std::string> &fens,
+	const SearchLimits &limits
+) {
+	using namespace std::chrono;
+
+	BenchTotals totals;
+	for (const std::string &fen : fens) {
+		BoardState state;
+		if (!state.ReadFen(fen))
+			continue;
+
+		searcher.GetTable().Clear();
+		auto start = steady_clock::now();
+		searcher.Think(state, limits);
+		totals.seconds += duration<double>(steady_clock::now() - start).count();
+		totals.nodes += searcher.GetNodes();
+	}
+	return totals;
+}
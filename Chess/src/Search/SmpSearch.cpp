@@ -0,0 +1,172 @@
+#include "SmpSearch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#if defined(_WIN32)
+#	define NOMINMAX
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+#elif defined(__linux__)
+#	include <pthread.h>
+#endif
+
+SmpSearch::SmpSearch(int threads /*=1*/, size_t hashMegabytes /*=16*/)
+	: m_Table(hashMegabytes), m_MainSearch(m_Table) {
+	SetThreadCount(threads);
+}
+
+SmpSearch::~SmpSearch() { StopWorkers(); }
+
+void SmpSearch::SetThreadCount(int threads) {
+	StopWorkers();
+
+	m_Quit = false;
+	for (int i = 1; i < std::max(threads, 1); i++) {
+		auto worker = std::make_unique<Worker>(m_Table);
+		worker->search.SetHelperIndex(i);
+		worker->search.SetParameters(m_MainSearch.GetParameters());
+		worker->search.SetNetwork(m_Network);
+		worker->thread = std::thread(
+			&SmpSearch::RunWorker, this, std::ref(*worker), m_Job
+		);
+		if (m_PinThreads)
+			PinThread(worker->thread, i);
+		m_Workers.push_back(std::move(worker));
+	}
+}
+
+void SmpSearch::SetParameters(const SearchParameters &parameters) {
+	m_MainSearch.SetParameters(parameters);
+	for (auto &worker : m_Workers) worker->search.SetParameters(parameters);
+}
+
+void SmpSearch::SetNetwork(const Nnue *network) {
+	m_Network = network;
+	m_MainSearch.SetNetwork(network);
+	for (auto &worker : m_Workers) worker->search.SetNetwork(network);
+}
+
+BoardMove SmpSearch::Think(
+	const BoardState &state, const SearchLimits &limits,
+	const Search::InfoCallback &onInfo
+) {
+	m_Table.NewSearch();
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Root = state;
+		m_Searching = (int) m_Workers.size();
+		m_Job++;
+	}
+	m_Wake.notify_all();
+
+	// report the work of every thread, not just ours
+	Search::InfoCallback report;
+	if (onInfo) {
+		report = [&](const SearchInfo &info) {
+			SearchInfo total = info;
+			total.nodes = GetNodes();
+			total.nps = total.nodes * 1000 / std::max<int64_t>(info.timeMs, 1);
+			onInfo(total);
+		};
+	}
+
+	m_MainState = state;
+	BoardMove best = m_MainSearch.Think(m_MainState, limits, report);
+
+	// the helpers have no limits of their own, keep telling them to stop
+	// until they all did (one might not have started searching yet)
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	while (m_Searching > 0) {
+		for (auto &worker : m_Workers) worker->search.Stop();
+		m_Done.wait_for(lock, std::chrono::milliseconds(1));
+	}
+
+	return best;
+}
+
+void SmpSearch::Stop() {
+	m_MainSearch.Stop();
+	for (auto &worker : m_Workers) worker->search.Stop();
+}
+
+uint64_t SmpSearch::GetNodes() const {
+	uint64_t nodes = m_MainSearch.GetNodes();
+	for (auto &worker : m_Workers) nodes += worker->search.GetNodes();
+	return nodes;
+}
+
+void SmpSearch::BenchSpeedup(const std::vector<std::string> &fens, int depth) {
+	SearchLimits limits;
+	limits.depth = depth;
+	auto run = [&](int threads) {
+		SetThreadCount(threads);
+		return TimeSearches(*this, fens, limits);
+	};
+
+	int threads = GetThreadCount();
+	BenchTotals single = run(1);
+	BenchTotals smp = run(threads);
+	SetThreadCount(threads);
+
+	std::cout << "depth " << depth << ", " << fens.size() << " positions\n"
+			  << "1 thread: " << single.seconds << "s, "
+			  << (uint64_t) (single.nodes / std::max(single.seconds, 1e-9))
+			  << " nps\n"
+			  << threads << " threads: " << smp.seconds << "s, "
+			  << (uint64_t) (smp.nodes / std::max(smp.seconds, 1e-9))
+			  << " nps\n"
+			  << "time to depth speedup: "
+			  << single.seconds / std::max(smp.seconds, 1e-9) << "x"
+			  << std::endl;
+}
+
+void SmpSearch::RunWorker(Worker &worker, uint64_t lastJob) {
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Wake.wait(lock, [&] { return m_Quit || m_Job != lastJob; });
+			if (m_Quit)
+				return;
+			lastJob = m_Job;
+			worker.state = m_Root;
+		}
+
+		SearchLimits limits;
+		limits.depth = Search::MaxPly;
+		worker.search.Think(worker.state, limits);
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Searching--;
+		}
+		m_Done.notify_all();
+	}
+}
+
+void SmpSearch::StopWorkers() {
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Quit = true;
+	}
+	m_Wake.notify_all();
+
+	for (auto &worker : m_Workers) worker->thread.join();
+	m_Workers.clear();
+}
+
+void SmpSearch::PinThread(std::thread &thread, int core) {
+	int cores = (int) std::max(std::thread::hardware_concurrency(), 1u);
+	core %= cores;
+
+#if defined(_WIN32)
+	SetThreadAffinityMask(thread.native_handle(), 1ULL << (core % 64));
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(core, &set);
+	pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#endif
+}
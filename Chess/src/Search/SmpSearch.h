@@ -0,0 +1,101 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Search.h"
+
+// Lazy SMP: the calling thread runs the main search while helper threads
+// search the same position on their own board copies, with their own move
+// ordering state, all sharing one transposition table. The helpers skip
+// some depths so they fill the table ahead of the main thread instead of
+// repeating it. Only the main thread reports info and picks the move.
+class SmpSearch
+{
+public:
+	explicit SmpSearch(int threads = 1, size_t hashMegabytes = 16);
+
+	~SmpSearch();
+
+	// waits for the helpers to exit and starts new ones
+	void SetThreadCount(int threads);
+
+	inline int GetThreadCount() const { return (int) m_Workers.size() + 1; }
+
+	// pins helper n to core n, the calling thread is left alone. Takes
+	// effect with the next SetThreadCount.
+	inline void SetPinThreads(bool pin) { m_PinThreads = pin; }
+
+	inline TranspositionTable &GetTable() { return m_Table; }
+
+	// for every thread, not while Think is running
+	void SetParameters(const SearchParameters &parameters);
+
+	// for every thread, see Search::SetNetwork
+	void SetNetwork(const Nnue *network);
+
+	// see Search::SetMultiPv, only the main thread reports lines so the
+	// helpers keep searching one
+	inline void SetMultiPv(int lines) { m_MainSearch.SetMultiPv(lines); }
+
+	// like Search::Think, the nodes and nps reported are summed over every
+	// thread
+	BoardMove Think(
+		const BoardState &state, const SearchLimits &limits,
+		const Search::InfoCallback &onInfo = nullptr
+	);
+
+	// can be called from any thread while Think is running
+	void Stop();
+
+	// see Search::PonderHit, only the main thread has time limits
+	inline void PonderHit() { m_MainSearch.PonderHit(); }
+
+	uint64_t GetNodes() const;
+
+	// searches every position to the same depth with one thread and then
+	// with the configured thread count, and prints the time-to-depth
+	// speedup and both nps
+	void BenchSpeedup(const std::vector<std::string> &fens, int depth);
+
+private:
+	// each on its own cache lines so the node counters and boards of
+	// different threads never share one
+	struct alignas(64) Worker {
+		Search search;
+		BoardState state;
+		std::thread thread;
+
+		explicit Worker(TranspositionTable &table) : search(table) {}
+	};
+
+	// lastJob is the job that was current when the worker was created, it
+	// only picks up newer ones
+	void RunWorker(Worker &worker, uint64_t lastJob);
+
+	void StopWorkers();
+
+	static void PinThread(std::thread &thread, int core);
+
+private:
+	TranspositionTable m_Table;
+	Search m_MainSearch;
+	BoardState m_MainState;
+
+	std::vector<std::unique_ptr<Worker>> m_Workers;
+	bool m_PinThreads = true;
+	const Nnue *m_Network = nullptr;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_Wake;
+	std::condition_variable m_Done;
+	// bumped to hand a new position to the helpers
+	uint64_t m_Job = 0;
+	int m_Searching = 0;
+	bool m_Quit = false;
+	BoardState m_Root;
+};
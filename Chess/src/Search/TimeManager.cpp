@@ -0,0 +1,99 @@
+#include "TimeManager.h"
+
+#include <algorithm>
+
+namespace
+{
+	// moves the remaining time is spread over without a movestogo
+	constexpr int MovesHorizon = 30;
+
+	// the maximum is this many optimums, but never more than this share of
+	// the time left
+	constexpr int MaximumScale = 4;
+	constexpr int MaximumShareDivisor = 3;
+
+	// how much the nodes of one iteration can grow over the last one,
+	// bounds for the measured branching factor and what is assumed before
+	// there are two iterations to compare
+	constexpr double MinBranching = 1.5;
+	constexpr double MaxBranching = 8.0;
+	constexpr double DefaultBranching = 4.0;
+} // namespace
+
+void TimeManager::Start(const SearchLimits &limits) {
+	m_Limits = limits;
+	m_Start = Clock::now();
+	m_PreviousIterationNodes = 0;
+	m_Active = false;
+	if (!limits.ponder)
+		Allocate();
+}
+
+void TimeManager::PonderHit() {
+	if (!m_Limits.ponder)
+		return;
+	m_Limits.ponder = false;
+	Allocate();
+	// look at the clock right away, a long ponder may already be over time
+	m_Countdown = 1;
+}
+
+bool TimeManager::ShouldStartIteration(uint64_t iterationNodes, uint64_t nps) {
+	uint64_t previous = m_PreviousIterationNodes;
+	m_PreviousIterationNodes = iterationNodes;
+	if (!m_Active)
+		return true;
+
+	int64_t elapsed = ElapsedMicroseconds();
+	if (elapsed >= m_OptimumUs)
+		return false;
+
+	double branching =
+		previous ? std::clamp(
+					   (double) iterationNodes / (double) previous,
+					   MinBranching, MaxBranching
+				   )
+				 : DefaultBranching;
+	double predictedUs = (double) iterationNodes * branching * 1e6 /
+	                     (double) std::max<uint64_t>(nps, 1);
+	return elapsed + predictedUs <= (double) m_MaximumUs;
+}
+
+void TimeManager::Allocate() {
+	if (m_Limits.moveTimeMs) {
+		m_OptimumUs = m_MaximumUs = m_Limits.moveTimeMs * 1000;
+		m_Active = true;
+		return;
+	}
+
+	if (!m_Limits.timeLeftMs) {
+		m_Active = false;
+		return;
+	}
+
+	int64_t time = m_Limits.timeLeftMs;
+	int64_t usable = std::max<int64_t>(time - OverheadMs, 1);
+	int moves = m_Limits.movesToGo > 0 ? std::min(m_Limits.movesToGo, 40)
+	                                   : MovesHorizon;
+
+	int64_t optimum = time / moves + m_Limits.incrementMs * 3 / 4;
+	// with a single move to go everything left can go into it
+	int64_t maximum =
+		moves == 1 ? usable
+				   : std::min(
+						 optimum * MaximumScale,
+						 time / MaximumShareDivisor + m_Limits.incrementMs
+					 );
+
+	m_OptimumUs = std::clamp<int64_t>(optimum, 1, usable) * 1000;
+	m_MaximumUs = std::clamp<int64_t>(maximum, 1, usable) * 1000;
+	m_OptimumUs = std::min(m_OptimumUs, m_MaximumUs);
+	m_Active = true;
+}
+
+int64_t TimeManager::ElapsedMicroseconds() const {
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+			   Clock::now() - m_Start
+	)
+		.count();
+}
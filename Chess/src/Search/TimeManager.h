@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+struct SearchLimits {
+	int depth = 64;
+	// 0 means no limit
+	uint64_t nodes = 0;
+	int64_t moveTimeMs = 0;
+
+	// the side to move's clock, 0 when not playing on one. movesToGo 0
+	// means the rest of the game has to be played in timeLeftMs.
+	int64_t timeLeftMs = 0;
+	int64_t incrementMs = 0;
+	int movesToGo = 0;
+
+	// searching on the opponent's time: nothing is timed until
+	// Search::PonderHit
+	bool ponder = false;
+};
+
+// Decides when a search on the clock or with a move time has to end. Each
+// search gets an optimum time, after which no new iteration is started,
+// and a maximum time at which the search is aborted. Before every
+// iteration the cost of the next one is extrapolated from the nodes of the
+// last one, times the branching factor seen so far, at the current speed.
+// An iteration that couldn't finish before the maximum isn't started at
+// all, so the time it would have taken isn't thrown away.
+class TimeManager
+{
+public:
+	// steady_clock since it never jumps, its resolution is well below
+	// what matters here
+	typedef std::chrono::steady_clock Clock;
+
+	// calls to IsTimeUp between two looks at the clock
+	static constexpr int CheckInterval = 1024;
+
+	// kept back from the clock for talking to the gui and the os
+	static constexpr int64_t OverheadMs = 30;
+
+public:
+	// starts timing a search, unless it ponders
+	void Start(const SearchLimits &limits);
+
+	// the ponder move was played, starts timing with the limits Start got.
+	// The time spent pondering counts as spent on this move: the search
+	// got that far already, so after a long ponder it ends right away.
+	void PonderHit();
+
+	// whether there is a time limit right now
+	inline bool IsActive() const { return m_Active; }
+
+	// true once the maximum time is used up, reads the clock only once
+	// every CheckInterval calls so it can be called at every node
+	inline bool IsTimeUp() {
+		if (!m_Active || --m_Countdown > 0)
+			return false;
+		m_Countdown = CheckInterval;
+		return ElapsedMicroseconds() >= m_MaximumUs;
+	}
+
+	// after every completed iteration, with the nodes it took and the
+	// search speed in nodes per second: whether to start the next one
+	bool ShouldStartIteration(uint64_t iterationNodes, uint64_t nps);
+
+	inline int64_t GetOptimumMs() const { return m_OptimumUs / 1000; }
+
+	inline int64_t GetMaximumMs() const { return m_MaximumUs / 1000; }
+
+private:
+	void Allocate();
+
+	int64_t ElapsedMicroseconds() const;
+
+private:
+	SearchLimits m_Limits;
+	bool m_Active = false;
+	int m_Countdown = CheckInterval;
+	Clock::time_point m_Start;
+	int64_t m_OptimumUs = 0;
+	int64_t m_MaximumUs = 0;
+	uint64_t m_PreviousIterationNodes = 0;
+};
@@ -0,0 +1,156 @@
+#include "TranspositionTable.h"
+#include "Search.h"
+
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#	include <xmmintrin.h>
+#endif
+
+// data layout, low to high bits: move 16, score 16, eval 16, depth 8,
+// bound 2, age 6
+
+TranspositionTable::TranspositionTable(size_t megabytes /*=16*/) {
+	Resize(megabytes);
+}
+
+void TranspositionTable::Resize(size_t megabytes) {
+	size_t buckets = std::max<size_t>(megabytes, 1) * 1024 * 1024 /
+	                 sizeof(Bucket);
+
+	// round down to a power of two so the index is a mask
+	size_t count = 1;
+	while (count * 2 <= buckets) count *= 2;
+
+	m_Buckets.reset();
+	m_Buckets = std::unique_ptr<Bucket[]>(new Bucket[count]);
+	m_BucketCount = count;
+	Clear();
+}
+
+void TranspositionTable::Clear() {
+	for (size_t i = 0; i < m_BucketCount; i++) {
+		for (Entry &entry : m_Buckets[i].entries) {
+			entry.check.store(0, std::memory_order_relaxed);
+			entry.data.store(0, std::memory_order_relaxed);
+		}
+	}
+	m_Age = 0;
+}
+
+void TranspositionTable::NewSearch() { m_Age = (m_Age + 1) & 63; }
+
+bool TranspositionTable::Probe(uint64_t key, TTEntry &entry) const {
+	for (const Entry &slot : GetBucket(key).entries) {
+		uint64_t data = slot.data.load(std::memory_order_relaxed);
+		uint64_t check = slot.check.load(std::memory_order_relaxed);
+		if ((check ^ data) == key && data) {
+			entry = Unpack(data);
+			return true;
+		}
+	}
+	return false;
+}
+
+void TranspositionTable::Store(
+	uint64_t key, BoardMove move, int score, int eval, int depth, Bound bound
+) {
+	Bucket &bucket = GetBucket(key);
+
+	// the same position keeps its slot, and its best move when the new
+	// result doesn't have one
+	Entry *target = nullptr;
+	for (Entry &slot : bucket.entries) {
+		uint64_t data = slot.data.load(std::memory_order_relaxed);
+		if ((slot.check.load(std::memory_order_relaxed) ^ data) == key &&
+		    data) {
+			if (move.IsNull())
+				move = Unpack(data).move;
+			target = &slot;
+			break;
+		}
+	}
+
+	if (!target) {
+		// the least valuable of the depth-preferred slots: every search
+		// generation of age counts as much as 8 plies of depth
+		int worstValue = 1 << 30;
+		for (int i = 0; i < DepthPreferredSlots; i++) {
+			uint64_t data = bucket.entries[i].data.load(std::memory_order_relaxed);
+			int value = data ? GetDepth(data) -
+			                       8 * ((m_Age - GetAge(data)) & 63)
+			                 : -(1 << 20);
+			if (value < worstValue) {
+				worstValue = value;
+				target = &bucket.entries[i];
+			}
+		}
+
+		// not worth more than what is there, keep it in the always-replace
+		// slot instead
+		uint64_t data = target->data.load(std::memory_order_relaxed);
+		if (data && GetAge(data) == m_Age && GetDepth(data) > depth)
+			target = &bucket.entries[BucketSize - 1];
+	}
+
+	uint64_t data = Pack(move, score, eval, depth, bound, m_Age);
+	target->check.store(key ^ data, std::memory_order_relaxed);
+	target->data.store(data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::Prefetch(uint64_t key) const {
+#if defined(_MSC_VER)
+	_mm_prefetch((const char *) &GetBucket(key), _MM_HINT_T0);
+#else
+	__builtin_prefetch(&GetBucket(key));
+#endif
+}
+
+int TranspositionTable::GetFillRate() const {
+	// the first thousand buckets are as good a sample as any
+	size_t buckets = std::min<size_t>(m_BucketCount, 1000);
+	int used = 0;
+	for (size_t i = 0; i < buckets; i++) {
+		for (const Entry &slot : m_Buckets[i].entries) {
+			uint64_t data = slot.data.load(std::memory_order_relaxed);
+			if (data && GetAge(data) == m_Age)
+				used++;
+		}
+	}
+	return (int) (used * 1000 / (buckets * BucketSize));
+}
+
+int TranspositionTable::ScoreToTT(int score, int ply) {
+	if (score >= Search::MateScore - Search::MaxPly)
+		return score + ply;
+	if (score <= -Search::MateScore + Search::MaxPly)
+		return score - ply;
+	return score;
+}
+
+int TranspositionTable::ScoreFromTT(int score, int ply) {
+	if (score >= Search::MateScore - Search::MaxPly)
+		return score - ply;
+	if (score <= -Search::MateScore + Search::MaxPly)
+		return score + ply;
+	return score;
+}
+
+uint64_t TranspositionTable::Pack(
+	BoardMove move, int score, int eval, int depth, Bound bound, int age
+) {
+	return (uint64_t) move.data | ((uint64_t) (uint16_t) score << 16) |
+	       ((uint64_t) (uint16_t) eval << 32) |
+	       ((uint64_t) (uint8_t) depth << 48) | ((uint64_t) bound << 56) |
+	       ((uint64_t) age << 58);
+}
+
+TTEntry TranspositionTable::Unpack(uint64_t data) {
+	TTEntry entry;
+	entry.move.data = (uint16_t) data;
+	entry.score = (int16_t) (data >> 16);
+	entry.eval = (int16_t) (data >> 32);
+	entry.depth = GetDepth(data);
+	entry.bound = (Bound) ((data >> 56) & 3);
+	return entry;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "Board/BoardState.h"
+
+// what a stored score says about the real score of the position
+enum Bound : uint8_t {
+	NoBound = 0,
+	UpperBound = 1, // failed low, real score <= score
+	LowerBound = 2, // failed high, real score >= score
+	ExactBound = 3
+};
+
+struct TTEntry {
+	BoardMove move;
+	int16_t score;
+	int16_t eval;
+	int8_t depth;
+	Bound bound;
+};
+
+// Hash table of search results shared by every search thread without
+// locks. Entries are 16 bytes (the key xored with the data, then the
+// data), so a torn write from two threads at once just fails the key check
+// on the next probe. Four entries make one cache line sized bucket: three
+// depth-preferred slots, where the least valuable (shallow or from an old
+// search) entry gets replaced, and one always-replace slot for whatever
+// didn't deserve a spot in those.
+class TranspositionTable
+{
+public:
+	explicit TranspositionTable(size_t megabytes = 16);
+
+	// drops every entry
+	void Resize(size_t megabytes);
+
+	void Clear();
+
+	// call once at the start of every search, entries of older searches
+	// get replaced first
+	void NewSearch();
+
+	// false if the position isn't in the table
+	bool Probe(uint64_t key, TTEntry &entry) const;
+
+	void Store(
+		uint64_t key, BoardMove move, int score, int eval, int depth,
+		Bound bound
+	);
+
+	// pull the bucket of key into the cache ahead of the probe
+	void Prefetch(uint64_t key) const;
+
+	// per mille of sampled slots used by the current search, uci hashfull
+	int GetFillRate() const;
+
+	inline size_t GetSizeMegabytes() const {
+		return m_BucketCount * sizeof(Bucket) / (1024 * 1024);
+	}
+
+	// mate scores are stored relative to the node instead of the root
+	static int ScoreToTT(int score, int ply);
+
+	static int ScoreFromTT(int score, int ply);
+
+private:
+	static constexpr int BucketSize = 4;
+	static constexpr int DepthPreferredSlots = 3;
+
+	struct Entry {
+		std::atomic<uint64_t> check;
+		std::atomic<uint64_t> data;
+	};
+
+	struct alignas(64) Bucket {
+		Entry entries[BucketSize];
+	};
+
+	inline Bucket &GetBucket(uint64_t key) const {
+		return m_Buckets[key & (m_BucketCount - 1)];
+	}
+
+	static uint64_t Pack(
+		BoardMove move, int score, int eval, int depth, Bound bound, int age
+	);
+
+	static TTEntry Unpack(uint64_t data);
+
+	static inline int GetAge(uint64_t data) { return (data >> 58) & 63; }
+
+	static inline int GetDepth(uint64_t data) { return (int8_t) (data >> 48); }
+
+private:
+	std::unique_ptr<Bucket[]> m_Buckets;
+	// always a power of two
+	size_t m_BucketCount = 0;
+	uint8_t m_Age = 0;
+};
@@ -0,0 +1,69 @@
+#include "EnginePool.h"
+
+#include <algorithm>
+
+#include "Search/Search.h"
+
+EnginePool::EnginePool(int threads, std::function<void()> onReply)
+	: m_OnReply(std::move(onReply)) {
+	for (int i = 0; i < std::max(threads, 1); i++)
+		m_Workers.emplace_back(&EnginePool::RunWorker, this);
+}
+
+EnginePool::~EnginePool() {
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Quit = true;
+	}
+	m_WorkAvailable.notify_all();
+	for (std::thread &worker : m_Workers) worker.join();
+}
+
+void EnginePool::Submit(
+	uint32_t game, int ply, const BoardState &state, uint64_t nodes
+) {
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Requests.push_back({game, ply, state, nodes});
+	}
+	m_WorkAvailable.notify_one();
+}
+
+void EnginePool::TakeReplies(std::vector<Reply> &replies) {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	replies.insert(replies.end(), m_Replies.begin(), m_Replies.end());
+	m_Replies.clear();
+}
+
+size_t EnginePool::GetBacklog() {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Requests.size();
+}
+
+void EnginePool::RunWorker() {
+	Search search;
+
+	while (true) {
+		Request request;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_WorkAvailable.wait(lock, [&] {
+				return m_Quit || !m_Requests.empty();
+			});
+			if (m_Quit)
+				return;
+			request = std::move(m_Requests.front());
+			m_Requests.pop_front();
+		}
+
+		SearchLimits limits;
+		limits.nodes = request.nodes;
+		BoardMove move = search.Think(request.state, limits);
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Replies.push_back({request.game, request.ply, move});
+		}
+		m_OnReply();
+	}
+}
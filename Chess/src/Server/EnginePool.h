@@ -0,0 +1,64 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Board/BoardState.h"
+
+// Worker threads that find moves for the engine side of server games, each
+// with a Search (and table) of its own. Requests are served in the order
+// they came in, and finished moves are collected until the owner takes
+// them: onReply is called from a worker after each one so the owner can
+// wake up (and should do nothing else).
+class EnginePool
+{
+public:
+	struct Reply {
+		uint32_t game = 0;
+		// the ply of the position it was asked about, so a move for a game
+		// that went on (or ended and was reused) is recognised
+		int ply = 0;
+		BoardMove move;
+	};
+
+public:
+	EnginePool(int threads, std::function<void()> onReply);
+
+	~EnginePool();
+
+	// searches state for nodes nodes
+	void Submit(
+		uint32_t game, int ply, const BoardState &state, uint64_t nodes
+	);
+
+	// appends every move found since the last call
+	void TakeReplies(std::vector<Reply> &replies);
+
+	// requests still waiting for a worker
+	size_t GetBacklog();
+
+private:
+	struct Request {
+		uint32_t game;
+		int ply;
+		BoardState state;
+		uint64_t nodes;
+	};
+
+	void RunWorker();
+
+private:
+	std::vector<std::thread> m_Workers;
+	std::function<void()> m_OnReply;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkAvailable;
+	std::deque<Request> m_Requests;
+	std::vector<Reply> m_Replies;
+	bool m_Quit = false;
+};
@@ -0,0 +1,524 @@
+#include "GameServer.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+#include "Sockets.h"
+#include "WebSocket.h"
+
+namespace
+{
+	// epoll data of the listening socket and the wake up eventfd,
+	// connections use their id (from 1)
+	constexpr uint64_t ListenEvent = 0;
+	constexpr uint64_t WakeEvent = ~0ull;
+
+	constexpr int MaxEvents = 256;
+
+	// the first word of args, which is left with the rest
+	std::string_view NextWord(std::string_view &args) {
+		size_t start = args.find_first_not_of(' ');
+		if (start == std::string_view::npos) {
+			args = {};
+			return {};
+		}
+		size_t end = args.find(' ', start);
+		std::string_view word = args.substr(start, end - start);
+		args = end == std::string_view::npos ? std::string_view{}
+		                                     : args.substr(end + 1);
+		return word;
+	}
+
+	template<typename T>
+	bool ParseNumber(std::string_view str, T &value) {
+		auto [end, error] =
+			std::from_chars(str.data(), str.data() + str.size(), value);
+		return error == std::errc() && end == str.data() + str.size();
+	}
+
+	const char *ColorName(Color color) {
+		return color == White ? "white" : "black";
+	}
+} // namespace
+
+GameServer::GameServer(int engineThreads) {
+	m_EpollFd = epoll_create1(0);
+	m_WakeFd = eventfd(0, EFD_NONBLOCK);
+	m_Engines = std::make_unique<EnginePool>(engineThreads, [this] {
+		uint64_t one = 1;
+		(void) !write(m_WakeFd, &one, sizeof(one));
+	});
+
+	epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.u64 = WakeEvent;
+	epoll_ctl(m_EpollFd, EPOLL_CTL_ADD, m_WakeFd, &event);
+}
+
+GameServer::~GameServer() {
+	// the workers write to m_WakeFd until they are joined
+	m_Engines.reset();
+	for (auto &[id, connection] : m_Connections) close(connection.fd);
+	if (m_ListenFd != -1)
+		close(m_ListenFd);
+	close(m_EpollFd);
+	close(m_WakeFd);
+}
+
+bool GameServer::Listen(uint16_t port) {
+	m_ListenFd = Sockets::Listen(port, SOMAXCONN);
+	if (m_ListenFd == -1)
+		return false;
+
+	epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.u64 = ListenEvent;
+	epoll_ctl(m_EpollFd, EPOLL_CTL_ADD, m_ListenFd, &event);
+	return true;
+}
+
+void GameServer::Run() {
+	using namespace std::chrono;
+
+	m_Running = true;
+	auto nextStats = steady_clock::now() + milliseconds(StatsIntervalMs);
+	epoll_event events[MaxEvents];
+	while (m_Running) {
+		int count = epoll_wait(m_EpollFd, events, MaxEvents, StatsIntervalMs);
+		if (count == -1 && errno != EINTR) {
+			std::cout << "epoll_wait: " << std::strerror(errno) << std::endl;
+			break;
+		}
+
+		for (int i = 0; i < count; i++) {
+			uint64_t id = events[i].data.u64;
+			if (id == ListenEvent) {
+				Accept();
+				continue;
+			}
+			if (id == WakeEvent) {
+				uint64_t value;
+				(void) !read(m_WakeFd, &value, sizeof(value));
+				PlayEngineMoves();
+				continue;
+			}
+
+			auto it = m_Connections.find(id);
+			if (it == m_Connections.end() || it->second.dropped)
+				continue;
+			// a hang up still has to have its last input read
+			if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+				OnReadable(it->second);
+			if ((events[i].events & EPOLLOUT) && !it->second.dropped)
+				OnWritable(it->second);
+		}
+
+		for (uint64_t id : m_Dropped) {
+			auto it = m_Connections.find(id);
+			if (it != m_Connections.end())
+				Close(it->second);
+		}
+		m_Dropped.clear();
+
+		if (steady_clock::now() >= nextStats) {
+			PrintStats();
+			nextStats = steady_clock::now() + milliseconds(StatsIntervalMs);
+		}
+	}
+}
+
+void GameServer::Stop() {
+	m_Running = false;
+	uint64_t one = 1;
+	(void) !write(m_WakeFd, &one, sizeof(one));
+}
+
+void GameServer::Accept() {
+	while (true) {
+		int fd = accept4(m_ListenFd, nullptr, nullptr, SOCK_NONBLOCK);
+		if (fd == -1) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			// out of file descriptors: the rest waits in the backlog
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				std::cout << "accept: " << std::strerror(errno) << std::endl;
+			return;
+		}
+		Sockets::SetNoDelay(fd);
+
+		uint64_t id = m_NextConnection++;
+		Connection &connection = m_Connections[id];
+		connection.id = id;
+		connection.fd = fd;
+
+		epoll_event event = {};
+		event.events = EPOLLIN;
+		event.data.u64 = id;
+		epoll_ctl(m_EpollFd, EPOLL_CTL_ADD, fd, &event);
+	}
+}
+
+void GameServer::OnReadable(Connection &connection) {
+	char buffer[4096];
+	while (true) {
+		ssize_t read = recv(connection.fd, buffer, sizeof(buffer), 0);
+		if (read > 0) {
+			connection.input.append(buffer, (size_t) read);
+			continue;
+		}
+		if (read == -1 && errno == EINTR)
+			continue;
+		if (read == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		// closed by the other side, or broken
+		Drop(connection);
+		return;
+	}
+
+	if (!ReadMessages(connection))
+		Drop(connection);
+}
+
+void GameServer::OnWritable(Connection &connection) { Flush(connection); }
+
+bool GameServer::ReadMessages(Connection &connection) {
+	std::string &input = connection.input;
+
+	if (connection.protocol == Unknown) {
+		// websocket clients open with an http GET, anything else talks in
+		// lines
+		std::string_view get = "GET ";
+		size_t prefix = std::min(input.size(), get.size());
+		if (input.compare(0, prefix, get, 0, prefix) != 0)
+			connection.protocol = Lines;
+		else if (input.size() < get.size())
+			return true;
+		else {
+			std::string response;
+			long used = WebSocket::AcceptHandshake(input, response);
+			if (used == 0)
+				return input.size() <= MaxMessageSize;
+			if (used < 0)
+				return false;
+			input.erase(0, (size_t) used);
+			connection.output += response;
+			connection.protocol = WebSocketFrames;
+			Flush(connection);
+		}
+	}
+
+	size_t start = 0;
+	if (connection.protocol == Lines) {
+		size_t end;
+		while (!connection.dropped &&
+		       (end = input.find('\n', start)) != std::string::npos) {
+			std::string_view line(input.data() + start, end - start);
+			if (!line.empty() && line.back() == '\r')
+				line.remove_suffix(1);
+			if (!line.empty())
+				HandleMessage(connection, line);
+			start = end + 1;
+		}
+	} else {
+		WebSocket::Frame frame;
+		while (!connection.dropped && !connection.closing) {
+			long used = WebSocket::ParseFrame(
+				std::string_view(input).substr(start), frame, MaxMessageSize
+			);
+			if (used < 0)
+				return false;
+			if (used == 0)
+				break;
+			start += (size_t) used;
+
+			switch (frame.opcode) {
+			case WebSocket::Text:
+			case WebSocket::Continuation:
+				connection.fragments += frame.payload;
+				if (connection.fragments.size() > MaxMessageSize)
+					return false;
+				if (frame.final) {
+					std::string message = std::move(connection.fragments);
+					connection.fragments.clear();
+					HandleMessage(connection, message);
+				}
+				break;
+			case WebSocket::Ping:
+				WebSocket::AppendFrame(
+					connection.output, WebSocket::Pong, frame.payload
+				);
+				Flush(connection);
+				break;
+			case WebSocket::Close:
+				// answered with the same status, then the connection goes
+				WebSocket::AppendFrame(
+					connection.output, WebSocket::Close,
+					std::string_view(frame.payload).substr(0, 2)
+				);
+				connection.closing = true;
+				Flush(connection);
+				break;
+			case WebSocket::Pong:
+				break;
+			default:
+				return false;
+			}
+		}
+	}
+
+	input.erase(0, start);
+	return input.size() <= MaxMessageSize;
+}
+
+void GameServer::HandleMessage(
+	Connection &connection, std::string_view message
+) {
+	std::string_view args = message;
+	std::string_view command = NextWord(args);
+
+	if (command == "new")
+		HandleNew(connection, args);
+	else if (command == "join")
+		HandleJoin(connection, args);
+	else if (command == "move")
+		HandleMove(connection, args);
+	else if (command == "resign") {
+		auto it = m_Games.find(connection.game);
+		if (it == m_Games.end()) {
+			Send(connection, "error no game");
+			return;
+		}
+		it->second.game.Forfeit(connection.color, ServerGame::Resignation);
+		EndGame(it->second);
+	} else if (command == "quit") {
+		connection.closing = true;
+		Flush(connection);
+	} else
+		Send(connection, "error unknown command " + std::string(command));
+}
+
+void GameServer::HandleNew(Connection &connection, std::string_view args) {
+	if (connection.game) {
+		Send(connection, "error already in a game");
+		return;
+	}
+
+	uint32_t id = m_NextGame++;
+	Game &game = m_Games[id];
+	game.id = id;
+
+	Color color = White;
+	for (std::string_view word = NextWord(args); !word.empty();
+	     word = NextWord(args)) {
+		if (word == "white" || word == "black")
+			color = word == "white" ? White : Black;
+		else if (word == "engine")
+			game.hasEngine = true;
+		else if (game.hasEngine && ParseNumber(word, game.engineNodes))
+			game.engineNodes =
+				std::clamp<uint64_t>(game.engineNodes, 1, MaxEngineNodes);
+	}
+
+	game.players[color] = connection.id;
+	connection.game = id;
+	connection.color = color;
+	Send(
+		connection, "game " + std::to_string(id) + " " + ColorName(color)
+	);
+
+	if (game.hasEngine) {
+		game.engineColor = (Color) !color;
+		game.started = true;
+		AfterMove(game);
+	}
+}
+
+void GameServer::HandleJoin(Connection &connection, std::string_view args) {
+	uint32_t id = 0;
+	ParseNumber(NextWord(args), id);
+	auto it = m_Games.find(id);
+	if (connection.game || it == m_Games.end() || it->second.started) {
+		Send(connection, "error can't join");
+		return;
+	}
+
+	Game &game = it->second;
+	Color color = game.players[White] ? Black : White;
+	game.players[color] = connection.id;
+	game.started = true;
+	connection.game = id;
+	connection.color = color;
+	Send(
+		connection, "game " + std::to_string(id) + " " + ColorName(color)
+	);
+	Send(game.players[!color], "joined " + std::to_string(id));
+}
+
+void GameServer::HandleMove(Connection &connection, std::string_view args) {
+	auto it = m_Games.find(connection.game);
+	if (it == m_Games.end() || !it->second.started) {
+		Send(connection, "error no game");
+		return;
+	}
+	Game &game = it->second;
+	if (game.game.GetState().GetTurn() != connection.color) {
+		Send(connection, "error not your turn");
+		return;
+	}
+
+	std::string_view uci = NextWord(args);
+	BoardMove move;
+	if (!game.game.PlayMove(uci, move)) {
+		Send(connection, "illegal " + std::string(uci));
+		return;
+	}
+	m_MovesPlayed++;
+
+	Send(connection, "ok " + std::string(uci));
+	if (uint64_t opponent = game.players[!connection.color])
+		Send(opponent, "move " + std::string(uci));
+	AfterMove(game);
+}
+
+void GameServer::PlayEngineMoves() {
+	m_Replies.clear();
+	m_Engines->TakeReplies(m_Replies);
+	for (const EnginePool::Reply &reply : m_Replies) {
+		auto it = m_Games.find(reply.game);
+		// the game ended (someone resigned or left) while it searched
+		if (it == m_Games.end() || it->second.game.GetPly() != reply.ply ||
+		    reply.move.IsNull())
+			continue;
+
+		Game &game = it->second;
+		game.game.PlayMove(reply.move);
+		m_MovesPlayed++;
+		Send(
+			game.players[!game.engineColor], "move " + reply.move.ToString()
+		);
+		AfterMove(game);
+	}
+}
+
+void GameServer::AfterMove(Game &game) {
+	if (game.game.IsOver())
+		EndGame(game);
+	else if (game.hasEngine &&
+	         game.game.GetState().GetTurn() == game.engineColor)
+		m_Engines->Submit(
+			game.id, game.game.GetPly(), game.game.GetState(), game.engineNodes
+		);
+}
+
+void GameServer::EndGame(Game &game) {
+	std::string message =
+		std::string("end ") + ServerGame::ToString(game.game.GetResult()) +
+		" " + ServerGame::ToString(game.game.GetEndReason());
+	for (uint64_t player : game.players) {
+		auto it = m_Connections.find(player);
+		if (it == m_Connections.end())
+			continue;
+		it->second.game = 0;
+		Send(it->second, message);
+	}
+
+	m_GamesFinished++;
+	m_Games.erase(game.id);
+}
+
+void GameServer::Send(Connection &connection, std::string_view message) {
+	if (connection.dropped)
+		return;
+	if (connection.protocol == WebSocketFrames)
+		WebSocket::AppendFrame(connection.output, WebSocket::Text, message);
+	else {
+		connection.output += message;
+		connection.output += '\n';
+	}
+	Flush(connection);
+}
+
+void GameServer::Send(uint64_t connection, std::string_view message) {
+	auto it = m_Connections.find(connection);
+	if (it != m_Connections.end())
+		Send(it->second, message);
+}
+
+void GameServer::Flush(Connection &connection) {
+	std::string &output = connection.output;
+	size_t sent = 0;
+	while (sent < output.size()) {
+		ssize_t written = send(
+			connection.fd, output.data() + sent, output.size() - sent,
+			MSG_NOSIGNAL
+		);
+		if (written >= 0)
+			sent += (size_t) written;
+		else if (errno == EAGAIN || errno == EWOULDBLOCK)
+			break;
+		else if (errno != EINTR) {
+			Drop(connection);
+			return;
+		}
+	}
+	output.erase(0, sent);
+
+	WatchWrites(connection, !output.empty());
+	if (output.empty() && connection.closing)
+		Drop(connection);
+}
+
+void GameServer::WatchWrites(Connection &connection, bool watch) {
+	if (connection.watchingWrites == watch)
+		return;
+	connection.watchingWrites = watch;
+
+	epoll_event event = {};
+	event.events = EPOLLIN | (watch ? (uint32_t) EPOLLOUT : 0);
+	event.data.u64 = connection.id;
+	epoll_ctl(m_EpollFd, EPOLL_CTL_MOD, connection.fd, &event);
+}
+
+void GameServer::Drop(Connection &connection) {
+	if (connection.dropped)
+		return;
+	connection.dropped = true;
+	connection.output.clear();
+	m_Dropped.push_back(connection.id);
+}
+
+void GameServer::Close(Connection &connection) {
+	auto it = m_Games.find(connection.game);
+	if (it != m_Games.end()) {
+		Game &game = it->second;
+		game.players[connection.color] = 0;
+		if (game.started) {
+			game.game.Forfeit(connection.color, ServerGame::Disconnect);
+			EndGame(game);
+		} else
+			m_Games.erase(it);
+	}
+
+	epoll_ctl(m_EpollFd, EPOLL_CTL_DEL, connection.fd, nullptr);
+	close(connection.fd);
+	m_Connections.erase(connection.id);
+}
+
+void GameServer::PrintStats() {
+	uint64_t moves = m_MovesPlayed - m_MovesAtLastStats;
+	m_MovesAtLastStats = m_MovesPlayed;
+	std::cout << "connections " << m_Connections.size() << ", games "
+			  << m_Games.size() << ", finished " << m_GamesFinished
+			  << ", moves/s " << moves * 1000 / StatsIntervalMs
+			  << ", engine backlog " << m_Engines->GetBacklog() << std::endl;
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "EnginePool.h"
+#include "ServerGame.h"
+
+// Headless game server: one thread running an epoll loop over every
+// connection, plus the engine pool. Clients talk in lines of text, either
+// straight over TCP (one message per line) or as websocket text messages
+// (a connection opening with an http GET gets upgraded). Messages:
+//
+//   new [white|black] [engine [nodes]]  start a game, against the engine
+//                                       or waiting for someone to join
+//   join <game>                         take the free side of a game
+//   move <uci>                          play a move in your game
+//   resign
+//
+// and the server answers with "game <id> <color>" (to whoever created or
+// joined), "joined <id>" (to the creator), "ok <uci>" (the move was
+// played, this is the move ack), "illegal <uci>", "move <uci>" (the
+// opponent's move), "end <result> <reason>" and "error <why>".
+class GameServer
+{
+public:
+	static constexpr uint16_t DefaultPort = 7777;
+
+	// nodes an engine opponent searches per move unless the game asks for
+	// something else, and the most it can ask for
+	static constexpr uint64_t DefaultEngineNodes = 10000;
+	static constexpr uint64_t MaxEngineNodes = 1000000;
+
+	// a connection sending more than this without completing a message is
+	// dropped
+	static constexpr size_t MaxMessageSize = 4096;
+
+	// how often Run prints the number of connections, games and moves
+	static constexpr int StatsIntervalMs = 10000;
+
+public:
+	explicit GameServer(int engineThreads);
+
+	~GameServer();
+
+	// false (after printing why) if the port can't be listened on
+	bool Listen(uint16_t port);
+
+	// serves until Stop is called
+	void Run();
+
+	// can be called from any thread, and from a signal handler
+	void Stop();
+
+private:
+	enum Protocol : uint8_t { Unknown, Lines, WebSocketFrames };
+
+	struct Connection {
+		uint64_t id = 0;
+		int fd = -1;
+		Protocol protocol = Unknown;
+		std::string input;
+		std::string output;
+		// text of a fragmented websocket message so far
+		std::string fragments;
+		uint32_t game = 0;
+		Color color = White;
+		// whether epoll watches for the socket to become writable
+		bool watchingWrites = false;
+		// close once the output is out
+		bool closing = false;
+		// closed after the current batch of events
+		bool dropped = false;
+	};
+
+	struct Game {
+		uint32_t id = 0;
+		ServerGame game;
+		// connection ids of the players, 0 for the engine or a free side
+		uint64_t players[2] = {0, 0};
+		bool hasEngine = false;
+		Color engineColor = Black;
+		uint64_t engineNodes = DefaultEngineNodes;
+		bool started = false;
+	};
+
+	void Accept();
+
+	void OnReadable(Connection &connection);
+
+	void OnWritable(Connection &connection);
+
+	// splits the input into messages by the connection's protocol, false
+	// if the connection has to go
+	bool ReadMessages(Connection &connection);
+
+	void HandleMessage(Connection &connection, std::string_view message);
+
+	void HandleNew(Connection &connection, std::string_view args);
+
+	void HandleJoin(Connection &connection, std::string_view args);
+
+	void HandleMove(Connection &connection, std::string_view args);
+
+	// plays the moves the engine pool found since the last call
+	void PlayEngineMoves();
+
+	// after a move: hands it to the engine if it is its turn, or ends the
+	// game if it is over
+	void AfterMove(Game &game);
+
+	// tells both players and forgets the game
+	void EndGame(Game &game);
+
+	void Send(Connection &connection, std::string_view message);
+
+	void Send(uint64_t connection, std::string_view message);
+
+	// writes what it can, the rest once the socket is writable
+	void Flush(Connection &connection);
+
+	void WatchWrites(Connection &connection, bool watch);
+
+	// closes the connection once the current batch of events is handled,
+	// so that nothing handling them is left with a dangling reference
+	void Drop(Connection &connection);
+
+	// leaves its game (losing it if it was going on), closes the socket
+	// and forgets the connection
+	void Close(Connection &connection);
+
+	void PrintStats();
+
+private:
+	int m_ListenFd = -1;
+	int m_EpollFd = -1;
+	// written by Stop and by the engine pool to wake the loop up
+	int m_WakeFd = -1;
+	std::atomic<bool> m_Running = false;
+
+	std::unordered_map<uint64_t, Connection> m_Connections;
+	uint64_t m_NextConnection = 1;
+	std::vector<uint64_t> m_Dropped;
+	std::unordered_map<uint32_t, Game> m_Games;
+	uint32_t m_NextGame = 1;
+
+	std::unique_ptr<EnginePool> m_Engines;
+	std::vector<EnginePool::Reply> m_Replies;
+
+	uint64_t m_MovesPlayed = 0;
+	uint64_t m_GamesFinished = 0;
+	uint64_t m_MovesAtLastStats = 0;
+};
@@ -0,0 +1,381 @@
+#include "LoadTest.h"
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <iomanip>
+#include <iostream>
+
+#include "Sockets.h"
+#include "WebSocket.h"
+
+namespace
+{
+	constexpr int MaxEvents = 256;
+
+	// the first word of args, which is left with the rest
+	std::string_view NextWord(std::string_view &args) {
+		size_t start = args.find_first_not_of(' ');
+		if (start == std::string_view::npos) {
+			args = {};
+			return {};
+		}
+		size_t end = args.find(' ', start);
+		std::string_view word = args.substr(start, end - start);
+		args = end == std::string_view::npos ? std::string_view{}
+		                                     : args.substr(end + 1);
+		return word;
+	}
+} // namespace
+
+LoadTest::LoadTest(const LoadTestOptions &options) : m_Options(options) {
+	m_EpollFd = epoll_create1(0);
+}
+
+LoadTest::~LoadTest() {
+	for (Client &client : m_Clients)
+		if (!client.closed && client.fd != -1)
+			close(client.fd);
+	close(m_EpollFd);
+}
+
+bool LoadTest::Run() {
+	using namespace std::chrono;
+
+	// in pairs the odd clients only ever join their even neighbour
+	int clients = m_Options.clients;
+	if (!m_Options.engineNodes)
+		clients += clients & 1;
+	m_Clients.resize(clients);
+	m_Latencies.reserve(1 << 20);
+
+	for (size_t i = 0; i < m_Clients.size(); i++) {
+		Client &client = m_Clients[i];
+		client.fd = Sockets::Connect(m_Options.host, m_Options.port);
+		if (client.fd == -1) {
+			client.closed = true;
+			m_ConnectFailures++;
+			continue;
+		}
+		epoll_event event = {};
+		event.events = EPOLLIN | EPOLLOUT;
+		event.data.u64 = i;
+		epoll_ctl(m_EpollFd, EPOLL_CTL_ADD, client.fd, &event);
+		client.watchingWrites = true;
+	}
+	if (m_ConnectFailures == m_Clients.size()) {
+		std::cout << "can't connect to " << m_Options.host << ":"
+				  << m_Options.port << std::endl;
+		return false;
+	}
+
+	Clock::time_point start = Clock::now();
+	Clock::time_point end = start + seconds(m_Options.seconds);
+	epoll_event events[MaxEvents];
+	while (Clock::now() < end) {
+		int timeout = m_Options.thinkMs ? 1 : 100;
+		int count = epoll_wait(m_EpollFd, events, MaxEvents, timeout);
+		for (int i = 0; i < count; i++) {
+			size_t index = events[i].data.u64;
+			Client &client = m_Clients[index];
+			if (client.closed)
+				continue;
+			if (!client.connected) {
+				OnConnected(index);
+				continue;
+			}
+			if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+				OnReadable(index);
+			if ((events[i].events & EPOLLOUT) && !client.closed)
+				Flush(index);
+		}
+
+		if (m_Options.thinkMs) {
+			Clock::time_point now = Clock::now();
+			for (size_t i = 0; i < m_Clients.size(); i++)
+				if (m_Clients[i].moveDue && m_Clients[i].moveAt <= now) {
+					m_Clients[i].moveDue = false;
+					PlayMove(i);
+				}
+		}
+	}
+
+	PrintResults(duration<double>(Clock::now() - start).count());
+	return true;
+}
+
+void LoadTest::OnConnected(size_t index) {
+	Client &client = m_Clients[index];
+	int error = 0;
+	socklen_t length = sizeof(error);
+	getsockopt(client.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+	if (error) {
+		m_ConnectFailures++;
+		client.closed = true;
+		close(client.fd);
+		return;
+	}
+	client.connected = true;
+
+	if (m_Options.webSocket) {
+		uint8_t key[16];
+		for (uint8_t &byte : key) byte = (uint8_t) NextRandom();
+		client.key = WebSocket::Base64(key, sizeof(key));
+		// ahead of a join its partner may have queued already
+		client.output.insert(
+			0, WebSocket::MakeHandshake(m_Options.host, client.key)
+		);
+		client.upgrading = true;
+		Flush(index);
+	} else if (m_Options.engineNodes || index % 2 == 0)
+		StartGame(index);
+	else
+		Flush(index);
+}
+
+void LoadTest::OnReadable(size_t index) {
+	Client &client = m_Clients[index];
+	char buffer[4096];
+	while (true) {
+		ssize_t read = recv(client.fd, buffer, sizeof(buffer), 0);
+		if (read > 0) {
+			client.input.append(buffer, (size_t) read);
+			continue;
+		}
+		if (read == -1 && errno == EINTR)
+			continue;
+		if (read == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		Fail(index);
+		return;
+	}
+
+	std::string &input = client.input;
+	size_t start = 0;
+	if (client.upgrading) {
+		long used = WebSocket::ReadHandshakeResponse(input, client.key);
+		if (used < 0) {
+			Fail(index);
+			return;
+		}
+		if (used == 0)
+			return;
+		start = (size_t) used;
+		client.upgrading = false;
+		if (m_Options.engineNodes || index % 2 == 0)
+			StartGame(index);
+	}
+
+	if (!m_Options.webSocket) {
+		size_t end;
+		while (!client.closed &&
+		       (end = input.find('\n', start)) != std::string::npos) {
+			HandleMessage(
+				index, std::string_view(input.data() + start, end - start)
+			);
+			start = end + 1;
+		}
+	} else {
+		WebSocket::Frame frame;
+		while (!client.closed) {
+			long used = WebSocket::ParseFrame(
+				std::string_view(input).substr(start), frame, 1 << 16
+			);
+			if (used < 0) {
+				Fail(index);
+				return;
+			}
+			if (used == 0)
+				break;
+			start += (size_t) used;
+			if (frame.opcode == WebSocket::Text)
+				HandleMessage(index, frame.payload);
+		}
+	}
+	if (!client.closed)
+		input.erase(0, start);
+}
+
+void LoadTest::HandleMessage(size_t index, std::string_view message) {
+	Client &client = m_Clients[index];
+	std::string_view args = message;
+	std::string_view command = NextWord(args);
+
+	if (command == "ok") {
+		if (client.awaitingAck) {
+			auto latency = std::chrono::duration_cast<
+				std::chrono::microseconds>(Clock::now() - client.sentAt);
+			m_Latencies.push_back((uint32_t) latency.count());
+			client.awaitingAck = false;
+		}
+	} else if (command == "move") {
+		BoardMove move;
+		if (!client.game.PlayMove(NextWord(args), move)) {
+			m_Errors++;
+			return;
+		}
+		ScheduleMove(index);
+	} else if (command == "game") {
+		std::string_view id = NextWord(args);
+		client.game = ServerGame();
+		client.inGame = true;
+		client.color = NextWord(args) == "white" ? White : Black;
+		if (m_Options.engineNodes)
+			ScheduleMove(index);
+		else if (index % 2 == 0)
+			Send(index + 1, "join " + std::string(id));
+	} else if (command == "joined")
+		ScheduleMove(index);
+	else if (command == "end") {
+		client.inGame = false;
+		client.awaitingAck = false;
+		client.moveDue = false;
+		// both players of a pair hear about it, count it once
+		if (m_Options.engineNodes || index % 2 == 0) {
+			m_GamesFinished++;
+			StartGame(index);
+		}
+	} else
+		m_Errors++;
+}
+
+void LoadTest::StartGame(size_t index) {
+	if (!m_Options.engineNodes) {
+		Send(index, "new white");
+		return;
+	}
+	const char *color = NextRandom() & 1 ? "white" : "black";
+	Send(
+		index, std::string("new ") + color + " engine " +
+				   std::to_string(m_Options.engineNodes)
+	);
+}
+
+void LoadTest::ScheduleMove(size_t index) {
+	Client &client = m_Clients[index];
+	if (!client.inGame || client.game.IsOver() ||
+	    client.game.GetState().GetTurn() != client.color)
+		return;
+
+	if (!m_Options.thinkMs) {
+		PlayMove(index);
+		return;
+	}
+	client.moveDue = true;
+	client.moveAt =
+		Clock::now() + std::chrono::milliseconds(m_Options.thinkMs);
+}
+
+void LoadTest::PlayMove(size_t index) {
+	Client &client = m_Clients[index];
+	if (!client.inGame || client.closed || client.game.IsOver())
+		return;
+
+	MoveList moves;
+	client.game.GetState().GenerateLegalMoves(moves);
+	if (!moves.size)
+		return;
+	BoardMove move = moves.moves[NextRandom() % moves.size];
+	client.game.PlayMove(move);
+
+	client.awaitingAck = true;
+	client.sentAt = Clock::now();
+	Send(index, "move " + move.ToString());
+}
+
+void LoadTest::Send(size_t index, std::string_view message) {
+	Client &client = m_Clients[index];
+	if (client.closed)
+		return;
+	if (m_Options.webSocket) {
+		// clients have to mask what they send
+		uint32_t mask = (uint32_t) NextRandom() | 1;
+		WebSocket::AppendFrame(client.output, WebSocket::Text, message, mask);
+	} else {
+		client.output += message;
+		client.output += '\n';
+	}
+	// a partner still connecting sends it once it is up
+	if (client.connected)
+		Flush(index);
+}
+
+void LoadTest::Flush(size_t index) {
+	Client &client = m_Clients[index];
+	std::string &output = client.output;
+	size_t sent = 0;
+	while (sent < output.size()) {
+		ssize_t written = send(
+			client.fd, output.data() + sent, output.size() - sent,
+			MSG_NOSIGNAL
+		);
+		if (written >= 0)
+			sent += (size_t) written;
+		else if (errno == EAGAIN || errno == EWOULDBLOCK)
+			break;
+		else if (errno != EINTR) {
+			Fail(index);
+			return;
+		}
+	}
+	output.erase(0, sent);
+
+	bool watch = !output.empty();
+	if (watch == client.watchingWrites)
+		return;
+	client.watchingWrites = watch;
+	epoll_event event = {};
+	event.events = EPOLLIN | (watch ? (uint32_t) EPOLLOUT : 0);
+	event.data.u64 = index;
+	epoll_ctl(m_EpollFd, EPOLL_CTL_MOD, client.fd, &event);
+}
+
+void LoadTest::Fail(size_t index) {
+	Client &client = m_Clients[index];
+	if (client.closed)
+		return;
+	m_Errors++;
+	client.closed = true;
+	epoll_ctl(m_EpollFd, EPOLL_CTL_DEL, client.fd, nullptr);
+	close(client.fd);
+}
+
+void LoadTest::PrintResults(double seconds) const {
+	std::vector<uint32_t> latencies = m_Latencies;
+	std::sort(latencies.begin(), latencies.end());
+	auto percentile = [&](double fraction) {
+		if (latencies.empty())
+			return 0.0;
+		size_t i = (size_t) (fraction * (double) (latencies.size() - 1));
+		return latencies[i] / 1000.0;
+	};
+
+	size_t connected = 0;
+	for (const Client &client : m_Clients)
+		connected += client.connected && !client.closed;
+
+	std::cout << connected << "/" << m_Clients.size() << " clients connected ("
+			  << (m_Options.webSocket ? "websocket" : "lines") << "), "
+			  << m_ConnectFailures << " connect failures, " << m_Errors
+			  << " errors" << std::endl;
+	std::cout << std::fixed << std::setprecision(1) << latencies.size()
+			  << " moves acked in " << seconds << " s, "
+			  << (uint64_t) (latencies.size() / seconds) << " moves/s, "
+			  << m_GamesFinished << " games finished" << std::endl;
+	std::cout << std::setprecision(3)
+			  << "move ack latency ms: p50 " << percentile(0.5) << ", p90 "
+			  << percentile(0.9) << ", p99 " << percentile(0.99)
+			  << ", p99.9 " << percentile(0.999) << ", max "
+			  << percentile(1.0) << std::endl;
+}
+
+// xorshift64*
+uint64_t LoadTest::NextRandom() {
+	m_Random ^= m_Random >> 12;
+	m_Random ^= m_Random << 25;
+	m_Random ^= m_Random >> 27;
+	return m_Random * 0x2545F4914F6CDD1Dull;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ServerGame.h"
+
+struct LoadTestOptions {
+	std::string host = "127.0.0.1";
+	uint16_t port = 7777;
+	int clients = 1000;
+	int seconds = 10;
+	// talk websocket instead of plain lines
+	bool webSocket = false;
+	// every client plays the engine searching this many nodes, 0 has the
+	// clients play each other in pairs
+	uint64_t engineNodes = 0;
+	// how long a client waits before answering a move
+	int thinkMs = 0;
+};
+
+// Client simulator for the game server: opens the given number of
+// connections from one epoll loop, has them play random legal moves (a new
+// game as soon as one ends) and measures the move ack latency, the time
+// from sending a move to reading the server's "ok".
+class LoadTest
+{
+public:
+	explicit LoadTest(const LoadTestOptions &options);
+
+	~LoadTest();
+
+	// runs for options.seconds and prints the results, false if nothing
+	// could connect
+	bool Run();
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Client {
+		int fd = -1;
+		bool connected = false;
+		bool closed = false;
+		// websocket handshake sent, waiting for the answer
+		bool upgrading = false;
+		bool watchingWrites = false;
+		std::string key;
+		std::string input;
+		std::string output;
+		// the client's own copy of its game
+		ServerGame game;
+		bool inGame = false;
+		Color color = White;
+		// a move was sent and is waiting for its ack
+		bool awaitingAck = false;
+		Clock::time_point sentAt;
+		// when to play the next move, if it waits for thinkMs
+		bool moveDue = false;
+		Clock::time_point moveAt;
+	};
+
+	void OnConnected(size_t index);
+
+	void OnReadable(size_t index);
+
+	void HandleMessage(size_t index, std::string_view message);
+
+	// starts a game: as the creator in pair mode, alone against the engine
+	void StartGame(size_t index);
+
+	// plays now or schedules the move after thinkMs, if it is our turn
+	void ScheduleMove(size_t index);
+
+	void PlayMove(size_t index);
+
+	void Send(size_t index, std::string_view message);
+
+	void Flush(size_t index);
+
+	void Fail(size_t index);
+
+	void PrintResults(double seconds) const;
+
+	uint64_t NextRandom();
+
+private:
+	LoadTestOptions m_Options;
+	int m_EpollFd = -1;
+	std::vector<Client> m_Clients;
+	uint64_t m_Random = 0x9E3779B97F4A7C15ull;
+
+	// microseconds from sending a move to its ack
+	std::vector<uint32_t> m_Latencies;
+	uint64_t m_GamesFinished = 0;
+	uint64_t m_Errors = 0;
+	uint64_t m_ConnectFailures = 0;
+};
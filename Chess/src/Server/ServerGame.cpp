@@ -0,0 +1,129 @@
+#include "ServerGame.h"
+
+#include <algorithm>
+
+namespace
+{
+	constexpr const char *StartFen =
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+} // namespace
+
+ServerGame::ServerGame() {
+	m_State.ReadFen(StartFen);
+	m_Keys.push_back(m_State.GetKey());
+}
+
+bool ServerGame::PlayMove(std::string_view move, BoardMove &played) {
+	if (IsOver())
+		return false;
+
+	MoveList moves;
+	m_State.GenerateLegalMoves(moves);
+	for (BoardMove legal : moves)
+		if (legal.ToString() == move) {
+			played = legal;
+			return PlayMove(legal);
+		}
+	return false;
+}
+
+bool ServerGame::PlayMove(BoardMove move) {
+	if (IsOver())
+		return false;
+
+	m_State.MakeMove(move);
+	m_Keys.push_back(m_State.GetKey());
+	DetectEnd();
+	return true;
+}
+
+void ServerGame::Forfeit(Color color, EndReason reason) {
+	if (IsOver())
+		return;
+	m_Result = color == White ? BlackWins : WhiteWins;
+	m_Reason = reason;
+}
+
+const char *ServerGame::ToString(Result result) {
+	switch (result) {
+	case WhiteWins:
+		return "1-0";
+	case BlackWins:
+		return "0-1";
+	case Draw:
+		return "1/2-1/2";
+	default:
+		return "*";
+	}
+}
+
+const char *ServerGame::ToString(EndReason reason) {
+	switch (reason) {
+	case Checkmate:
+		return "checkmate";
+	case Stalemate:
+		return "stalemate";
+	case FiftyMoves:
+		return "fifty-moves";
+	case Repetition:
+		return "repetition";
+	case InsufficientMaterial:
+		return "insufficient-material";
+	case Resignation:
+		return "resignation";
+	case Disconnect:
+		return "disconnect";
+	default:
+		return "none";
+	}
+}
+
+void ServerGame::DetectEnd() {
+	if (m_State.CountLegalMoves() == 0) {
+		if (m_State.IsInCheck()) {
+			// whoever just moved won
+			m_Result = m_State.GetTurn() == White ? BlackWins : WhiteWins;
+			m_Reason = Checkmate;
+		} else {
+			m_Result = Draw;
+			m_Reason = Stalemate;
+		}
+	} else if (m_State.GetHalfMoveClock() >= 100) {
+		m_Result = Draw;
+		m_Reason = FiftyMoves;
+	} else if (IsThreefoldRepetition()) {
+		m_Result = Draw;
+		m_Reason = Repetition;
+	} else if (IsInsufficientMaterial()) {
+		m_Result = Draw;
+		m_Reason = InsufficientMaterial;
+	}
+}
+
+bool ServerGame::IsThreefoldRepetition() const {
+	// only positions since the last capture or pawn move, with the same
+	// side to move, can be the same
+	int last = (int) m_Keys.size() - 1;
+	int first = std::max(last - m_State.GetHalfMoveClock(), 0);
+	int count = 1;
+	for (int i = last - 2; i >= first; i -= 2)
+		if (m_Keys[i] == m_Keys[last] && ++count == 3)
+			return true;
+	return false;
+}
+
+bool ServerGame::IsInsufficientMaterial() const {
+	// a lone king against a king and at most one minor piece
+	int minors = 0;
+	for (Color color : {Black, White}) {
+		if (m_State.GetPieces(color, PawnPiece) ||
+		    m_State.GetPieces(color, RookPiece) ||
+		    m_State.GetPieces(color, QueenPiece))
+			return false;
+		minors += BitBoards::PopCount(
+			m_State.GetPieces(color, KnightPiece) |
+			m_State.GetPieces(color, BishopPiece)
+		);
+	}
+	return minors <= 1;
+}
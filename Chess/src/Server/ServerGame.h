@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "Board/BoardState.h"
+
+// One game on the server: the moves are checked against the legal moves
+// and the end of the game (mate, stalemate, fifty moves, threefold
+// repetition, insufficient material or a resignation) is detected here, so
+// clients can't disagree about either.
+class ServerGame
+{
+public:
+	enum Result : uint8_t { Ongoing, WhiteWins, BlackWins, Draw };
+
+	enum EndReason : uint8_t {
+		NoReason,
+		Checkmate,
+		Stalemate,
+		FiftyMoves,
+		Repetition,
+		InsufficientMaterial,
+		Resignation,
+		Disconnect
+	};
+
+public:
+	ServerGame();
+
+	// plays move (in uci notation) if the game is on and it is legal
+	bool PlayMove(std::string_view move, BoardMove &played);
+
+	bool PlayMove(BoardMove move);
+
+	// color gives up, or left the game
+	void Forfeit(Color color, EndReason reason);
+
+	inline const BoardState &GetState() const { return m_State; }
+
+	inline Result GetResult() const { return m_Result; }
+
+	inline EndReason GetEndReason() const { return m_Reason; }
+
+	inline bool IsOver() const { return m_Result != Ongoing; }
+
+	// moves played so far
+	inline int GetPly() const { return (int) m_Keys.size() - 1; }
+
+	// "1-0", "0-1", "1/2-1/2" or "*"
+	static const char *ToString(Result result);
+
+	// "checkmate", "stalemate", ...
+	static const char *ToString(EndReason reason);
+
+private:
+	void DetectEnd();
+
+	bool IsThreefoldRepetition() const;
+
+	bool IsInsufficientMaterial() const;
+
+private:
+	BoardState m_State;
+	// of every position so far, the last one is the current position
+	std::vector<uint64_t> m_Keys;
+	Result m_Result = Ongoing;
+	EndReason m_Reason = NoReason;
+};
@@ -0,0 +1,79 @@
+#include "Sockets.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+namespace Sockets
+{
+	bool SetNonBlocking(int fd) {
+		int flags = fcntl(fd, F_GETFL, 0);
+		return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+	}
+
+	void SetNoDelay(int fd) {
+		int on = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+	}
+
+	int Listen(uint16_t port, int backlog) {
+		int fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (fd == -1) {
+			std::cout << "socket: " << std::strerror(errno) << std::endl;
+			return -1;
+		}
+
+		int on = 1;
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+		sockaddr_in address = {};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_ANY);
+		address.sin_port = htons(port);
+		if (bind(fd, (sockaddr *) &address, sizeof(address)) == -1 ||
+		    listen(fd, backlog) == -1 || !SetNonBlocking(fd)) {
+			std::cout << "listening on port " << port << ": "
+					  << std::strerror(errno) << std::endl;
+			close(fd);
+			return -1;
+		}
+		return fd;
+	}
+
+	int Connect(const std::string &host, uint16_t port) {
+		sockaddr_in address = {};
+		address.sin_family = AF_INET;
+		address.sin_port = htons(port);
+		if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1)
+			return -1;
+
+		int fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (fd == -1)
+			return -1;
+		SetNoDelay(fd);
+		if (!SetNonBlocking(fd) ||
+		    (connect(fd, (sockaddr *) &address, sizeof(address)) == -1 &&
+		     errno != EINPROGRESS)) {
+			close(fd);
+			return -1;
+		}
+		return fd;
+	}
+
+	void RaiseOpenFileLimit() {
+		rlimit limit;
+		if (getrlimit(RLIMIT_NOFILE, &limit) == 0 &&
+		    limit.rlim_cur < limit.rlim_max) {
+			limit.rlim_cur = limit.rlim_max;
+			setrlimit(RLIMIT_NOFILE, &limit);
+		}
+	}
+} // namespace Sockets
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Small wrappers over the POSIX socket calls shared by the game server and
+// the load tester. Linux only, like the epoll loops using them.
+namespace Sockets
+{
+	bool SetNonBlocking(int fd);
+
+	// disables Nagle, every message is small and latency is what counts
+	void SetNoDelay(int fd);
+
+	// a non-blocking socket listening on port on every interface, -1 (after
+	// printing why) on failure
+	int Listen(uint16_t port, int backlog);
+
+	// a non-blocking socket connecting to host:port, the connection is up
+	// once it is writable. -1 on failure.
+	int Connect(const std::string &host, uint16_t port);
+
+	// lifts the soft limit on open files to the hard limit, thousands of
+	// connections need more than the usual 1024
+	void RaiseOpenFileLimit();
+} // namespace Sockets
@@ -0,0 +1,251 @@
+#include "WebSocket.h"
+
+#include <array>
+#include <cctype>
+
+namespace
+{
+	constexpr const char *Guid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+	inline uint32_t RotateLeft(uint32_t value, int bits) {
+		return (value << bits) | (value >> (32 - bits));
+	}
+
+	// only ever hashes a handshake key, speed doesn't matter
+	std::array<uint8_t, 20> Sha1(std::string_view data) {
+		uint32_t h[5] = {
+			0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0
+		};
+
+		std::string message(data);
+		uint64_t bits = (uint64_t) data.size() * 8;
+		message += '\x80';
+		while (message.size() % 64 != 56) message += '\0';
+		for (int i = 7; i >= 0; i--) message += (char) (bits >> (i * 8));
+
+		for (size_t chunk = 0; chunk < message.size(); chunk += 64) {
+			uint32_t w[80];
+			for (int i = 0; i < 16; i++) {
+				const auto *p = (const uint8_t *) &message[chunk + i * 4];
+				w[i] = (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16 |
+				       (uint32_t) p[2] << 8 | p[3];
+			}
+			for (int i = 16; i < 80; i++)
+				w[i] =
+					RotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+			uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+			for (int i = 0; i < 80; i++) {
+				uint32_t f, k;
+				if (i < 20) {
+					f = (b & c) | (~b & d);
+					k = 0x5A827999;
+				} else if (i < 40) {
+					f = b ^ c ^ d;
+					k = 0x6ED9EBA1;
+				} else if (i < 60) {
+					f = (b & c) | (b & d) | (c & d);
+					k = 0x8F1BBCDC;
+				} else {
+					f = b ^ c ^ d;
+					k = 0xCA62C1D6;
+				}
+				uint32_t temp = RotateLeft(a, 5) + f + e + k + w[i];
+				e = d;
+				d = c;
+				c = RotateLeft(b, 30);
+				b = a;
+				a = temp;
+			}
+			h[0] += a;
+			h[1] += b;
+			h[2] += c;
+			h[3] += d;
+			h[4] += e;
+		}
+
+		std::array<uint8_t, 20> digest;
+		for (int i = 0; i < 20; i++)
+			digest[i] = (uint8_t) (h[i / 4] >> (24 - (i % 4) * 8));
+		return digest;
+	}
+
+	bool EqualsIgnoreCase(std::string_view a, std::string_view b) {
+		if (a.size() != b.size())
+			return false;
+		for (size_t i = 0; i < a.size(); i++)
+			if (std::tolower((unsigned char) a[i]) !=
+			    std::tolower((unsigned char) b[i]))
+				return false;
+		return true;
+	}
+
+	std::string_view Trim(std::string_view str) {
+		while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+			str.remove_prefix(1);
+		while (!str.empty() && (str.back() == ' ' || str.back() == '\t'))
+			str.remove_suffix(1);
+		return str;
+	}
+
+	// the value of header name in the head of an http message, empty if
+	// it has none
+	std::string_view FindHeader(std::string_view head, std::string_view name) {
+		size_t start = head.find("\r\n");
+		while (start != std::string_view::npos && start + 2 < head.size()) {
+			start += 2;
+			size_t end = head.find("\r\n", start);
+			std::string_view line = head.substr(start, end - start);
+			size_t colon = line.find(':');
+			if (colon != std::string_view::npos &&
+			    EqualsIgnoreCase(Trim(line.substr(0, colon)), name))
+				return Trim(line.substr(colon + 1));
+			start = end;
+		}
+		return {};
+	}
+} // namespace
+
+namespace WebSocket
+{
+	std::string AcceptKey(std::string_view key) {
+		std::array<uint8_t, 20> digest = Sha1(std::string(key) + Guid);
+		return Base64(digest.data(), digest.size());
+	}
+
+	long AcceptHandshake(std::string_view data, std::string &response) {
+		size_t end = data.find("\r\n\r\n");
+		if (end == std::string_view::npos)
+			return 0;
+		std::string_view head = data.substr(0, end + 2);
+
+		std::string_view key = FindHeader(head, "Sec-WebSocket-Key");
+		if (head.substr(0, 4) != "GET " || key.empty() ||
+		    !EqualsIgnoreCase(FindHeader(head, "Upgrade"), "websocket"))
+			return -1;
+
+		response = "HTTP/1.1 101 Switching Protocols\r\n"
+				   "Upgrade: websocket\r\n"
+				   "Connection: Upgrade\r\n"
+				   "Sec-WebSocket-Accept: " +
+				   AcceptKey(key) + "\r\n\r\n";
+		return (long) (end + 4);
+	}
+
+	std::string MakeHandshake(std::string_view host, std::string_view key) {
+		return "GET / HTTP/1.1\r\n"
+			   "Host: " +
+			   std::string(host) +
+			   "\r\n"
+			   "Upgrade: websocket\r\n"
+			   "Connection: Upgrade\r\n"
+			   "Sec-WebSocket-Key: " +
+			   std::string(key) +
+			   "\r\n"
+			   "Sec-WebSocket-Version: 13\r\n\r\n";
+	}
+
+	long ReadHandshakeResponse(std::string_view data, std::string_view key) {
+		size_t end = data.find("\r\n\r\n");
+		if (end == std::string_view::npos)
+			return 0;
+		std::string_view head = data.substr(0, end + 2);
+
+		if (head.substr(0, 12) != "HTTP/1.1 101" ||
+		    FindHeader(head, "Sec-WebSocket-Accept") != AcceptKey(key))
+			return -1;
+		return (long) (end + 4);
+	}
+
+	long ParseFrame(std::string_view data, Frame &frame, size_t maxPayload) {
+		if (data.size() < 2)
+			return 0;
+		const auto *bytes = (const uint8_t *) data.data();
+
+		// no extensions were agreed on, so the reserved bits stay clear
+		if (bytes[0] & 0x70)
+			return -1;
+		frame.final = bytes[0] & 0x80;
+		frame.opcode = (Opcode) (bytes[0] & 0x0F);
+
+		bool masked = bytes[1] & 0x80;
+		uint64_t length = bytes[1] & 0x7F;
+		size_t header = 2;
+		if (length >= 126) {
+			int extra = length == 126 ? 2 : 8;
+			if (data.size() < header + extra)
+				return 0;
+			length = 0;
+			for (int i = 0; i < extra; i++)
+				length = length << 8 | bytes[header + i];
+			header += extra;
+		}
+		if (length > maxPayload)
+			return -1;
+
+		uint8_t mask[4] = {0, 0, 0, 0};
+		if (masked) {
+			if (data.size() < header + 4)
+				return 0;
+			for (int i = 0; i < 4; i++) mask[i] = bytes[header + i];
+			header += 4;
+		}
+		if (data.size() < header + length)
+			return 0;
+
+		frame.payload.assign(data.data() + header, length);
+		if (masked)
+			for (size_t i = 0; i < length; i++) frame.payload[i] ^= mask[i & 3];
+		return (long) (header + length);
+	}
+
+	void AppendFrame(
+		std::string &out, Opcode opcode, std::string_view payload,
+		uint32_t mask
+	) {
+		out += (char) (0x80 | opcode);
+		uint8_t maskBit = mask ? 0x80 : 0;
+		if (payload.size() < 126)
+			out += (char) (maskBit | payload.size());
+		else if (payload.size() <= 0xFFFF) {
+			out += (char) (maskBit | 126);
+			out += (char) (payload.size() >> 8);
+			out += (char) payload.size();
+		} else {
+			out += (char) (maskBit | 127);
+			for (int i = 7; i >= 0; i--)
+				out += (char) ((uint64_t) payload.size() >> (i * 8));
+		}
+
+		if (!mask) {
+			out += payload;
+			return;
+		}
+		uint8_t key[4] = {
+			(uint8_t) (mask >> 24), (uint8_t) (mask >> 16),
+			(uint8_t) (mask >> 8), (uint8_t) mask
+		};
+		out.append((const char *) key, 4);
+		for (size_t i = 0; i < payload.size(); i++)
+			out += (char) (payload[i] ^ key[i & 3]);
+	}
+
+	std::string Base64(const uint8_t *data, size_t size) {
+		static constexpr const char *Alphabet =
+			"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+		std::string out;
+		for (size_t i = 0; i < size; i += 3) {
+			uint32_t chunk = (uint32_t) data[i] << 16;
+			if (i + 1 < size)
+				chunk |= (uint32_t) data[i + 1] << 8;
+			if (i + 2 < size)
+				chunk |= data[i + 2];
+			out += Alphabet[chunk >> 18 & 63];
+			out += Alphabet[chunk >> 12 & 63];
+			out += i + 1 < size ? Alphabet[chunk >> 6 & 63] : '=';
+			out += i + 2 < size ? Alphabet[chunk & 63] : '=';
+		}
+		return out;
+	}
+} // namespace WebSocket
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// The parts of RFC 6455 the game server and its load tester need: the
+// opening handshake and unfragmented or fragmented text, ping, pong and
+// close frames. No extensions.
+namespace WebSocket
+{
+	enum Opcode : uint8_t {
+		Continuation = 0,
+		Text = 1,
+		Binary = 2,
+		Close = 8,
+		Ping = 9,
+		Pong = 10
+	};
+
+	struct Frame {
+		Opcode opcode = Text;
+		bool final = true;
+		// unmasked
+		std::string payload;
+	};
+
+	// base64 of the SHA-1 of key and the protocol's GUID, what the server
+	// answers a Sec-WebSocket-Key with
+	std::string AcceptKey(std::string_view key);
+
+	// the handshake request at the front of data: fills response with the
+	// upgrade response and returns the bytes the request took, 0 if it
+	// isn't all there yet, -1 if it isn't a websocket upgrade
+	long AcceptHandshake(std::string_view data, std::string &response);
+
+	// the request a client opens with, key being 16 random bytes in
+	// base64
+	std::string MakeHandshake(std::string_view host, std::string_view key);
+
+	// the response at the front of data, as for AcceptHandshake: -1 unless
+	// it accepts key
+	long ReadHandshakeResponse(std::string_view data, std::string_view key);
+
+	// the frame at the front of data: returns the bytes it took, 0 if it
+	// isn't all there yet, -1 if it is malformed or its payload is longer
+	// than maxPayload
+	long ParseFrame(std::string_view data, Frame &frame, size_t maxPayload);
+
+	// a frame with the whole payload, masked with mask unless it is 0
+	// (servers send unmasked frames, clients masked ones)
+	void AppendFrame(
+		std::string &out, Opcode opcode, std::string_view payload,
+		uint32_t mask = 0
+	);
+
+	std::string Base64(const uint8_t *data, size_t size);
+} // namespace WebSocket
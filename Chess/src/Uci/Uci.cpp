@@ -0,0 +1,626 @@
+#include "Uci.h"
+
+#include "Board/BatchMoveGen.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace
+{
+	constexpr const char *StartFen =
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+	constexpr int BenchDepth = 8;
+
+	const std::vector<std::string> BenchFens = {
+		StartFen,
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+		"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+		"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+		"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - "
+		"0 10",
+		"r1bq1rk1/pp2bppp/2n2n2/3p4/3P4/2NBPN2/PP3PPP/R2QK2R w KQ - 0 9",
+		"8/8/1p2k1p1/3p3p/1p1P1P1P/1P2PK2/8/8 w - - 0 1",
+	};
+
+	// positions with a forced mate and its length, for bench mate
+	const std::vector<std::pair<std::string, int>> BenchMates = {
+		{"r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 "
+		 "4",
+		 1},
+		{"2rr3k/pp3pp1/1nnqbN1p/3pN3/2pP4/2P3Q1/PPB4P/R4RK1 w - - 0 1", 2},
+		{"r1bq2rk/pp3pbp/2p1p1pQ/7P/3P4/2PB1N2/PP3PPR/2KR4 w - - 0 1", 2},
+		{"5k2/6pp/p1qN4/1p1p4/3P4/2PKP2Q/PP3r2/3R4 b - - 0 1", 2},
+		{"r2qkb1r/pp2nppp/3p4/2pNN1B1/2BnP3/3P4/PPP2PPP/R2bK2R w KQkq - 1 1",
+		 2},
+		{"6k1/pp4p1/2p5/2bp4/8/P5Pb/1P3rrP/2BRRN1K b - - 0 1", 2},
+		{"r5rk/5p1p/5R2/4B3/8/8/7P/7K w - - 0 1", 3},
+		{"r6k/6pp/8/6N1/8/1Q6/8/6K1 w - - 0 1", 4},
+		{"8/8/8/4k3/8/8/8/KQ6 w - - 0 1", 10},
+	};
+
+	// bench nnue evaluates every position (and every move from it) this
+	// many times, with a random network if none was loaded
+	constexpr int BenchNnueIterations = 1000;
+	constexpr uint64_t BenchNnueSeed = 1;
+
+	// perft counts from depth 1 up, for bench batch
+	struct PerftCase {
+		std::string fen;
+		std::vector<uint64_t> nodes;
+	};
+	const std::vector<PerftCase> PerftSuite = {
+		{StartFen, {20, 400, 8902, 197281, 4865609}},
+		{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		 {48, 2039, 97862, 4085603}},
+		{"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+		 {14, 191, 2812, 43238, 674624}},
+		{"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+		 {6, 264, 9467, 422333}},
+		{"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+		 {44, 1486, 62379, 2103487}},
+		{"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - "
+		 "0 10",
+		 {46, 2079, 89890, 3894594}},
+	};
+
+	constexpr int BenchBatchDepth = 4;
+
+	// the mate solver gives up on a bench position after this many nodes
+	constexpr uint64_t BenchMateNodes = 10000000;
+
+	// "91.3%"
+	std::string ToPercent(double rate) {
+		std::ostringstream str;
+		str << std::fixed << std::setprecision(1) << rate * 100 << "%";
+		return str.str();
+	}
+
+	std::string ToLower(std::string str) {
+		for (char &c : str) c = (char) std::tolower((unsigned char) c);
+		return str;
+	}
+} // namespace
+
+Uci::Uci() { m_State.ReadFen(StartFen); }
+
+Uci::~Uci() { StopSearch(); }
+
+void Uci::Loop(std::istream &input) {
+	std::string line;
+	while (std::getline(input, line))
+		if (!HandleCommand(line))
+			return;
+
+	// input ran out (a script piping commands in, or the gui went away):
+	// a search with limits gets to finish, an infinite one never would
+	if (!m_Infinite && !m_Pondering && m_SearchThread.joinable())
+		m_SearchThread.join();
+	StopSearch();
+}
+
+bool Uci::HandleCommand(const std::string &line) {
+	std::istringstream args(line);
+	std::string command;
+	if (!(args >> command))
+		return true;
+
+	if (command == "uci")
+		HandleUci();
+	else if (command == "isready")
+		Send("readyok");
+	else if (command == "ucinewgame") {
+		StopSearch();
+		m_Search.GetTable().Clear();
+		m_Mcts.Clear();
+		m_MateSolver.Clear();
+		m_State.ReadFen(StartFen);
+	} else if (command == "position")
+		HandlePosition(args);
+	else if (command == "go")
+		HandleGo(args);
+	else if (command == "stop")
+		StopSearch();
+	else if (command == "ponderhit")
+		HandlePonderHit();
+	else if (command == "setoption")
+		HandleSetOption(args);
+	else if (command == "bench")
+		HandleBench(args);
+	else if (command == "quit") {
+		StopSearch();
+		return false;
+	} else
+		Send("info string unknown command " + command);
+
+	return true;
+}
+
+void Uci::HandleUci() {
+	Send("id name Chess");
+	Send("id author Snailsy5583");
+	Send("option name Hash type spin default 16 min 1 max 65536");
+	Send("option name Threads type spin default 1 min 1 max 256");
+	Send("option name Ponder type check default false");
+	Send(
+		"option name MultiPV type spin default 1 min 1 max " +
+		std::to_string(MaxMultiPv)
+	);
+	Send(
+		"option name SearchMode type combo default AlphaBeta var AlphaBeta "
+		"var MCTS"
+	);
+	Send(
+		"option name MctsLeaf type combo default Static var Static var "
+		"Playout"
+	);
+	Send("option name MctsTree type spin default 64 min 1 max 65536");
+	Send("option name MateHash type spin default 16 min 1 max 65536");
+	Send("option name EvalFile type string default <empty>");
+	Send("option name UseNNUE type check default false");
+	Send("uciok");
+}
+
+void Uci::HandlePosition(std::istringstream &args) {
+	std::string token;
+	args >> token;
+
+	BoardState state;
+	if (token == "startpos") {
+		state.ReadFen(StartFen);
+		args >> token;
+	} else if (token == "fen") {
+		std::string fen;
+		while (args >> token && token != "moves") fen += token + " ";
+		const char *error = nullptr;
+		if (!state.ReadFen(fen, &error)) {
+			Send(std::string("info string invalid fen (") + error + ") " + fen);
+			return;
+		}
+	} else {
+		Send("info string expected startpos or fen");
+		return;
+	}
+
+	// token is "moves" here if there are any
+	while (args >> token) {
+		BoardMove move = ParseMove(state, token);
+		if (move.IsNull()) {
+			Send("info string illegal move " + token);
+			return;
+		}
+		state.MakeMove(move);
+	}
+
+	m_State = state;
+}
+
+void Uci::HandleGo(std::istringstream &args) {
+	StopSearch();
+
+	SearchLimits limits;
+	int64_t time[2] = {0, 0}, increment[2] = {0, 0};
+	bool infinite = false;
+	int mate = 0;
+
+	std::string token;
+	while (args >> token) {
+		if (token == "depth")
+			args >> limits.depth;
+		else if (token == "nodes")
+			args >> limits.nodes;
+		else if (token == "movetime")
+			args >> limits.moveTimeMs;
+		else if (token == "wtime")
+			args >> time[White];
+		else if (token == "btime")
+			args >> time[Black];
+		else if (token == "winc")
+			args >> increment[White];
+		else if (token == "binc")
+			args >> increment[Black];
+		else if (token == "movestogo")
+			args >> limits.movesToGo;
+		else if (token == "infinite")
+			infinite = true;
+		else if (token == "ponder")
+			limits.ponder = true;
+		else if (token == "mate")
+			args >> mate;
+	}
+
+	m_StopRequested = false;
+	if (mate > 0) {
+		// answered as soon as it is proven or disproven
+		m_Infinite = false;
+		m_Pondering = false;
+		ProofLimits proofLimits;
+		proofLimits.nodes = limits.nodes;
+		proofLimits.mateMoves = mate;
+		m_SearchThread =
+			std::thread(&Uci::RunMateSearch, this, m_State, proofLimits);
+		return;
+	}
+
+	Color us = m_State.GetTurn();
+	limits.timeLeftMs = time[us];
+	limits.incrementMs = increment[us];
+	if (infinite)
+		limits = {};
+	limits.depth = std::clamp(limits.depth, 1, Search::MaxPly);
+
+	m_Infinite = infinite;
+	m_Pondering = limits.ponder;
+	m_SearchThread = std::thread(&Uci::RunSearch, this, m_State, limits);
+}
+
+void Uci::HandlePonderHit() {
+	{
+		std::lock_guard<std::mutex> lock(m_StopMutex);
+		if (!m_Pondering)
+			return;
+		m_Pondering = false;
+	}
+	// a search that already ran out of depth is waiting to send its move
+	m_StopSignal.notify_all();
+	m_Search.PonderHit();
+	m_Mcts.PonderHit();
+}
+
+void Uci::HandleSetOption(std::istringstream &args) {
+	// "name <id> [value <x>]", the id may have spaces in it
+	std::string token, name, value;
+	args >> token;
+	while (args >> token && token != "value")
+		name += (name.empty() ? "" : " ") + token;
+	// the rest of the line, file paths may have spaces in them too
+	std::getline(args >> std::ws, value);
+
+	StopSearch();
+
+	name = ToLower(name);
+	// there is nothing to set up for pondering, the gui decides when to
+	if (name == "ponder")
+		return;
+
+	std::string lowerValue = ToLower(value);
+	if (name == "searchmode") {
+		m_UseMcts = lowerValue == "mcts";
+		return;
+	}
+	if (name == "mctsleaf") {
+		m_Mcts.SetEvaluator(
+			lowerValue == "playout" ? &m_PlayoutEvaluator : nullptr
+		);
+		return;
+	}
+	if (name == "evalfile" || name == "usennue") {
+		const char *error = nullptr;
+		if (name == "usennue")
+			m_UseNnue = lowerValue == "true";
+		else if (m_Network.Load(value, &error))
+			Send("info string loaded network " + value);
+		else
+			Send(
+				std::string("info string invalid network (") + error + ") " +
+				value
+			);
+
+		if (m_UseNnue && !m_Network.IsLoaded())
+			Send("info string no network loaded, using the classical eval");
+		m_Search.SetNetwork(m_UseNnue ? &m_Network : nullptr);
+		return;
+	}
+
+	int number = 0;
+	if (!(std::istringstream(value) >> number)) {
+		Send("info string expected a number for " + name);
+		return;
+	}
+
+	if (name == "hash")
+		m_Search.GetTable().Resize(std::clamp(number, 1, 65536));
+	else if (name == "threads") {
+		m_Search.SetThreadCount(std::clamp(number, 1, 256));
+		m_Mcts.SetThreadCount(std::clamp(number, 1, 256));
+	} else if (name == "mctstree")
+		m_Mcts.Resize(std::clamp(number, 1, 65536));
+	else if (name == "matehash")
+		m_MateSolver.Resize(std::clamp(number, 1, 65536));
+	else if (name == "multipv")
+		m_Search.SetMultiPv(std::clamp(number, 1, MaxMultiPv));
+	else
+		Send("info string unknown option " + name);
+}
+
+void Uci::HandleBench(std::istringstream &args) {
+	StopSearch();
+
+	std::string token;
+	args >> token;
+	if (token == "mate") {
+		ProofNumberSearch::BenchMates(BenchMates, BenchMateNodes);
+		return;
+	}
+	if (token == "multipv") {
+		int lines = 4, depth = BenchDepth;
+		args >> lines >> depth;
+		Search search;
+		search.BenchMultiPv(BenchFens, depth, std::clamp(lines, 1, MaxMultiPv));
+		return;
+	}
+	if (token == "smp") {
+		int depth = BenchDepth;
+		args >> depth;
+		m_Search.BenchSpeedup(BenchFens, std::max(depth, 1));
+		return;
+	}
+	if (token == "batch") {
+		int depth = BenchBatchDepth;
+		args >> depth;
+		BenchBatch(std::max(depth, 1));
+		return;
+	}
+	if (token == "params") {
+		int depth = BenchDepth;
+		args >> depth;
+		Search search;
+		search.BenchParameters(BenchFens, std::max(depth, 1));
+		return;
+	}
+	if (token == "nnue") {
+		int iterations = BenchNnueIterations;
+		args >> iterations;
+		if (m_Network.IsLoaded()) {
+			m_Network.Bench(BenchFens, std::max(iterations, 1));
+			return;
+		}
+		// the speed doesn't depend on the weights
+		Send("info string no network loaded, using random weights");
+		auto network = std::make_unique<Nnue>();
+		network->Randomize(BenchNnueSeed);
+		network->Bench(BenchFens, std::max(iterations, 1));
+		return;
+	}
+
+	int depth = BenchDepth;
+	std::istringstream(token) >> depth;
+
+	using namespace std::chrono;
+	auto start = steady_clock::now();
+	uint64_t nodes = 0;
+	double firstMoveCutoffs = 0, pawnHashHits = 0;
+	for (const std::string &fen : BenchFens) {
+		BoardState state;
+		state.ReadFen(fen);
+
+		// every position starts from an empty table so the node count
+		// only depends on the depth
+		m_Search.GetTable().Clear();
+		SearchLimits limits;
+		limits.depth = depth;
+		SearchInfo last;
+		m_Search.Think(state, limits, [&](const SearchInfo &info) {
+			if (info.multiPv <= 1)
+				last = info;
+		});
+		nodes += m_Search.GetNodes();
+		firstMoveCutoffs += last.firstMoveCutoffRate;
+		pawnHashHits += last.pawnHashHitRate;
+	}
+	int64_t ms =
+		duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+	Send("Nodes searched: " + std::to_string(nodes));
+	Send("Time (ms): " + std::to_string(ms));
+	Send(
+		"Nodes/second: " +
+		std::to_string(nodes * 1000 / std::max<int64_t>(ms, 1))
+	);
+	// averaged over the positions
+	Send(
+		"First move cutoffs: " +
+		ToPercent(firstMoveCutoffs / (double) BenchFens.size())
+	);
+	Send(
+		"Pawn hash hits: " + ToPercent(pawnHashHits / (double) BenchFens.size())
+	);
+}
+
+void Uci::BenchBatch(int depth) {
+	using namespace std::chrono;
+
+	std::vector<BoardState> positions;
+	for (const PerftCase &perft : PerftSuite) {
+		positions.emplace_back();
+		positions.back().ReadFen(perft.fen);
+	}
+
+	auto start = steady_clock::now();
+	std::vector<uint64_t> reference;
+	for (BoardState &state : positions)
+		reference.push_back(state.Perft(depth));
+	double referenceSeconds =
+		duration<double>(steady_clock::now() - start).count();
+
+	// every count has to agree with BoardState::Perft, and with the known
+	// count where there is one
+	bool allMatch = true;
+	auto report = [&](const char *name, const std::vector<uint64_t> &nodes,
+	                  double seconds) {
+		uint64_t total = 0;
+		for (size_t i = 0; i < nodes.size(); i++) {
+			total += nodes[i];
+			const std::vector<uint64_t> &known = PerftSuite[i].nodes;
+			bool match = nodes[i] == reference[i] &&
+			             ((size_t) depth > known.size() ||
+			              nodes[i] == known[depth - 1]);
+			if (!match) {
+				allMatch = false;
+				Send(
+					std::string(name) + " mismatch on " + PerftSuite[i].fen +
+					": " + std::to_string(nodes[i])
+				);
+			}
+		}
+		std::string line = name;
+		line += ": " + std::to_string(total) + " nodes, ";
+		line += std::to_string((int64_t) (seconds * 1000)) + " ms, ";
+		line += std::to_string((uint64_t) (total / std::max(seconds, 1e-9)));
+		line += " nodes/s";
+		Send(line);
+	};
+
+	Send(
+		"perft " + std::to_string(depth) + ", " +
+		std::to_string(positions.size()) + " positions"
+	);
+	report("BoardState", reference, referenceSeconds);
+
+	for (bool avx2 : {false, true}) {
+		if (avx2 && !BatchMoveGen::IsAvx2Available()) {
+			Send("avx2 lanes: not supported by this cpu");
+			continue;
+		}
+		start = steady_clock::now();
+		std::vector<uint64_t> nodes =
+			BatchMoveGen::Perft(positions, depth, avx2);
+		report(
+			avx2 ? "avx2 lanes" : "scalar lanes", nodes,
+			duration<double>(steady_clock::now() - start).count()
+		);
+	}
+
+	Send(allMatch ? "all counts match" : "counts differ");
+}
+
+void Uci::StopSearch() {
+	if (!m_SearchThread.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_StopMutex);
+		m_StopRequested = true;
+	}
+	m_StopSignal.notify_all();
+	m_Search.Stop();
+	m_Mcts.Stop();
+	m_MateSolver.Stop();
+	m_SearchThread.join();
+}
+
+void Uci::RunSearch(BoardState state, SearchLimits limits) {
+	SearchInfo last;
+	auto onInfo = [&](const SearchInfo &info) {
+		Send("info " + info.ToString());
+		if (info.multiPv <= 1)
+			last = info;
+		// a stop or ponderhit that came in before the search had started
+		// was cleared by it, pass it on again
+		if (m_StopRequested) {
+			m_Search.Stop();
+			m_Mcts.Stop();
+		} else if (limits.ponder && !m_Pondering) {
+			m_Search.PonderHit();
+			m_Mcts.PonderHit();
+		}
+	};
+
+	BoardMove best;
+	if (m_UseMcts) {
+		best = m_Mcts.Think(state, limits, onInfo);
+		MctsStats stats = m_Mcts.GetStats();
+		Send(
+			"info string playouts " + std::to_string(stats.playouts) +
+			" playouts/s " + std::to_string(stats.playoutsPerSecond) +
+			" tree nodes " + std::to_string(stats.treeNodes) + " reused " +
+			std::to_string(stats.reusedNodes) + " tree memory " +
+			std::to_string(stats.treeBytes / 1024) + " KB of " +
+			std::to_string(stats.capacityBytes / 1024) + " KB"
+		);
+	} else {
+		best = m_Search.Think(state, limits, onInfo);
+		// how good the move ordering and the pawn table were, over the
+		// whole search
+		if (last.depth > 0)
+			Send(
+				"info string first move cutoffs " +
+				ToPercent(last.firstMoveCutoffRate) + " pawn hash hits " +
+				ToPercent(last.pawnHashHitRate)
+			);
+	}
+
+	// an infinite or pondering search that ran out of depth still waits
+	// for stop (or ponderhit)
+	{
+		std::unique_lock<std::mutex> lock(m_StopMutex);
+		m_StopSignal.wait(lock, [&] {
+			return m_StopRequested || (!m_Infinite && !m_Pondering);
+		});
+	}
+
+	if (best.IsNull()) {
+		Send("bestmove 0000");
+		return;
+	}
+
+	// the reply we expect is what the gui should ponder on
+	std::string line = "bestmove " + best.ToString();
+	const std::vector<BoardMove> &pv = last.pv;
+	if (pv.size() >= 2 && pv[0] == best)
+		line.append(" ponder ").append(pv[1].ToString());
+	Send(line);
+}
+
+void Uci::RunMateSearch(BoardState state, ProofLimits limits) {
+	ProofResult result = m_MateSolver.Solve(
+		state, limits, [&](const ProofResult &progress) {
+			Send(
+				"info nodes " + std::to_string(progress.nodes) + " time " +
+				std::to_string(progress.timeMs)
+			);
+			// a stop that came in before Solve had started was cleared by
+			// it, pass it on again
+			if (m_StopRequested)
+				m_MateSolver.Stop();
+		}
+	);
+	if (result.status == ProofResult::Proven) {
+		std::string line = "info score mate " + std::to_string(result.mateIn) +
+		                   " nodes " + std::to_string(result.nodes) +
+		                   " time " + std::to_string(result.timeMs) + " pv";
+		for (BoardMove move : result.line)
+			line.append(" ").append(move.ToString());
+		Send(line);
+	} else
+		Send("info string " + result.ToString());
+
+	if (result.line.empty()) {
+		Send("bestmove 0000");
+		return;
+	}
+	std::string line = "bestmove " + result.line[0].ToString();
+	if (result.line.size() >= 2)
+		line.append(" ponder ").append(result.line[1].ToString());
+	Send(line);
+}
+
+void Uci::Send(const std::string &line) {
+	std::lock_guard<std::mutex> lock(m_OutputMutex);
+	std::cout << line << std::endl;
+}
+
+BoardMove Uci::ParseMove(const BoardState &state, const std::string &str) {
+	MoveList moves;
+	state.GenerateLegalMoves(moves);
+	for (BoardMove move : moves)
+		if (move.ToString() == str)
+			return move;
+	return {};
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <istream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "Board/BoardState.h"
+#include "Search/Mcts.h"
+#include "Search/ProofNumberSearch.h"
+#include "Search/SmpSearch.h"
+
+// UCI front end for the headless engine. Commands are read on the calling
+// thread and searches run on a thread of their own, so that stop, isready
+// and quit are answered while a search is going on.
+class Uci
+{
+public:
+	// the most lines setoption MultiPV takes
+	static constexpr int MaxMultiPv = 256;
+
+public:
+	Uci();
+
+	~Uci();
+
+	// reads commands until quit or the end of the input
+	void Loop(std::istream &input);
+
+	// false once the engine should exit
+	bool HandleCommand(const std::string &line);
+
+private:
+	void HandleUci();
+
+	void HandlePosition(std::istringstream &args);
+
+	void HandleGo(std::istringstream &args);
+
+	void HandleSetOption(std::istringstream &args);
+
+	// the opponent played the move we were pondering on: the search
+	// carries on, now on our own clock
+	void HandlePonderHit();
+
+	// "bench [depth]": searches a fixed set of positions and prints the
+	// total node count and speed. "bench multipv [lines] [depth]" compares
+	// the time and nodes of one line against lines lines instead, "bench
+	// batch [depth]" BatchMoveGen's perft (both lane paths) against
+	// BoardState's on the perft suite, "bench smp [depth]" the
+	// time-to-depth of one thread against setoption Threads, "bench params
+	// [depth]" the time-to-depth with each selective search technique,
+	// "bench mate" the mate solver against the search on a set of mates
+	// and "bench nnue [iterations]" the evaluations per second of the
+	// network.
+	void HandleBench(std::istringstream &args);
+
+	void BenchBatch(int depth);
+
+	// tells a running search to stop and waits for it to report its move
+	void StopSearch();
+
+	void RunSearch(BoardState state, SearchLimits limits);
+
+	// "go mate <moves>": proves or disproves a mate in that many moves
+	// with m_MateSolver
+	void RunMateSearch(BoardState state, ProofLimits limits);
+
+	// one whole line at a time, the search thread writes too
+	void Send(const std::string &line);
+
+	static BoardMove ParseMove(const BoardState &state, const std::string &str);
+
+private:
+	SmpSearch m_Search;
+	BoardState m_State;
+
+	// setoption SearchMode MCTS searches with this instead of m_Search
+	Mcts m_Mcts;
+	MctsPlayoutEvaluator m_PlayoutEvaluator;
+	bool m_UseMcts = false;
+
+	ProofNumberSearch m_MateSolver;
+
+	// setoption EvalFile loads it, UseNNUE has m_Search evaluate with it
+	Nnue m_Network;
+	bool m_UseNnue = false;
+
+	std::thread m_SearchThread;
+	std::atomic<bool> m_StopRequested = false;
+	// "go infinite" holds its bestmove back until stop, "go ponder" until
+	// stop or ponderhit
+	bool m_Infinite = false;
+	std::atomic<bool> m_Pondering = false;
+	std::mutex m_StopMutex;
+	std::condition_variable m_StopSignal;
+
+	std::mutex m_OutputMutex;
+};